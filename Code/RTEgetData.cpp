@@ -36,6 +36,13 @@
 #include "rtedbg.h"
 #include "logger.h"
 #include "platform_compat.h"
+#include "stream.h"
+#include "snapshot_file.h"
+#include "file_writer.h"
+#include "data_transfer.h"
+#include "multi_target.h"
+#include "benchmark.h"
+#include "session_record.h"
 
 
 
@@ -43,15 +50,21 @@
 parameters_t parameters;             // Command line parameters
 uint32_t old_msg_filter;             // Filter value before data logging is disabled
 rtedbg_header_t rtedbg_header;       // Header of the g_rtedbg structure loaded from embedded system
+                                     // (also used by stream.cpp)
 static unsigned* p_rtedbg_structure; // Pointer to memory area allocated for the g_rtedbg structure
-err_code_t last_error;               // Last error detected
+static bool snapshot_valid = false;  // true - the host copy of g_rtedbg is the same as the embedded system memory
+                                     // except for the data logged after the previous transfer (-incremental)
+static uint32_t snapshot_last_index; // Buffer index (last_index) at the previous transfer
+static uint32_t snapshot_rte_cfg;    // Configuration word at the previous transfer
+static uint64_t transfer_time;       // Host time of the last g_rtedbg structure transfer (container file)
+static bool unsaved_snapshot = false; // true - the host copy could not be written after the circular buffer
+                                     // was cleared or restarted (written again with the next transfer command)
+thread_local err_code_t last_error;  // Last error detected (separate for each thread)
 
 
 //*********** Local functions ***********
 static bool allocate_memory_for_g_rtedbg_structure(void);
-static void benchmark_data_transfer(void);
 static int  check_header_info(void);
-static bool data_logging_disabled(void);
 static void delay_before_data_transfer(void);
 static void display_logging_state(clock_t* start_time);
 static void execute_decode_batch_file(void);
@@ -60,17 +73,26 @@ static int  execute_commands_from_file(const char* cmd_file);
 static void execute_commands_from_file_x(char name_start);
 static void internal_command(const char* cmd_text);
 static int  load_rtedbg_structure_header(void);
+static int  prepare_host_copy(void);
 static int  pause_data_logging(void);
 static int  persistent_connection(void);
 static void print_filter_info(void);
 static void print_rtedbg_header_info(void);
 static int  read_memory_block(unsigned char * buffer, uint32_t address, uint32_t size);
+static int  read_rtedbg_structure(void);
+static bool incremental_read_possible(void);
+static int  read_new_data(void);
 static void repeat_start_command_file(void);
 static int  reset_circular_buffer(void);
-static int  save_rtedbg_structure(void);
+static int  read_port_memory(void* connection, unsigned char* buffer, unsigned address, unsigned length);
+static int  write_port_memory(void* connection, const unsigned char* buffer, unsigned address, unsigned length);
+static int  fill_port_memory(void* connection, unsigned address, unsigned pattern, unsigned length);
+static int  read_structure_to_host_copy(void* connection, const rtedbg_header_t* header, uint32_t old_filter);
 static int  set_or_restore_message_filter(void);
 static bool single_shot_active(void);
 static int  single_data_transfer(void);
+static int  save_unsaved_snapshot(void);
+static void keep_unsaved_snapshot(void);
 static void show_help(void);
 static void switch_to_post_mortem_logging(void);
 static void switch_to_single_shot_logging(void);
@@ -93,6 +115,31 @@ int main(int argc, char * argv[])
     clock_t main_start_time = clock_ms();
     process_command_line_parameters(argc, argv);
 
+    if (parameters.list_snapshots)
+    {
+        return (snapshot_file_list(parameters.container_file) == RTE_OK) ? 0 : 1;
+    }
+
+    if (parameters.extract_snapshot != 0)
+    {
+        rez = snapshot_file_extract(parameters.container_file, parameters.extract_snapshot,
+            parameters.bin_file_name);
+        return (rez == RTE_OK) ? 0 : 1;
+    }
+
+    if ((parameters.record_file != NULL) && (session_record_open(parameters.record_file) != RTE_OK))
+    {
+        return 1;
+    }
+
+    if (parameters.targets_file != NULL)
+    {
+        rez = multi_target_collection();
+        session_record_close();
+        printf("\n");
+        return (rez == RTE_OK) ? 0 : 1;
+    }
+
     if (port_open() != RTE_OK)
     {
         return 1;
@@ -102,7 +149,10 @@ int main(int argc, char * argv[])
     
     if (rez != RTE_OK)
     {
+        (void)file_writer_stop();
         port_close();
+        session_record_close();
+        log_flush();
 #ifdef _WIN32
     #ifdef _WIN32
     (void)_fcloseall();
@@ -115,14 +165,36 @@ int main(int argc, char * argv[])
         return 1;
     }
     
-    if (parameters.persistent_connection)
+    if (parameters.benchmark.run)
+    {
+        rez = benchmark_data_transfer();
+        printf("\n");
+    }
+    else if (parameters.stream)
+    {
+        rez = stream_data();
+        printf("\n");
+    }
+    else if (parameters.persistent_connection)
     {
         rez = persistent_connection();
+
+        if (file_writer_stop() != RTE_OK)
+        {
+            rez = RTE_ERROR;
+        }
+
         printf("\n");
     }
     else
     {
         rez = single_data_transfer();
+
+        if (file_writer_stop() != RTE_OK)
+        {
+            rez = RTE_ERROR;
+        }
+
         log_data("\nTotal time: %llu ms\n\n", (long long)(clock_ms() - main_start_time));
 
         if (logging_to_file() && (rez != RTE_OK))
@@ -132,6 +204,8 @@ int main(int argc, char * argv[])
     }
 
     port_close();
+    session_record_close();
+    log_flush();
 #ifdef _WIN32
     (void)_fcloseall();
 #else
@@ -150,6 +224,17 @@ int main(int argc, char * argv[])
 
 static int single_data_transfer(void)
 {
+    if (unsaved_snapshot)
+    {
+        return save_unsaved_snapshot();
+    }
+
+    // The embedded system is not accessed if the data cannot be saved
+    if (file_writer_prepare() != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
     if (logging_to_file())
     {
         printf("\nReading from embedded system... ");
@@ -157,67 +242,80 @@ static int single_data_transfer(void)
 
     port_handle_unexpected_messages();
 
-    // Read the current message filter value before turning off filtering.
-    int rez = port_read_memory((unsigned char*)&old_msg_filter, MESSAGE_FILTER_ADDRESS, 4U);
+    transfer_target_t target;
+    target.connection = NULL;
+    target.start_address = parameters.start_address;
+    target.read_memory = read_port_memory;
+    target.write_memory = write_port_memory;
+    target.fill_memory = fill_port_memory;
+    target.read_structure = read_structure_to_host_copy;
 
-    if (rez != RTE_OK)
-    {
-        return RTE_ERROR;
-    }
+    transfer_result_t result = transfer_rtedbg_structure(&target, &rtedbg_header, &old_msg_filter);
 
-    // Pause data logging if the old message filter is not zero.
-    if (old_msg_filter != 0)
+    if (result == TRANSFER_LOGGING_ENABLED)
     {
-        if (pause_data_logging() != RTE_OK)
+        printf(
+            "\n\nError: At the beginning of the transfer, the message filter was"
+            "\nset to 0 to allow uninterrupted data transfer to the host."
+            "\nAt the end of the data transfer, the message filter is not zero."
+            "\nApparently, the filter was enabled by the firmware. Data "
+            "\ntransferred from the embedded system may be partially corrupted.\n"
+            );
+        log_string("\nThe data logging has already been enabled by the firmware.\n", NULL);
+
+        if (logging_to_file())
         {
-            return RTE_ERROR;
+            printf("\nThe data logging has already been enabled by the firmware.\n");
         }
     }
 
-    if (load_rtedbg_structure_header() != RTE_OK)
+    if ((result != TRANSFER_OK) && (result != TRANSFER_BUFFER_NOT_RESET))
     {
+        snapshot_valid = false;
         return RTE_ERROR;
     }
 
-    if (check_header_info() != RTE_OK)
-    {
-        return RTE_ERROR;
-    }
+    // The data is written after the message filter has been restored, so the logging is
+    // stopped only during the data transfer. If the circular buffer has been cleared or
+    // restarted, the data file is the only copy of the data - wait for the write and keep
+    // the host copy if the data could not be saved.
+    bool buffer_reset = (result == TRANSFER_OK) && (parameters.clear_buffer || single_shot_active());
 
-    if (save_rtedbg_structure() != RTE_OK)
+    if ((file_writer_submit(p_rtedbg_structure, parameters.size, transfer_time) != RTE_OK)
+        || (buffer_reset && (file_writer_wait() != RTE_OK)))
     {
-        (void)set_or_restore_message_filter();
-        return RTE_ERROR;
-    }
+        if (buffer_reset)
+        {
+            keep_unsaved_snapshot();
+        }
 
-    if (logging_to_file())
-    {
-        printf("\nData written to \"%s\"\n", parameters.bin_file_name);
+        return RTE_ERROR;
     }
 
-    if (!data_logging_disabled())
+    if (result == TRANSFER_BUFFER_NOT_RESET)
     {
-        // Data logging has been enabled by the firmware already
-        set_or_restore_message_filter();
-        log_string("\nThe data logging has already been enabled by the firmware.\n", NULL);
+        snapshot_valid = false;
 
         if (logging_to_file())
         {
-            printf("\nThe data logging has already been enabled by the firmware.\n");
+            printf("\nCircular buffer in g_rtedbg structure not properly cleared!");
         }
-
-        return RTE_ERROR;
     }
-
-    if (reset_circular_buffer() != RTE_OK)
+    else if (parameters.clear_buffer || single_shot_active())
     {
-        if (logging_to_file())
+        if (parameters.clear_buffer)
         {
-            printf("\nCircular buffer in g_rtedbg structure not properly cleared!");
+            // Keep the host copy equal to the embedded system memory (-incremental)
+            memset(p_rtedbg_structure + sizeof(rtedbg_header_t) / 4U, 0xFF,
+                parameters.size - sizeof(rtedbg_header_t));
         }
+
+        snapshot_last_index = 0;    // Logging restarted at the start of the circular buffer
     }
 
-    if (set_or_restore_message_filter() != RTE_OK)
+    // The file is written while the program waits for the next command (-p). The decode
+    // batch file needs the data file - wait until it has been written.
+    if ((parameters.decode_file != NULL) && (file_writer_wait() != RTE_OK))
     {
         return RTE_ERROR;
     }
@@ -229,6 +327,61 @@ static int single_data_transfer(void)
 }
 
 
+/***
+ * @brief Keep the host copy of the g_rtedbg structure that could not be written after the
+ *        circular buffer was cleared or restarted, and report the error.
+ */
+
+static void keep_unsaved_snapshot(void)
+{
+    unsaved_snapshot = parameters.persistent_connection;
+    snapshot_valid = false;         // The host copy is not equal to the embedded system memory
+    snapshot_last_index = 0;        // Logging restarted at the start of the circular buffer
+
+    printf("\n************************************************************");
+    log_string("\nThe circular buffer has been cleared or restarted, but the data could not be written to \"%s\".",
+        parameters.bin_file_name);
+
+    if (parameters.persistent_connection)
+    {
+        printf("\nThe data is kept in memory - press Space to write it again.");
+    }
+    else
+    {
+        printf("\nThe data has been lost.");
+    }
+
+    printf("\n************************************************************\n");
+}
+
+
+/***
+ * @brief Write the host copy kept by keep_unsaved_snapshot(). The embedded system is
+ *        not accessed - the data is transferred with the next command.
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - data not written
+ */
+
+static int save_unsaved_snapshot(void)
+{
+    printf("\nWriting the data kept from the previous transfer...");
+
+    if ((file_writer_prepare() != RTE_OK)
+        || (file_writer_submit(p_rtedbg_structure, parameters.size, transfer_time) != RTE_OK)
+        || (file_writer_wait() != RTE_OK))
+    {
+        keep_unsaved_snapshot();
+        return RTE_ERROR;
+    }
+
+    unsaved_snapshot = false;
+    printf("\nPress Space to transfer new data.");
+    execute_decode_batch_file();
+    return RTE_OK;
+}
+
+
 /***
  * @brief Execute the -decode=name batch file if the command line argument was defined.
  */
@@ -269,6 +422,7 @@ static void show_help(void)
         "\n   '1' ... '9' - Start the command file 1.cmd ... 9.cmd. "
         "\n   'B' - Benchmark data transfer speed."
         "\n   'H' - Load the data logging structure header and display information."
+        "\n   'T' - Tune the read packet size for the GDB server (saved to the tuning file)."
         "\n   'L' - Enable / disable logging to the log file."
         "\n   '?' - View an overview of available commands."
         "\n   'Esc' - Exit."
@@ -401,41 +555,6 @@ static void print_filter_info(void)
 }
 
 
-/***
- * @brief Check if the message filter value is zero. It was set to zero before
- *        the data transfer and should remain zero until the transfer is complete.
- *        Report an error if it is not.
- *
- * @return true  - message filter is zero (data logging disabled)
- *         false - message filter could not be checked or is not zero
- */
-
-static bool data_logging_disabled(void)
-{
-    uint32_t message_filter;
-    int rez = port_read_memory((unsigned char*)&message_filter, MESSAGE_FILTER_ADDRESS, 4U);
-
-    if (rez != RTE_OK)
-    {
-        return false;
-    }
-
-    if (message_filter != 0)
-    {
-        printf(
-            "\n\nError: At the beginning of the transfer, the message filter was"
-            "\nset to 0 to allow uninterrupted data transfer to the host."
-            "\nAt the end of the data transfer, the message filter is not zero."
-            "\nApparently, the filter was enabled by the firmware. Data "
-            "\ntransferred from the embedded system may be partially corrupted.\n"
-            );
-        return false;
-    }
-
-    return true;
-}
-
-
 /***
  * @brief Switch to single shot logging mode. The single shot mode must be
  *        enabled in the firmware.
@@ -615,142 +734,6 @@ void set_new_filter_value(const char* filter_value)
 }
 
 
-/***
- * @brief Execute the memory read benchmark.
- * 
- * The measurement is performed for a longer time (20 s) to show the effects of
- * non-real-time Windows scheduling.
- * The results are first written to a data field.
- * Full results are written to the speed_test.csv file and summary to the console.
- */
-
-static void benchmark_data_transfer(void)
-{
-    double max_time = 0;
-    double min_time = 9e99;
-    double time_sum = 0;
-
-    printf("\n\nMeasuring the read memory times...\nWait max. 20 seconds for the benchmark to complete.");
-
-    if (!parameters.debug_mode)
-    {
-        enable_logging(false);    // Disable communication logging to speed up the data transfer
-    }
-
-    if (load_rtedbg_structure_header() != RTE_OK)
-    {
-        enable_logging(true);
-        return;
-    }
-
-    double* time_used = (double*)malloc(BENCHMARK_REPEAT_COUNT * sizeof(double));
-
-    if (time_used == NULL)
-    {
-        log_string("\nMemory allocation failed\n", NULL);
-        enable_logging(true);
-        return;
-    }
-
-    clock_t benchmark_start = clock_ms();
-    size_t measurements;
-
-    for (measurements = 0; measurements < BENCHMARK_REPEAT_COUNT;)
-    {
-        LARGE_INTEGER start_time;
-        start_timer(&start_time);
-
-        int rez = read_memory_block(
-            (unsigned char*)p_rtedbg_structure,
-            parameters.start_address,
-            parameters.size
-            );
-
-        double time = time_elapsed(&start_time);
-        time_used[measurements] = time;
-        time_sum += time;
-
-        if (rez != RTE_OK)
-        {
-            printf("\nBenchmark terminated prematurely - problem with reading from embedded system.");
-            break;
-        }
-
-        measurements++;
-
-        if (kbhit())
-        {
-            printf("\nBenchmark terminated with a keystroke.\n");
-            break;
-        }
-
-        if ((clock_ms() - benchmark_start) > MAX_BENCHMARK_TIME_MS)
-        {
-            break;
-        }
-
-        if (time < min_time)
-        {
-            min_time = time;
-        }
-
-        if (time > max_time)
-        {
-            max_time = time;
-        }
-    }
-
-    if (measurements > 1)
-    {
-        double min_speed = (double)parameters.size / max_time;
-        double avg_speed = (double)parameters.size * (double)measurements / time_sum;
-
-        FILE* report;
-        int rez = fopen_s(&report, "speed_test.csv", "w");
-
-        if (rez != 0)
-        {
-            char error_text[256];
-#ifdef _WIN32
-            (void)_strerror_s(error_text, sizeof(error_text), NULL);
-#else
-            strerror_s(error_text, sizeof(error_text), errno);
-#endif
-            printf("\nCannot create file 'speed_test.csv' - error: %s.\n", error_text);
-        }
-        else
-        {
-            fprintf(report, "Count;Time [ms];Data transfer speed [kB/s]\n");
-
-            for (unsigned i = 0; i < measurements; i++)
-            {
-                fprintf(report, "%4u;%.1f;%.1f\n",
-                    i + 1, time_used[i], (double)parameters.size / time_used[i]);
-            }
-
-            fprintf(report,
-                "\nMinimal time %.1f ms, maximal time %.1f ms, block size %u bytes."
-                "\nMinimal speed %.1f kB/s, average speed: %.1f kB/s.\n",
-                min_time, max_time, parameters.size,
-                min_speed, avg_speed
-            );
-            fclose(report);
-        }
-
-        printf(
-            "\nMinimal time %.1f ms, maximal %.1f ms, block size %u bytes."
-            "\nMinimal speed %.1f kB/s, average speed: %.1f kB/s."
-            "\nSee the 'speed_test.csv' for details.\n",
-            min_time, max_time, parameters.size,
-            min_speed, avg_speed
-        );
-    }
-
-    enable_logging(true);
-    free(time_used);
-}
-
-
 /***
  * @brief  Display the status of logging in the embedded system.
  * 
@@ -856,6 +839,8 @@ static int persistent_connection(void)
     {
         if (!kbhit())
         {
+            // Print the messages of the file writer thread (errors are included)
+            (void)file_writer_check();
             display_logging_state(&start_time);
             continue;
         }
@@ -878,8 +863,12 @@ static int persistent_connection(void)
             load_and_display_rtedbg_structure_header();
             break;
 
+        case 'T':
+            (void)port_tune_packet_size(true);
+            break;
+
         case 'B':
-            benchmark_data_transfer();
+            (void)benchmark_data_transfer();
             break;
 
         case 'S':
@@ -900,6 +889,7 @@ static int persistent_connection(void)
 
         case 'R':
             port_reconnect();
+            snapshot_valid = false;     // The embedded system may have been restarted
             break;
 
         case '0':
@@ -987,6 +977,20 @@ static int load_rtedbg_structure_header(void)
         return RTE_ERROR;
     }
 
+    return prepare_host_copy();
+}
+
+
+/***
+ * @brief Check the g_rtedbg structure size in the header (rtedbg_header) and allocate
+ *        the host copy of the structure. The host copy is reallocated if the size changed.
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - incorrect size or memory not allocated
+ */
+
+static int prepare_host_copy(void)
+{
     unsigned new_size = rtedbg_header.buffer_size * 4U + sizeof(rtedbg_header_t);
 
     if ((parameters.size == 0U)             // Automatically obtain the size of the structure
@@ -1024,6 +1028,8 @@ static int load_rtedbg_structure_header(void)
             log_data("\nLog data structure changed to: %llu", new_size);
             free(p_rtedbg_structure);
             p_rtedbg_structure = NULL;
+            snapshot_valid = false;
+            unsaved_snapshot = false;   // Data kept after a failed file write is lost
         }
     }
 
@@ -1064,95 +1070,191 @@ static int set_or_restore_message_filter(void)
 
 
 /***
- * @brief Read the complete g_rtedbg structure from the embedded system and write it to a file.
- * 
+ * @brief Check the g_rtedbg header and read the complete structure from the embedded
+ *        system to the host copy (called by transfer_rtedbg_structure() while the data
+ *        logging is paused). The header has been loaded to rtedbg_header.
+ *
+ * @param connection  Not used (the active port is used)
+ * @param header      g_rtedbg header (rtedbg_header)
+ * @param old_filter  Message filter value before the data logging was paused
+ *
  * @return RTE_OK    - no error
- *         RTE_ERROR - data not received or file operation failed
+ *         RTE_ERROR - incorrect header or data not received
  */
 
-static int save_rtedbg_structure(void)
+static int read_structure_to_host_copy(void* connection, const rtedbg_header_t* header, uint32_t old_filter)
 {
-    if (p_rtedbg_structure == NULL)
+    (void)connection;
+    (void)header;
+
+    if ((prepare_host_copy() != RTE_OK) || (check_header_info() != RTE_OK))
     {
         return RTE_ERROR;
     }
 
     delay_before_data_transfer();
-    int err = read_memory_block(
-        (unsigned char *)p_rtedbg_structure,
-        parameters.start_address,
-        parameters.size);
+    transfer_time = snapshot_file_time();
 
-    if (err != RTE_OK)
+    if (read_rtedbg_structure() != RTE_OK)
     {
         return RTE_ERROR;
     }
 
-    FILE * bin_file;
-    errno_t rez = fopen_s(&bin_file, parameters.bin_file_name, "wb");
+    // Restore the old message filter (as it was before logging was disabled)
+    p_rtedbg_structure[1] = old_filter;
+    return RTE_OK;
+}
+
 
-    printf("\nWriting data to a file");
+/***
+ * @brief Memory access functions of the active port for transfer_rtedbg_structure().
+ */
 
-    if ((rez != 0) && (errno == EACCES))
+static int read_port_memory(void* connection, unsigned char* buffer, unsigned address, unsigned length)
+{
+    (void)connection;
+    return port_read_memory(buffer, address, length);
+}
+
+
+static int write_port_memory(void* connection, const unsigned char* buffer, unsigned address, unsigned length)
+{
+    (void)connection;
+    return port_write_memory(buffer, address, length);
+}
+
+
+static int fill_port_memory(void* connection, unsigned address, unsigned pattern, unsigned length)
+{
+    (void)connection;
+    return port_fill_memory(address, pattern, length);
+}
+
+
+/***
+ * @brief Read the g_rtedbg structure from the embedded system to the host copy.
+ *        In the incremental mode (-incremental) only the header and the part of the
+ *        circular buffer written since the previous transfer are read if possible.
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - data not received
+ */
+
+static int read_rtedbg_structure(void)
+{
+    int err;
+
+    if (parameters.incremental && snapshot_valid)
     {
-        // Try again. The file may be temporarily locked.
-        for (size_t i = 0; i < 9; i++)
+        // The header shows which part of the circular buffer contains new data
+        err = port_read_memory(
+            (unsigned char *)p_rtedbg_structure, parameters.start_address, sizeof(rtedbg_header_t));
+
+        if (err != RTE_OK)
         {
-            putchar('.');
-            sleep_ms(100);
-            rez = fopen_s(&bin_file, parameters.bin_file_name, "wb");
+            snapshot_valid = false;
+            return RTE_ERROR;
+        }
 
-            if (rez == 0)
-            {
-                break;
-            }
+        if (incremental_read_possible())
+        {
+            err = read_new_data();
+            snapshot_valid = (err == RTE_OK);
+            snapshot_last_index = p_rtedbg_structure[0];
+            return err;
         }
     }
 
-    if (rez != 0)
+    err = read_memory_block(
+        (unsigned char *)p_rtedbg_structure,
+        parameters.start_address,
+        parameters.size);
+
+    snapshot_valid = (err == RTE_OK);
+    snapshot_last_index = p_rtedbg_structure[0];
+    snapshot_rte_cfg = ((rtedbg_header_t *)p_rtedbg_structure)->rte_cfg;
+    return err;
+}
+
+
+/***
+ * @brief Check if only the new data can be read - the header (already read to the
+ *        host copy) must match the header of the previous transfer.
+ *
+ * @return true  - incremental read possible
+ *         false - the complete structure must be read
+ */
+
+static bool incremental_read_possible(void)
+{
+    const rtedbg_header_t * header = (const rtedbg_header_t *)p_rtedbg_structure;
+
+    if ((header->buffer_size != rtedbg_header.buffer_size)
+        || (header->last_index > header->buffer_size)
+        || (snapshot_last_index > header->buffer_size)
+        || ((header->rte_cfg ^ snapshot_rte_cfg) & ~1U))    // Single shot active bit may change
     {
-        printf("\n************************************************************");
-        log_string("\nCould not create file \"%s\"", parameters.bin_file_name);
-        char err_string[256];
-        (void)strerror_s(err_string, sizeof(err_string), errno);
-        log_string(": %s", err_string);
+        log_string("\nHeader changed - reading the complete structure.", NULL);
+        return false;
+    }
 
-        if (logging_to_file())
-        {
-            printf("\nCould not create file \"%s\"", parameters.bin_file_name);
-            printf(": %s", err_string);
-        }
+    return true;
+}
 
-        printf("\n************************************************************\n");
-        return RTE_ERROR;
+
+/***
+ * @brief Read the part of the circular buffer written since the previous transfer.
+ *        The buffer may have wrapped around - the data is then read in two parts.
+ *        The data before the previous buffer index (length of the longest message)
+ *        is read again since a message may not have been complete at the previous
+ *        transfer (a low priority task may have been interrupted while logging).
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - data not received
+ */
+
+static int read_new_data(void)
+{
+    const uint32_t buffer_size = rtedbg_header.buffer_size;
+    const uint32_t new_index = p_rtedbg_structure[0] % buffer_size;
+    uint32_t overlap = RTE_MAX_MSG_BLOCKS * 5U;     // Max. message size [words] incl. format IDs
+    uint32_t new_words = (new_index + buffer_size - (snapshot_last_index % buffer_size)) % buffer_size;
+
+    if ((new_words + overlap) >= buffer_size)
+    {
+        // Read the complete circular buffer
+        overlap = 0;
+        new_words = buffer_size;
     }
 
-    // Restore the old message filter (as it was before logging was disabled)
-    p_rtedbg_structure[1] = old_msg_filter;
-    size_t written = fwrite(p_rtedbg_structure, 1U, parameters.size, bin_file);
+    uint32_t words = new_words + overlap;
+    uint32_t start = (new_index + buffer_size - (words % buffer_size)) % buffer_size;
+    unsigned * circular_buffer = p_rtedbg_structure + sizeof(rtedbg_header_t) / 4U;
+    log_data("\nIncremental transfer: %llu new words", (long long)new_words);
 
-    if (written != parameters.size)
+    while (words > 0)
     {
-        log_string("\nCould not write to the file: %s.", parameters.bin_file_name);
-        char error_text[256];
-#ifdef _WIN32
-        (void)_strerror_s(error_text, sizeof(error_text), NULL);
-#else
-        strerror_s(error_text, sizeof(error_text), errno);
-#endif
-        log_string(" Error: %s", error_text);
-        (void)fclose(bin_file);
+        uint32_t length = words;
 
-        if (logging_to_file())
+        if ((start + length) > buffer_size)
         {
-            printf("\nCould not write to the file: %s.", parameters.bin_file_name);
-            printf(" Error: %s", error_text);
+            length = buffer_size - start;       // Read up to the end of the buffer first
         }
 
-        return RTE_ERROR;
+        int err = read_memory_block(
+            (unsigned char *)&circular_buffer[start],
+            parameters.start_address + sizeof(rtedbg_header_t) + start * 4U,
+            length * 4U);
+
+        if (err != RTE_OK)
+        {
+            return RTE_ERROR;
+        }
+
+        words -= length;
+        start = 0;
     }
 
-    (void)fclose(bin_file);
     return RTE_OK;
 }
 
@@ -1258,31 +1360,29 @@ static int reset_circular_buffer(void)
     if (parameters.clear_buffer)
     {
         unsigned circular_buffer_size = parameters.size - sizeof(rtedbg_header);
-        unsigned char* circular_buffer = (unsigned char*)malloc(circular_buffer_size);
-
-        if (circular_buffer == NULL)
-        {
-            log_string("\nCould not allocate memory buffer.", NULL);
-            return RTE_ERROR;
-        }
-
-        memset(circular_buffer, 0xFFU, circular_buffer_size);
 
         LARGE_INTEGER start_time;
         start_timer(&start_time);
         printf("\nClearing the circular buffer...");
 
-        rez = port_write_memory(
-            circular_buffer,
+        // The fill is done by the target if possible - see port_fill_memory()
+        rez = port_fill_memory(
             parameters.start_address + sizeof(rtedbg_header_t),
+            0xFFFFFFFFU,
             circular_buffer_size);
-        free(circular_buffer);
 
         if (rez != RTE_OK)
         {
+            snapshot_valid = false;
             return RTE_ERROR;
         }
 
+        if (p_rtedbg_structure != NULL)
+        {
+            // Keep the host copy equal to the embedded system memory (-incremental)
+            memset(p_rtedbg_structure + sizeof(rtedbg_header_t) / 4U, 0xFF, circular_buffer_size);
+        }
+
         unsigned block_size = parameters.size - sizeof(rtedbg_header);
         long long speed =
             (long long)((double)block_size / time_elapsed(&start_time));
@@ -1301,6 +1401,8 @@ static int reset_circular_buffer(void)
     if (parameters.clear_buffer || single_shot_active())
     {
         rez = erase_buffer_index();   // Restart logging at the start of the circular buffer
+        snapshot_last_index = 0;
+        snapshot_valid = snapshot_valid && (rez == RTE_OK);
     }
 
     return rez;
@@ -1448,21 +1550,25 @@ static bool allocate_memory_for_g_rtedbg_structure(void)
 
 
 /***
- * @brief How much time [ms] has passed since the CRT initialization during process start.
+ * @brief How much time [ms] has passed since the first call of this function.
+ *        The monotonic clock is used (the clock() function returns the processor
+ *        time on Linux - not the real time).
  * 
  * @return Time elapsed in miliseconds.
  */
 
 long clock_ms(void)
 {
-    clock_t time = clock();
+    static LARGE_INTEGER start_time;
+    static bool timer_started = false;
 
-    if (time == -1)
+    if (!timer_started)
     {
-        return -1;
+        start_timer(&start_time);
+        timer_started = true;
     }
 
-    double time_ms = 0.5 + (double)time / (double)CLOCKS_PER_SEC * 1000.;
+    double time_ms = 0.5 + time_elapsed(&start_time);
 
     if (time_ms > (double)INT32_MAX)
     {
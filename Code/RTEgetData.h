@@ -22,8 +22,24 @@
                                         // Address of the RTE configuration word
 
 #define MAX_DRIVERS 5                   // Maximum number of drivers that should get elevated execution priority
-#define BENCHMARK_REPEAT_COUNT 1000     // Maximum number of data transfers in the benchmark
-#define MAX_BENCHMARK_TIME_MS 20000     // Maximum time for the data transfer benchmark in milliseconds
+#define BENCHMARK_REPEAT_COUNT 1000     // Default number of measurements per benchmark test
+#define BENCHMARK_WARMUP_COUNT   10     // Default number of measurements discarded before each test
+#define MAX_BENCHMARK_COUNT 1000000     // Maximum number of measurements per benchmark test
+#define MAX_BENCHMARK_SIZES       8     // Maximum number of block sizes (-bench_sizes=...)
+#define MAX_BENCHMARK_TIME_MS 20000     // Maximum time for one benchmark test in milliseconds
+#define BENCHMARK_KEY_CHECK_MS  100     // Time between keyboard checks in the interactive benchmark [ms]
+#define BENCHMARK_OUTPUT_NAME "speed_test"  // Default benchmark report file name (.csv and .json are added)
+
+// Streaming mode (-stream) parameters
+#define STREAM_MIN_POLL_INTERVAL    1   // Minimum time between two buffer index reads [ms]
+#define STREAM_MAX_POLL_INTERVAL  200   // Maximum time between two buffer index reads [ms]
+#define STREAM_STATUS_INTERVAL   1000   // Time between two streaming status displays [ms]
+#define STREAM_MAX_ERRORS           3   // Streaming is stopped after this number of consecutive errors
+
+// Multi-target data transfer (-targets=file_name) parameters
+#define MAX_TARGETS                32   // Maximum number of targets in the target list file
+#define MAX_TARGET_LINE_LEN       512   // Maximum length of a line in the target list file
+#define KEYBOARD_POLL_INTERVAL    100   // Time between two keyboard checks [ms]
 
 // COM port communication parameters
 #define COM_RX_BUFFER_SIZE 16384
@@ -61,7 +77,6 @@ typedef enum _err_code
     ERR_SOCKET,                     // Winsock error
     ERR_BAD_MSG_FORMAT,             // Bad message format
     ERR_BAD_MSG_CHECKSUM,           // Bad message checksum
-    ERR_RUN_LENGTH_ENCODING_NOT_IMPLEMENTED,
     ERR_CONNECTION_CLOSED,          // Socket has been closed
     ERR_MSG_NOT_SENT_COMPLETELY,    // The send() function could not send the complete message
     ERR_BAD_RESPONSE,               // Unknown/bad response from GDB
@@ -74,7 +89,7 @@ typedef enum _err_code
 } err_code_t;
 
 
-extern err_code_t last_error;
+extern thread_local err_code_t last_error;
 
 void initialize_data_logging_structure(unsigned cmd_word, unsigned timestamp_frequency);
 void set_new_filter_value(const char* filter_value);
@@ -0,0 +1,610 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    benchmark.cpp
+ * @brief   Data transfer benchmark. The following tests are performed:
+ *            header_read - read of the g_rtedbg structure header (24 bytes),
+ *            read        - read of the blocks defined with -bench_sizes (default: the
+ *                          complete g_rtedbg structure),
+ *            write       - write of the message filter word (the current value is written back),
+ *            round_trip  - write of the message filter word followed by its read.
+ *          The first measurements of each test are discarded (warm-up). The statistics
+ *          (percentiles, jitter and histogram) are written to the console and to the
+ *          JSON report, all measurements to the CSV report.
+ *          The benchmark is started with the 'B' key or with the -benchmark argument.
+ * @author  B. Premzel
+ */
+
+#include "pch.h"
+#include <stdlib.h>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include "RTEgetData.h"
+#include "cmd_line.h"
+#include "rtedbg.h"
+#include "bridge.h"
+#include "logger.h"
+#include "platform_compat.h"
+#include "benchmark.h"
+
+
+typedef enum
+{
+    TEST_HEADER_READ,
+    TEST_READ,
+    TEST_WRITE,
+    TEST_ROUND_TRIP
+} test_type_t;
+
+#define HISTOGRAM_BUCKETS 13U   // Number of limits in histogram_limits[] + 1
+
+// Upper limits of the histogram buckets [ms] - the last bucket contains the longer times
+static const double histogram_limits[HISTOGRAM_BUCKETS - 1U] =
+    { 0.1, 0.2, 0.5, 1, 2, 5, 10, 20, 50, 100, 200, 500 };
+
+typedef struct
+{
+    const char* name;           // Test name
+    unsigned size;              // Number of bytes transferred
+    unsigned count;             // Number of measurements (without warm-up)
+    double min;                 // Times [ms]
+    double max;
+    double mean;
+    double stddev;              // Standard deviation
+    double jitter;              // Mean difference between consecutive measurements
+    double p50;                 // Percentiles
+    double p90;
+    double p99;
+    double p999;
+    unsigned histogram[HISTOGRAM_BUCKETS];
+} test_result_t;
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static unsigned char* block_buffer;     // Buffer for the data read
+static double* times;                   // Measured times of the current test [ms]
+static bool interactive;                // true - benchmark started with the 'B' key
+static bool benchmark_stopped;          // Benchmark stopped with a keystroke or error
+
+
+/*---------------- Local functions ---------------*/
+static unsigned get_rtedbg_structure_size(void);
+static int  run_test(test_type_t type, const char* name, unsigned size, test_result_t* result,
+    FILE* csv_report);
+static int  execute_transfer(test_type_t type, unsigned size, uint32_t* filter);
+static void calculate_statistics(test_result_t* result);
+static double percentile(const double* sorted_times, unsigned count, double percent);
+static int  compare_times(const void* a, const void* b);
+static void print_result(const test_result_t* result);
+static FILE* create_report(const char* extension, char* file_name, size_t name_size);
+static void write_json_string(FILE* file, const char* text);
+static void write_json_report(const test_result_t* results, unsigned number_of_results,
+    unsigned structure_size);
+
+
+/***
+ * @brief Execute the data transfer benchmark. The communication logging is disabled
+ *        during the benchmark (except in the debug mode). The interactive benchmark
+ *        can be stopped with a keystroke.
+ *
+ * @return RTE_OK    - benchmark completed
+ *         RTE_ERROR - data transfer failed or benchmark stopped
+ */
+
+int benchmark_data_transfer(void)
+{
+    const benchmark_pars_t* pars = &parameters.benchmark;
+    interactive = !pars->run;
+    benchmark_stopped = false;
+    unsigned structure_size = get_rtedbg_structure_size();
+
+    if (structure_size == 0)
+    {
+        return RTE_ERROR;
+    }
+
+    unsigned sizes[MAX_BENCHMARK_SIZES];
+    unsigned number_of_sizes = (pars->number_of_sizes > 0) ? pars->number_of_sizes : 1U;
+    unsigned max_size = sizeof(rtedbg_header_t);
+
+    for (unsigned i = 0; i < number_of_sizes; i++)
+    {
+        sizes[i] = ((pars->number_of_sizes == 0) || (pars->sizes[i] == 0)) ? structure_size : pars->sizes[i];
+
+        if (sizes[i] > structure_size)
+        {
+            printf("\nThe block size %u is larger than the g_rtedbg structure (%u bytes).", sizes[i], structure_size);
+            return RTE_ERROR;
+        }
+
+        if (sizes[i] > max_size)
+        {
+            max_size = sizes[i];
+        }
+    }
+
+    block_buffer = (unsigned char*)malloc(max_size);
+    times = (double*)malloc(pars->repeat_count * sizeof(double));
+    char csv_name[256];
+    FILE* csv_report = create_report(".csv", csv_name, sizeof(csv_name));
+
+    if ((block_buffer == NULL) || (times == NULL) || (csv_report == NULL))
+    {
+        if (csv_report != NULL)
+        {
+            printf("\nMemory allocation failed.");
+            (void)fclose(csv_report);
+        }
+
+        free(block_buffer);
+        free(times);
+        return RTE_ERROR;
+    }
+
+    fprintf(csv_report, "Test;Size [bytes];Count;Time [ms];Data transfer speed [kB/s]\n");
+    printf("\n\nMeasuring the data transfer times (%u measurements per test, %u warm-up)...",
+        pars->repeat_count, pars->warmup_count);
+
+    if (interactive)
+    {
+        printf("\nPress any key to stop the benchmark.");
+    }
+
+    if (!parameters.debug_mode)
+    {
+        enable_logging(false);    // Disable communication logging to speed up the data transfer
+    }
+
+    test_result_t results[MAX_BENCHMARK_SIZES + 3U];
+    unsigned number_of_results = 0;
+    int rez = run_test(TEST_HEADER_READ, "header_read", sizeof(rtedbg_header_t),
+        &results[number_of_results++], csv_report);
+
+    for (unsigned i = 0; (i < number_of_sizes) && (rez == RTE_OK); i++)
+    {
+        rez = run_test(TEST_READ, "read", sizes[i], &results[number_of_results++], csv_report);
+    }
+
+    if (rez == RTE_OK)
+    {
+        rez = run_test(TEST_WRITE, "write", 4U, &results[number_of_results++], csv_report);
+    }
+
+    if (rez == RTE_OK)
+    {
+        rez = run_test(TEST_ROUND_TRIP, "round_trip", 8U, &results[number_of_results++], csv_report);
+    }
+
+    enable_logging(true);
+    (void)fclose(csv_report);
+    free(block_buffer);
+    free(times);
+
+    if (rez != RTE_OK)
+    {
+        printf("\nBenchmark terminated prematurely - %s.",
+            benchmark_stopped ? "stopped with a keystroke" : "problem with the data transfer");
+        number_of_results--;    // The last test is not complete
+    }
+
+    if (number_of_results == 0)
+    {
+        return RTE_ERROR;
+    }
+
+    printf("\n\nTimes in ms:\n%-12s %8s %7s %7s %7s %7s %7s %7s %7s %7s %12s",
+        "Test", "Size [B]", "Count", "Min", "p50", "p90", "p99", "p99.9", "Max", "Jitter", "p50 [kB/s]");
+
+    for (unsigned i = 0; i < number_of_results; i++)
+    {
+        print_result(&results[i]);
+    }
+
+    write_json_report(results, number_of_results, structure_size);
+    printf("\nSee the '%s' and '%s.json' files for details.\n", csv_name, parameters.benchmark.output_name);
+    return rez;
+}
+
+
+/***
+ * @brief Read the g_rtedbg structure header to determine the structure size.
+ *
+ * @return Size of the structure [bytes] or 0 if the header is not correct
+ */
+
+static unsigned get_rtedbg_structure_size(void)
+{
+    rtedbg_header_t rtedbg_header;      // Name used by the rtedbg.h macros
+
+    if (port_read_memory((unsigned char*)&rtedbg_header, parameters.start_address, sizeof(rtedbg_header))
+        != RTE_OK)
+    {
+        printf("\nCannot read the g_rtedbg structure header - %s", port_get_error_text());
+        return 0;
+    }
+
+    if ((rtedbg_header.buffer_size > (MAX_BUFFER_SIZE / 4U))
+        || ((rtedbg_header.buffer_size * 4U + sizeof(rtedbg_header_t)) < MIN_BUFFER_SIZE)
+        || (sizeof(rtedbg_header_t) != RTE_HEADER_SIZE))
+    {
+        printf("\nIncorrect g_rtedbg structure header (incorrect address or rte_init() not executed).");
+        return 0;
+    }
+
+    return rtedbg_header.buffer_size * 4U + sizeof(rtedbg_header_t);
+}
+
+
+/***
+ * @brief Execute one benchmark test and write the measurements to the CSV report.
+ *
+ * @param type        Type of data transfer
+ * @param name        Test name
+ * @param size        Number of bytes transferred
+ * @param result      Test statistics
+ * @param csv_report  CSV report file
+ *
+ * @return RTE_OK    - test completed
+ *         RTE_ERROR - data transfer failed or benchmark stopped
+ */
+
+static int run_test(test_type_t type, const char* name, unsigned size, test_result_t* result,
+    FILE* csv_report)
+{
+    const benchmark_pars_t* pars = &parameters.benchmark;
+    uint32_t filter = 0;
+    result->name = name;
+    result->size = size;
+    result->count = 0;
+
+    // The current filter value is written back by the write tests
+    if (((type == TEST_WRITE) || (type == TEST_ROUND_TRIP))
+        && (port_read_memory((unsigned char*)&filter, MESSAGE_FILTER_ADDRESS, 4U) != RTE_OK))
+    {
+        return RTE_ERROR;
+    }
+
+    clock_t test_start = clock_ms();
+    clock_t last_key_check = test_start;
+    unsigned total = pars->warmup_count + pars->repeat_count;
+
+    for (unsigned i = 0; i < total; i++)
+    {
+        LARGE_INTEGER start_time;
+        start_timer(&start_time);
+
+        if (execute_transfer(type, size, &filter) != RTE_OK)
+        {
+            return RTE_ERROR;
+        }
+
+        double time = time_elapsed(&start_time);
+
+        if (i >= pars->warmup_count)
+        {
+            times[result->count++] = time;
+        }
+
+        clock_t now = clock_ms();
+
+        if ((now - test_start) > MAX_BENCHMARK_TIME_MS)
+        {
+            break;
+        }
+
+        // The keyboard is not checked after each transfer - the check takes time
+        if (interactive && ((now - last_key_check) >= BENCHMARK_KEY_CHECK_MS))
+        {
+            last_key_check = now;
+
+            if (kbhit())
+            {
+                (void)getch();
+                benchmark_stopped = true;
+                return RTE_ERROR;
+            }
+        }
+    }
+
+    if (result->count == 0)
+    {
+        return RTE_ERROR;
+    }
+
+    for (unsigned i = 0; i < result->count; i++)
+    {
+        fprintf(csv_report, "%s;%u;%u;%.4f;%.1f\n",
+            name, size, i + 1U, times[i], (times[i] > 0) ? ((double)size / times[i]) : 0);
+    }
+
+    calculate_statistics(result);
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Execute one data transfer of the benchmark test.
+ *
+ * @param type    Type of data transfer
+ * @param size    Number of bytes to read (block read tests)
+ * @param filter  Message filter value written back by the write tests
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - data transfer failed
+ */
+
+static int execute_transfer(test_type_t type, unsigned size, uint32_t* filter)
+{
+    switch (type)
+    {
+        case TEST_HEADER_READ:
+        case TEST_READ:
+            return port_read_memory(block_buffer, parameters.start_address, size);
+
+        case TEST_WRITE:
+            return port_write_memory((const unsigned char*)filter, MESSAGE_FILTER_ADDRESS, 4U);
+
+        case TEST_ROUND_TRIP:
+            if (port_write_memory((const unsigned char*)filter, MESSAGE_FILTER_ADDRESS, 4U) != RTE_OK)
+            {
+                return RTE_ERROR;
+            }
+
+            return port_read_memory((unsigned char*)filter, MESSAGE_FILTER_ADDRESS, 4U);
+
+        default:
+            return RTE_ERROR;
+    }
+}
+
+
+/***
+ * @brief Calculate the statistics of the test from the measured times.
+ *        The jitter is the mean absolute difference between consecutive measurements.
+ *
+ * @param result  Test statistics (the count must be set)
+ */
+
+static void calculate_statistics(test_result_t* result)
+{
+    unsigned count = result->count;
+    double sum = 0;
+    double jitter_sum = 0;
+    memset(result->histogram, 0, sizeof(result->histogram));
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        sum += times[i];
+
+        if (i > 0)
+        {
+            jitter_sum += fabs(times[i] - times[i - 1U]);
+        }
+
+        unsigned bucket = 0;
+
+        while ((bucket < (HISTOGRAM_BUCKETS - 1U)) && (times[i] > histogram_limits[bucket]))
+        {
+            bucket++;
+        }
+
+        result->histogram[bucket]++;
+    }
+
+    result->mean = sum / count;
+    result->jitter = (count > 1U) ? (jitter_sum / (count - 1U)) : 0;
+    double variance = 0;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        variance += (times[i] - result->mean) * (times[i] - result->mean);
+    }
+
+    result->stddev = sqrt(variance / count);
+
+    // The measurements have been written to the report - they can be sorted
+    qsort(times, count, sizeof(double), compare_times);
+    result->min = times[0];
+    result->max = times[count - 1U];
+    result->p50 = percentile(times, count, 50.0);
+    result->p90 = percentile(times, count, 90.0);
+    result->p99 = percentile(times, count, 99.0);
+    result->p999 = percentile(times, count, 99.9);
+}
+
+
+/***
+ * @brief Return the percentile of the sorted times (nearest rank method).
+ *
+ * @param sorted_times  Times sorted in ascending order
+ * @param count         Number of times
+ * @param percent       Percentile (0 ... 100)
+ */
+
+static double percentile(const double* sorted_times, unsigned count, double percent)
+{
+    unsigned rank = (unsigned)ceil(percent / 100.0 * count);
+
+    if (rank < 1U)
+    {
+        rank = 1U;
+    }
+
+    if (rank > count)
+    {
+        rank = count;
+    }
+
+    return sorted_times[rank - 1U];
+}
+
+
+/***
+ * @brief Compare function for qsort() - ascending order of times.
+ */
+
+static int compare_times(const void* a, const void* b)
+{
+    double time_a = *(const double*)a;
+    double time_b = *(const double*)b;
+    return (time_a > time_b) - (time_a < time_b);
+}
+
+
+/***
+ * @brief Print the test statistics to the console.
+ *
+ * @param result  Test statistics
+ */
+
+static void print_result(const test_result_t* result)
+{
+    printf("\n%-12s %8u %7u %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f %12.1f",
+        result->name, result->size, result->count,
+        result->min, result->p50, result->p90, result->p99, result->p999, result->max,
+        result->jitter, (result->p50 > 0) ? ((double)result->size / result->p50) : 0);
+}
+
+
+/***
+ * @brief Create the report file. The name is defined with the -bench_out=name argument
+ *        (default: speed_test) and the extension is added.
+ *
+ * @param extension  File name extension (".csv" or ".json")
+ * @param file_name  Buffer for the complete file name
+ * @param name_size  Size of the buffer
+ *
+ * @return File pointer or NULL if the file cannot be created
+ */
+
+static FILE* create_report(const char* extension, char* file_name, size_t name_size)
+{
+    sprintf_s(file_name, name_size, "%s%s", parameters.benchmark.output_name, extension);
+    FILE* report;
+
+    if (fopen_s(&report, file_name, "w") != 0)
+    {
+        char error_text[256];
+#ifdef _WIN32
+        (void)_strerror_s(error_text, sizeof(error_text), NULL);
+#else
+        strerror_s(error_text, sizeof(error_text), errno);
+#endif
+        printf("\nCannot create file '%s' - error: %s.\n", file_name, error_text);
+        return NULL;
+    }
+
+    return report;
+}
+
+
+/***
+ * @brief Write the string to the JSON file (quoted and escaped).
+ *
+ * @param file  JSON file
+ * @param text  String to write
+ */
+
+static void write_json_string(FILE* file, const char* text)
+{
+    fputc('"', file);
+
+    for (; *text != '\0'; text++)
+    {
+        if ((*text == '"') || (*text == '\\'))
+        {
+            fputc('\\', file);
+        }
+
+        if ((unsigned char)*text >= ' ')
+        {
+            fputc(*text, file);
+        }
+    }
+
+    fputc('"', file);
+}
+
+
+/***
+ * @brief Write the statistics of all tests to the JSON report (machine-readable
+ *        results for the comparison of debug probes and host systems).
+ *
+ * @param results            Test statistics
+ * @param number_of_results  Number of completed tests
+ * @param structure_size     Size of the g_rtedbg structure [bytes]
+ */
+
+static void write_json_report(const test_result_t* results, unsigned number_of_results,
+    unsigned structure_size)
+{
+    char file_name[256];
+    FILE* file = create_report(".json", file_name, sizeof(file_name));
+
+    if (file == NULL)
+    {
+        return;
+    }
+
+    fprintf(file, "{\n  \"version\": \"%s\",\n  \"interface\": ", RTEGETDATA_VERSION);
+
+    if (parameters.active_interface == GDB_PORT)
+    {
+        fprintf(file, "\"gdb\",\n  \"server\": ");
+        write_json_string(file, parameters.ip_address);
+        fprintf(file, ",\n  \"port\": %u", parameters.gdb_port);
+    }
+    else
+    {
+        fprintf(file, "\"com\",\n  \"port\": ");
+        write_json_string(file, parameters.com_port.name);
+        fprintf(file, ",\n  \"baudrate\": %lu", parameters.com_port.baudrate);
+    }
+
+    fprintf(file,
+        ",\n  \"structure_size\": %u,\n  \"repeat_count\": %u,\n  \"warmup_count\": %u,\n  \"tests\": [",
+        structure_size, parameters.benchmark.repeat_count, parameters.benchmark.warmup_count);
+
+    for (unsigned i = 0; i < number_of_results; i++)
+    {
+        const test_result_t* r = &results[i];
+        fprintf(file,
+            "%s\n    {\n      \"name\": \"%s\", \"size\": %u, \"count\": %u,"
+            "\n      \"min_ms\": %.4f, \"max_ms\": %.4f, \"mean_ms\": %.4f, \"stddev_ms\": %.4f, \"jitter_ms\": %.4f,"
+            "\n      \"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, \"p99_9_ms\": %.4f,"
+            "\n      \"rate_p50_kBps\": %.1f, \"rate_mean_kBps\": %.1f,"
+            "\n      \"histogram\": [",
+            (i == 0) ? "" : ",",
+            r->name, r->size, r->count,
+            r->min, r->max, r->mean, r->stddev, r->jitter,
+            r->p50, r->p90, r->p99, r->p999,
+            (r->p50 > 0) ? ((double)r->size / r->p50) : 0,
+            (r->mean > 0) ? ((double)r->size / r->mean) : 0);
+
+        for (unsigned b = 0; b < HISTOGRAM_BUCKETS; b++)
+        {
+            if (b < (HISTOGRAM_BUCKETS - 1U))
+            {
+                fprintf(file, "%s{\"le_ms\": %g, \"count\": %u}", (b == 0) ? "" : ", ",
+                    histogram_limits[b], r->histogram[b]);
+            }
+            else
+            {
+                fprintf(file, ", {\"le_ms\": null, \"count\": %u}", r->histogram[b]);
+            }
+        }
+
+        fprintf(file, "]\n    }");
+    }
+
+    fprintf(file, "\n  ]\n}\n");
+    (void)fclose(file);
+}
+
+/*==== End of file ====*/
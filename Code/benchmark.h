@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    benchmark.h
+ * @author  B. Premzel
+ * @brief   Data transfer benchmark with percentile statistics and CSV/JSON reports.
+ */
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+int benchmark_data_transfer(void);
+
+#endif  // _BENCHMARK_H
+
+/*==== End of file ====*/
@@ -22,10 +22,14 @@
 #include <cstdlib>
 #include "com_lib.h"
 #include "gdb_lib.h"
+#include "gdb_pool.h"
+#include "gdb_tuning.h"
 #include "RTEgetData.h"
 #include "logger.h"
 #include "cmd_line.h"
 #include "bridge.h"
+#include "session_record.h"
+#include "file_writer.h"
 #ifdef _WIN32
     #include <tlhelp32.h>
 #endif
@@ -66,6 +70,12 @@ int port_open(void)
 
                 return RTE_ERROR;
             }
+
+            if (parameters.autotune)
+            {
+                (void)gdb_tune_packet_size(false);
+            }
+
             ret_value = RTE_OK;
             break;
 
@@ -109,6 +119,7 @@ void port_close(void)
     switch (parameters.active_interface)
     {
         case GDB_PORT:
+            gdb_pool_close();
             gdb_detach();
             gdb_socket_cleanup();
             break;
@@ -156,7 +167,8 @@ int port_read_memory(unsigned char* buffer, unsigned int address, unsigned int l
     switch (parameters.active_interface)
     {
         case GDB_PORT:
-            res = gdb_read_memory(buffer, address, length);
+            res = (parameters.connections > 1U) ?
+                gdb_pool_read_memory(buffer, address, length) : gdb_read_memory(buffer, address, length);
             break;
 
         case COM_PORT:
@@ -232,6 +244,61 @@ int port_write_memory(const unsigned char* buffer, unsigned address, unsigned le
 }
 
 
+/**
+ * @brief Fill a memory block in the embedded system with a 32-bit pattern.
+ *        The fill is done by the target (monitor fill command of the GDB server or
+ *        the RTECOM_FILL_RTEDBG command) if possible, so only the command has to be
+ *        transferred and not the complete block. The data is written if the target
+ *        side fill is not available.
+ *
+ * @param address  Starting address in the embedded system's memory (word aligned)
+ * @param pattern  Value written to every word of the block
+ * @param length   Number of bytes to fill (multiple of 4)
+ *
+ * @return RTE_OK    - Operation successful
+ *         RTE_ERROR - Error occurred (check last_error for details)
+ */
+
+int port_fill_memory(unsigned address, unsigned pattern, unsigned length)
+{
+    last_error = ERR_NO_ERROR;
+    int res;
+
+    log_data("\nFilling %llu bytes ", (long long)length);
+    log_data("at address 0x%08llX ", (long long)address);
+    LARGE_INTEGER StartingTime;
+    start_timer(&StartingTime);
+
+    if ((length < 4U) || ((length & 3U) != 0) || ((address & 3U) != 0))
+    {
+        last_error = ERR_BAD_INPUT_DATA;
+        return RTE_ERROR;
+    }
+
+    switch (parameters.active_interface)
+    {
+        case GDB_PORT:
+            res = gdb_fill_memory(address, pattern, length);
+            break;
+
+        case COM_PORT:
+            res = com_fill_memory(address, pattern, length);
+            break;
+
+        default:
+            res = RTE_ERROR;
+            break;
+    }
+
+    if (res == RTE_OK)
+    {
+        log_timing(" (%.1f ms)", &StartingTime);
+    }
+
+    return res;
+}
+
+
 /**
  * @brief Flushes the active interface's communication channel.
  * 
@@ -309,6 +376,32 @@ int port_execute_command(const char* command)
 }
 
 
+/**
+ * @brief Measure the transfer rate for different memory read packet sizes and use
+ *        the fastest one (GDB server only). The result is saved to the tuning file.
+ *
+ * @param measure  true - measure even if the result for the server is in the tuning file
+ *
+ * @return RTE_OK on success, RTE_ERROR otherwise
+ */
+
+int port_tune_packet_size(bool measure)
+{
+    switch (parameters.active_interface)
+    {
+        case GDB_PORT:
+            return gdb_tune_packet_size(measure);
+
+        case COM_PORT:
+            log_string("\nPacket size tuning only possible for a GDB server.%s", "");
+            return RTE_ERROR;
+
+        default:
+            return RTE_ERROR;
+    }
+}
+
+
 /**
  * @brief Reconnects to the previously established communication channel.
  *
@@ -332,6 +425,7 @@ void port_reconnect(void)
     switch (parameters.active_interface)
     {
         case GDB_PORT:
+            gdb_pool_close();
             gdb_socket_cleanup();
 
             if (gdb_connect(parameters.gdb_port) != RTE_OK)
@@ -342,6 +436,11 @@ void port_reconnect(void)
                 }
                 return;
             }
+
+            if (parameters.autotune)
+            {
+                (void)gdb_tune_packet_size(false);
+            }
             break;
 
         case COM_PORT:
@@ -391,11 +490,15 @@ void port_reconnect(void)
 #endif
 void port_close_files_and_exit(void)
 {
+    // The writer thread must be stopped before exit() - otherwise the destruction of the
+    // static writer objects waits for the blocked thread.
+    (void)file_writer_stop();
     decrease_priorities();              // Restore the normal priority
 
     switch (parameters.active_interface)
     {
         case GDB_PORT:
+            gdb_pool_close();
             gdb_detach();
             gdb_socket_cleanup();
             break;
@@ -408,12 +511,16 @@ void port_close_files_and_exit(void)
             break;
     }
 
+    session_record_close();
+
     if (parameters.log_file != NULL)
     {
         printf("\n\nAn error occurred during the transfer of data from the embedded system."
             "\nThe log file contains further details.\n\n");
     }
 
+    log_flush();
+
 #ifdef _WIN32
     (void)_fcloseall();
 #else
@@ -18,6 +18,7 @@ int port_open(void);
 void port_close(void);
 int port_read_memory(unsigned char* buffer, unsigned int address, unsigned int length);
 int port_write_memory(const unsigned char* buffer, unsigned address, unsigned length);
+int port_fill_memory(unsigned address, unsigned pattern, unsigned length);
 void port_flush(void);
 void port_handle_unexpected_messages(void);
 void port_reconnect(void);
@@ -28,6 +29,7 @@ void port_reconnect(void);
 #endif
 void port_display_errors(const char* message);
 int port_execute_command(const char* command);
+int port_tune_packet_size(bool measure);
 const char* port_get_error_text(void);
 
 #endif  // _BRIDGE_H
@@ -67,6 +67,29 @@ static void check_parameters(void)
         show_help_and_exit();
     }
 
+    if ((parameters.list_snapshots || (parameters.extract_snapshot != 0)) && (parameters.container_file == NULL))
+    {
+        printf("The '-extract' parameter requires the container file name (-container=file_name).");
+        show_help_and_exit();
+    }
+
+    if ((parameters.targets_file != NULL)
+        && (parameters.stream || parameters.incremental || (parameters.container_file != NULL)
+            || (parameters.decode_file != NULL) || (parameters.start_cmd_file != NULL)
+            || (parameters.connections > 1U) || parameters.autotune))
+    {
+        printf("The '-targets' parameter cannot be combined with -stream, -incremental, -container,"
+            " -decode, -start, -connections or -autotune.");
+        show_help_and_exit();
+    }
+
+    if (parameters.benchmark.run
+        && (parameters.stream || parameters.persistent_connection || (parameters.targets_file != NULL)))
+    {
+        printf("The '-benchmark' parameter cannot be combined with -stream, -p or -targets.");
+        show_help_and_exit();
+    }
+
     if ((parameters.start_address & 3) != 0)
     {
         printf("The address parameter must be divisible by 4 (32-bit word aligned).");
@@ -143,6 +166,168 @@ static void process_max_msg_length_value(const char* number)
 }
 
 
+/***
+ * @brief Process the read pipeline depth parameter
+ *
+ * This function processes the pipeline depth parameter provided as a string.
+ * It converts the string to an unsigned integer. Value 1 disables the pipelined
+ * memory reads (lock-step mode).
+ * If the conversion fails or the value is out of range, it displays an error message and exits the program.
+ *
+ * @param number Pointer to number string
+ */
+
+static void process_pipeline_depth_value(const char* number)
+{
+    unsigned int n = 0;
+    bool value_ok = false;
+
+    if (sscanf_s(number, "%u", &n) == 1)
+    {
+        if ((n >= 1U) && (n <= MAX_PIPELINE_DEPTH))
+        {
+            parameters.pipeline_depth = n;
+            value_ok = true;
+        }
+    }
+
+    if (!value_ok)
+    {
+        printf("The '-pipeline=xxx' parameter must be >= 1 and <= %u.", MAX_PIPELINE_DEPTH);
+        show_help_and_exit();
+    }
+}
+
+
+/***
+ * @brief Process the number of GDB server connections parameter
+ *
+ * This function processes the number of connections provided as a string.
+ * It converts the string to an unsigned integer. Value 1 disables the parallel
+ * memory reads over additional connections.
+ * If the conversion fails or the value is out of range, it displays an error message and exits the program.
+ *
+ * @param number Pointer to number string
+ */
+
+static void process_connections_value(const char* number)
+{
+    unsigned int n = 0;
+    bool value_ok = false;
+
+    if (sscanf_s(number, "%u", &n) == 1)
+    {
+        if ((n >= 1U) && (n <= MAX_GDB_CONNECTIONS))
+        {
+            parameters.connections = n;
+            value_ok = true;
+        }
+    }
+
+    if (!value_ok)
+    {
+        printf("The '-connections=xxx' parameter must be >= 1 and <= %u.", MAX_GDB_CONNECTIONS);
+        show_help_and_exit();
+    }
+}
+
+
+/***
+ * @brief Process the list of block sizes for the benchmark (-bench_sizes=256,4096,0).
+ *
+ * The sizes must be divisible by 4. Size 0 means the complete g_rtedbg structure.
+ * If the list is not correct, it displays an error message and exits the program.
+ *
+ * @param list Pointer to the comma separated list of sizes
+ */
+
+static void process_benchmark_sizes(const char* list)
+{
+    benchmark_pars_t* pars = &parameters.benchmark;
+    pars->number_of_sizes = 0;
+
+    for (;;)
+    {
+        char* end;
+        unsigned long size = strtoul(list, &end, 0);
+
+        if ((end == list) || ((size & 3U) != 0) || (size > MAX_BUFFER_SIZE)
+            || (pars->number_of_sizes >= MAX_BENCHMARK_SIZES))
+        {
+            printf("The '-bench_sizes=size1,size2,...' parameter must contain up to %u sizes divisible by 4"
+                " (0 = complete g_rtedbg structure).", MAX_BENCHMARK_SIZES);
+            show_help_and_exit();
+        }
+
+        pars->sizes[pars->number_of_sizes++] = (unsigned)size;
+
+        if (*end == '\0')
+        {
+            break;
+        }
+
+        if (*end != ',')
+        {
+            pars->number_of_sizes = MAX_BENCHMARK_SIZES;    // Report the error
+        }
+
+        list = end + 1;
+    }
+}
+
+
+/***
+ * @brief Process a benchmark count parameter (-bench_count=N or -bench_warmup=N).
+ *
+ * If the conversion fails or the value is out of range, it displays an error message and exits the program.
+ *
+ * @param number    Pointer to number string
+ * @param min_value Minimal value allowed
+ * @param name      Parameter name for the error message
+ *
+ * @return Value of the parameter
+ */
+
+static unsigned process_benchmark_count(const char* number, unsigned min_value, const char* name)
+{
+    unsigned int n = 0;
+
+    if ((sscanf_s(number, "%u", &n) != 1) || (n < min_value) || (n > MAX_BENCHMARK_COUNT))
+    {
+        printf("The '%s=xxx' parameter must be >= %u and <= %u.", name, min_value, MAX_BENCHMARK_COUNT);
+        show_help_and_exit();
+    }
+
+    return n;
+}
+
+
+/***
+ * @brief Process the '-extract=N' or '-extract=list' parameter.
+ *
+ * @param value Pointer to the snapshot number string or "list"
+ */
+
+static void process_extract_value(const char* value)
+{
+    unsigned int n = 0;
+
+    if (strcmp(value, "list") == 0)
+    {
+        parameters.list_snapshots = true;
+    }
+    else if ((sscanf_s(value, "%u", &n) == 1) && (n > 0))
+    {
+        parameters.extract_snapshot = n;
+    }
+    else
+    {
+        printf("The '-extract=xxx' parameter must be a snapshot number (1 = first) or 'list'.");
+        show_help_and_exit();
+    }
+}
+
+
 /***
  * @brief Process delay parameter
  *
@@ -342,6 +527,62 @@ static void process_one_cmd_line_parameter(char * parameter)
     {
         process_max_msg_length_value(&parameter[9]);
     }
+    else if (strncmp(parameter, "-pipeline=", 10) == 0)
+    {
+        check_mode(GDB_PORT, parameter);
+        process_pipeline_depth_value(&parameter[10]);
+    }
+    else if (strncmp(parameter, "-connections=", 13) == 0)
+    {
+        check_mode(GDB_PORT, parameter);
+        process_connections_value(&parameter[13]);
+    }
+    else if (strncmp(parameter, "-fill_cmd=", 10) == 0)
+    {
+        check_mode(GDB_PORT, parameter);
+        parameters.fill_command = remove_quotation_marks(&parameter[10]);
+    }
+    else if (strcmp(parameter, "-benchmark") == 0)
+    {
+        parameters.benchmark.run = true;
+    }
+    else if (strncmp(parameter, "-bench_sizes=", 13) == 0)
+    {
+        process_benchmark_sizes(&parameter[13]);
+    }
+    else if (strncmp(parameter, "-bench_count=", 13) == 0)
+    {
+        parameters.benchmark.repeat_count = process_benchmark_count(&parameter[13], 1U, "-bench_count");
+    }
+    else if (strncmp(parameter, "-bench_warmup=", 14) == 0)
+    {
+        parameters.benchmark.warmup_count = process_benchmark_count(&parameter[14], 0, "-bench_warmup");
+    }
+    else if (strncmp(parameter, "-bench_out=", 11) == 0)
+    {
+        parameters.benchmark.output_name = remove_quotation_marks(&parameter[11]);
+    }
+    else if (strcmp(parameter, "-autotune") == 0)
+    {
+        check_mode(GDB_PORT, parameter);
+        parameters.autotune = true;
+    }
+    else if (strncmp(parameter, "-autotune=", 10) == 0)
+    {
+        check_mode(GDB_PORT, parameter);
+        parameters.autotune = true;
+        parameters.tuning_file = remove_quotation_marks(&parameter[10]);
+    }
+    else if (strncmp(parameter, "-record=", 8) == 0)
+    {
+        check_mode(GDB_PORT, parameter);
+        parameters.record_file = remove_quotation_marks(&parameter[8]);
+    }
+    else if (strncmp(parameter, "-targets=", 9) == 0)
+    {
+        check_mode(GDB_PORT, parameter);
+        parameters.targets_file = remove_quotation_marks(&parameter[9]);
+    }
     else if (strncmp(parameter, "-decode=", 8) == 0)
     {
         parameters.decode_file = remove_quotation_marks(&parameter[8]);
@@ -354,6 +595,14 @@ static void process_one_cmd_line_parameter(char * parameter)
     {
         parameters.filter_names = remove_quotation_marks(&parameter[14]);
     }
+    else if (strncmp(parameter, "-container=", 11) == 0)
+    {
+        parameters.container_file = remove_quotation_marks(&parameter[11]);
+    }
+    else if (strncmp(parameter, "-extract=", 9) == 0)
+    {
+        process_extract_value(&parameter[9]);
+    }
     else if (strncmp(parameter, "-driver=", 8) == 0)
     {
         add_driver_name(remove_quotation_marks(&parameter[8]));
@@ -385,11 +634,24 @@ static void process_one_cmd_line_parameter(char * parameter)
     {
         parameters.persistent_connection = true;
     }
+    else if (strcmp(parameter, "-incremental") == 0)
+    {
+        parameters.incremental = true;
+    }
+    else if (strcmp(parameter, "-stream") == 0)
+    {
+        parameters.stream = true;
+    }
     else if (strcmp(parameter, "-single_wire") == 0)
     {
         check_mode(COM_PORT, parameter);
         parameters.com_port.single_wire_communication = true;
     }
+    else if (strcmp(parameter, "-com_pipeline") == 0)
+    {
+        check_mode(COM_PORT, parameter);
+        parameters.com_port.pipelined_reads = true;
+    }
     else if (strncmp(parameter, "-com_timeout=", 13) == 0)
     {
         check_mode(COM_PORT, parameter);
@@ -578,6 +840,9 @@ void process_command_line_parameters(int argc, char* argv[])
 
     parameters.bin_file_name = "data.bin";          // Default binary file name
     parameters.ip_address = DEFAULT_HOST_ADDRESS;
+    parameters.benchmark.repeat_count = BENCHMARK_REPEAT_COUNT;
+    parameters.benchmark.warmup_count = BENCHMARK_WARMUP_COUNT;
+    parameters.benchmark.output_name = BENCHMARK_OUTPUT_NAME;
     process_port_type(argv[1]);
 
     int res = sscanf_s(argv[2], "%x", &parameters.start_address);
@@ -31,9 +31,21 @@ typedef struct com_port_pars
     unsigned char stop_bits;        // ONESTOPBIT (default), ONE5STOPBITS, TWOSTOPBITS 
     unsigned char parity;           // NOPARITY, ODDPARITY, EVENPARITY
     bool single_wire_communication; // true - single wire communication , false - two wire communication
+    bool pipelined_reads;           // true - send the next read command before the current block is received
 } com_port_pars_t;
 
 
+typedef struct benchmark_pars
+{
+    bool run;                       // true - run the benchmark after connecting and exit (-benchmark)
+    unsigned sizes[MAX_BENCHMARK_SIZES];    // Block sizes read in the benchmark (0 = complete g_rtedbg structure)
+    unsigned number_of_sizes;       // Number of block sizes (0 = complete structure only)
+    unsigned repeat_count;          // Number of measurements per test
+    unsigned warmup_count;          // Number of measurements discarded before each test
+    const char* output_name;        // Report file name without the extension
+} benchmark_pars_t;
+
+
 // Command line parameters structure
 typedef struct
 {
@@ -49,6 +61,9 @@ typedef struct
                                     // The port must be defined separately with the -port=xxx parameter
     const char* start_cmd_file;     // File with commands sent to the GDB server after the start
     const char* filter_names;       // File with filter names
+    const char* container_file;     // Container file for multiple snapshots (NULL = not used)
+    unsigned extract_snapshot;      // Snapshot to extract from the container file (0 = none)
+    bool list_snapshots;            // true - list the snapshots in the container file
     unsigned short gdb_port;        // GDB server port number
     const char* driver_names[MAX_DRIVERS];  // Names of drivers with elevated priority
     size_t number_of_drivers;       // Number of drivers with elevated priority
@@ -56,10 +71,20 @@ typedef struct
     bool clear_buffer;              // true - clear the circular buffer after data transfer to host
     bool debug_mode;                // true - log all communication to the log file (debug mode)
     bool persistent_connection;     // true - connect to the GDB server permanently to enable multiple transfers
+    bool incremental;               // true - read only the data logged since the previous data transfer
+    bool stream;                    // true - transfer the data continuously while the embedded system is running
     bool detach;                    // true - send the detach command to the GDB server before disconnecting from the server. 
     rte_port_t active_interface;    // GDB_PORT, COM_PORT
     unsigned max_message_size;      // Custom max. GDB message size the server may send
+    unsigned pipeline_depth;        // Number of read requests in flight (0 = auto, 1 = lock-step mode)
+    unsigned connections;           // Number of GDB server connections for parallel reads (0/1 = one)
+    const char* fill_command;       // Monitor command template for buffer clearing (NULL = default)
+    bool autotune;                  // true - tune the memory read packet size for the GDB server
+    const char* tuning_file;        // Packet size tuning results file (NULL = default)
+    const char* targets_file;       // List of targets for the multi-target data transfer (NULL = single target)
+    const char* record_file;        // Recording of the GDB server communication (NULL = not recorded)
     com_port_pars_t com_port;       // COM port parameters
+    benchmark_pars_t benchmark;     // Benchmark parameters
 } parameters_t;
 
 extern parameters_t parameters;
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file      com_baud_linux.cpp
+ * @brief     Setting of arbitrary serial port baud rates on Linux.
+ *            The termios2 structure (BOTHER) cannot be used in the same compilation
+ *            unit as <termios.h> because the kernel and C library definitions of the
+ *            termios structure collide.
+ * @author    B. Premzel
+ */
+
+#ifndef _WIN32
+
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+#include "RTEgetData.h"
+#include "com_baud_linux.h"
+
+
+/***
+ * @brief Set the input and output baud rate of an open serial port. Any baud rate
+ *        supported by the UART driver can be used (not only the Bxxx constants).
+ *
+ * @param fd               Serial port file descriptor
+ * @param baudrate         Required baud rate
+ * @param actual_baudrate  Baud rate reported by the driver after the change
+ *                         (the driver may round it to the nearest possible value)
+ *
+ * @return RTE_OK    - baud rate set
+ *         RTE_ERROR - the driver does not support the termios2 interface
+ */
+
+int com_set_baud_rate(int fd, unsigned long baudrate, unsigned long* actual_baudrate)
+{
+    struct termios2 tty;
+
+    if (ioctl(fd, TCGETS2, &tty) != 0)
+    {
+        return RTE_ERROR;
+    }
+
+    tty.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tty.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tty.c_ispeed = (speed_t)baudrate;
+    tty.c_ospeed = (speed_t)baudrate;
+
+    if ((ioctl(fd, TCSETS2, &tty) != 0) || (ioctl(fd, TCGETS2, &tty) != 0))
+    {
+        return RTE_ERROR;
+    }
+
+    *actual_baudrate = tty.c_ospeed;
+    return RTE_OK;
+}
+
+#endif  // _WIN32
+
+/*==== End of file ====*/
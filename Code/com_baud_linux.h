@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file      com_baud_linux.h
+ * @brief     Setting of arbitrary serial port baud rates on Linux (termios2).
+ * @author    B. Premzel
+ */
+
+#ifndef _COM_BAUD_LINUX_H
+#define _COM_BAUD_LINUX_H
+
+#ifndef _WIN32
+int com_set_baud_rate(int fd, unsigned long baudrate, unsigned long* actual_baudrate);
+#endif
+
+#endif  // _COM_BAUD_LINUX_H
+
+/*==== End of file ====*/
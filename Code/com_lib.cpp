@@ -18,6 +18,29 @@
 #include "cmd_line.h"
 #include "rte_com.h"
 #include "RTEgetData.h"
+#include "platform_compat.h"
+#include <cstring>
+
+#define COM_NACK    2           // Command refused by the embedded system (NACK received)
+
+//********** Global variables (both platforms) ***********
+static bool block_commands_supported = true;    // false - the embedded system refused a block command
+
+//*********** Local functions (both platforms) ***********
+static void com_resynchronize(void);
+static bool com_purge_and_log(void);
+static int com_receive(unsigned char* buffer, unsigned size, const char* type);
+static int com_send_command(uint8_t command, uint32_t address, uint32_t data);
+static int com_send_packet(uint8_t command, uint32_t address, uint32_t data);
+static int com_read_memory_block(unsigned char* buffer, unsigned int address, unsigned int length);
+static int com_read_memory_pipelined(unsigned char* buffer, unsigned int address, unsigned int length,
+                                     unsigned max_size);
+static int com_send_payload(const unsigned char* data, unsigned length);
+static int com_block_command(uint8_t command, unsigned address, unsigned words,
+                             const unsigned char* payload, unsigned length);
+static int com_write_memory_blocks(const unsigned char* buffer, unsigned address, unsigned length);
+static int com_write_memory_block(const unsigned char* buffer, unsigned address, unsigned length);
+static int check_response(char command);
 
 #ifdef _WIN32
 #include <cstring>
@@ -27,16 +50,9 @@
 HANDLE h_com_port;              // COM port handle
 
 //*********** Local functions ***********
-static void com_resynchronize(void);
 static int com_send(const char* p_data, DWORD length);
-static void com_purge_and_log(void);
 static void com_log_error(DWORD errors);
-static int com_receive(unsigned char* buffer, unsigned length, const char* type);
-static int com_send_command(uint8_t command, uint32_t address, uint32_t data);
-static int com_read_memory_block(unsigned char* buffer, unsigned int address, unsigned int length);
-static int com_write_memory_block(const unsigned char* buffer, unsigned address, unsigned length);
 static bool prepare_com_port_name(const char* input_port, wchar_t* output_buffer, size_t buffer_size);
-static int check_response(char command);
 static void log_api_error(const char* text);
 const char* get_error_message_text(DWORD error_code);
 
@@ -196,6 +212,7 @@ int com_open(void)
     PurgeComm(h_com_port, PURGE_RXCLEAR | PURGE_TXCLEAR);
     log_string("OK", NULL);
     last_error = ERR_NO_ERROR;
+    block_commands_supported = true;   // The firmware may have been changed
 
     return RTE_OK;
 }
@@ -270,13 +287,15 @@ static int com_send(const char* p_data, DWORD length)
  *
  * This function checks for and discards any data that has been received on the
  * COM port but was not expected. It also logs the unexpected data.
+ *
+ * @return true if data has been discarded
  */
 
-static void com_purge_and_log(void)
+static bool com_purge_and_log(void)
 {
     if (h_com_port == INVALID_HANDLE_VALUE)
     {
-        return;
+        return false;
     }
 
     DWORD bytes_read = 0;
@@ -286,13 +305,13 @@ static void com_purge_and_log(void)
     // Clear any error state and get COM status
     if (!ClearCommError(h_com_port, &errors, &com_stat))
     {
-        return;
+        return false;
     }
 
     // Check if there's data available to read
     if (com_stat.cbInQue == 0)
     {
-        return;     // No data available = OK
+        return false;   // No data available = OK
     }
 
     // Limit read size to available data or buffer size and read data
@@ -318,6 +337,7 @@ static void com_purge_and_log(void)
 
     // Clear any error state
     PurgeComm(h_com_port, PURGE_RXABORT | PURGE_RXCLEAR);
+    return true;
 }
 
 
@@ -462,765 +482,1346 @@ static void com_resynchronize(void)
 
 
 /**
- * @brief Sends a command to the embedded system via the COM port.
- *
- * This function sends a command packet to the embedded system, including the
- * command, address, data, and checksum. It also handles the echo in single-wire
- * communication mode.
- *
- * @param command The command to be sent.
- * @param address The address associated with the command.
- * @param data    The data associated with the command.
- * 
- * @return RTE_OK if the command was sent successfully, RTE_ERROR otherwise.
+ * @brief Purge any existing data in the COM port communication buffers.
  */
 
-static int com_send_command(uint8_t command, uint32_t address, uint32_t data)
+void com_flush(void)
 {
-    rtecom_send_data_t message = { 0 };
-    message.command = command;
-    message.address = address;
-    message.data = data;            // Write = data, Read = length
-
-    // Calculate the checksum
-    uint8_t checksum = RTECOM_CHECKSUM;
-    uint8_t *msg = (uint8_t *)&message.address;
-
-    for (int i = 0; i < 8; i++)
-    {
-        checksum ^= *msg++;
-    }
-
-    message.checksum = checksum;
-    com_purge_and_log();            // There should be no data in the input buffer
-    int result = com_send((char*)&message.command, RTECOM_SEND_PACKET_LEN);
-
-    if (result != RTE_OK)
-    {
-        return RTE_ERROR;
-    }
-
-    // In single-wire communication, it also receives all characters sent.
-    // The echo must be the same as the data sent.
-    if (parameters.com_port.single_wire_communication)
+    if (h_com_port != INVALID_HANDLE_VALUE)
     {
-        unsigned char echo[RTECOM_SEND_PACKET_LEN] = { 0 };
-        result = com_receive(echo, RTECOM_SEND_PACKET_LEN, "Echo");
-
-        if (result != RTE_OK)
-        {
-            log_string("Bad or no echo", NULL);
-            com_flush();
-            return RTE_ERROR;
-        }
-
-        if (memcmp(echo, &message.command, RTECOM_SEND_PACKET_LEN) != 0)
-        {
-            Sleep(COM_BAD_RESPONSE_DELAY);
-            log_string("\nBad echo  ", NULL);
-            com_flush();
-            return RTE_ERROR;
-        }
+        PurgeComm(h_com_port, PURGE_RXCLEAR | PURGE_TXCLEAR);
     }
-
-    return  RTE_OK;
 }
 
 
 /**
- * @brief Reads a block of memory from the embedded system via the COM port.
- *
- * This function sends a read command to the embedded system and then receives
- * the requested memory block.
+ * @brief Logs the last Windows API error with context text.
  *
- * @param buffer  A pointer to the buffer where the received data will be stored.
- * @param address The starting address of the memory block to be read.
- * @param length  The length of the memory block to be read in bytes.
- * 
- * @return RTE_OK if the memory block was read successfully, RTE_ERROR otherwise.
+ * @param text Context message to print before the error.
  */
 
-static int com_read_memory_block(unsigned char* buffer, unsigned int address, unsigned int length)
+static void log_api_error(const char* text)
 {
-    if ((length > RTECOM_MAX_RECV_LEN) || (length == 0U))
+    DWORD error = GetLastError();
+
+    if (!error || (text == NULL))
     {
-        return RTE_ERROR;
+        return;
     }
 
-    int rez = com_send_command(RTECOM_READ_RTEDBG, address, length);
+    log_string("\n%s: ", text);
+    const char* error_text = get_error_message_text(error);
 
-    if (rez != RTE_OK)
+    if (error_text == NULL)
     {
-        return RTE_ERROR;
+        log_string("unknown error ", NULL);
+    }
+    else
+    {
+        log_string("%s", error_text);
     }
-
-    return com_receive(buffer, length, "Recv");
 }
 
 
 /**
- * @brief Reads memory from the embedded system via the COM port.
+ * @brief Formats an error message for the specified error code.
  *
- * This function reads memory from the embedded system in blocks, handling
- * cases where the requested length exceeds the maximum receive length.
+ * This function formats an error message for the given error code using
+ * FormatMessage() to retrieve the system error message. The message is stored
+ * in a static buffer, which means it will be overwritten with each call.
  *
- * @param buffer A pointer to the buffer where the received data will be stored.
- * @param address The starting address of the memory to be read.
- * @param length The total length of the memory to be read in bytes.
+ * @param error_code The error code (typically from GetLastError())
  * 
- * @return RTE_OK if the memory was read successfully, RTE_ERROR otherwise.
+ * @return Pointer to a static buffer containing the formatted error message
  */
 
-int com_read_memory(unsigned char* buffer, unsigned int address, unsigned int length)
+const char* get_error_message_text(DWORD error_code)
 {
-    // Maximal packet length while receiving data
-    unsigned max_size = min(parameters.max_message_size, RTECOM_MAX_RECV_LEN);
-    unsigned size = 0;
+    // Static buffer to hold the error message
+    static char error_buffer[512];
 
-    for (; length > 0; length -= size)
+    DWORD length;
+    LPVOID temp_buffer = NULL;
+
+    // Get the error message from the system
+    length = FormatMessageA(
+        FORMAT_MESSAGE_ALLOCATE_BUFFER |
+        FORMAT_MESSAGE_FROM_SYSTEM |
+        FORMAT_MESSAGE_IGNORE_INSERTS,
+        NULL,
+        error_code,
+        MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
+        (LPSTR)&temp_buffer,
+        0, NULL);
+
+    if (length == 0)
     {
-        size = length > max_size ? max_size : length;
-        int rez = com_read_memory_block(buffer, address, size);
-        buffer += size;
-        address += size;
+        // FormatMessage failed
+        snprintf(error_buffer, sizeof(error_buffer),
+            "Unknown error code: %lu (0x%08lX)", error_code, error_code);
+    }
+    else
+    {
+        // Copy the message to the static buffer
+        // Trim trailing whitespace and newlines
+        while (length > 0 && isspace(((LPSTR)temp_buffer)[length - 1]))
+        {
+            length--;
+        }
 
-        if (rez != RTE_OK)
+        if (length >= sizeof(error_buffer))
         {
-            com_resynchronize();
-            return RTE_ERROR;
+            length = sizeof(error_buffer) - 1;
         }
+
+        memcpy(error_buffer, temp_buffer, length);
+        error_buffer[length] = '\0';
+
+        // Free the buffer allocated by FormatMessage
+        LocalFree(temp_buffer);
     }
 
-    return RTE_OK;
+    return error_buffer;
 }
 
+#else  // Linux implementation
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+#include <errno.h>
+#include <cstring>
+#include "platform_compat.h"
+#include "com_baud_linux.h"
+
+//********** Global variables ***********
+static int serial_fd = -1;              // Serial port file descriptor
+static struct serial_icounter_struct line_counters;  // Line error counters after the last check
+static bool line_counters_valid = false;    // false - counters not supported by the driver (e.g. pty)
+
+//*********** Local functions ***********
+static speed_t get_baud_rate(int baud);
+static int set_serial_attributes(int fd);
+static int set_exact_baud_rate(int fd, speed_t speed);
+static void set_low_latency(int fd);
+static void log_linux_error(const char* operation);
+static int wait_for_serial_port(short events, long timeout);
+static int com_send(const char* p_data, unsigned length);
+static void com_check_line_errors(void);
+
 
 /**
- * @brief Writes a block of memory to the embedded system via the COM port.
+ * @brief Convert integer baud rate to speed_t constant
  *
- * This function sends a write command to the embedded system to write a block
- * of memory. The address of the data transferred to the embedded system is
- * that of a 32-bit word, rather than a byte. The current protocol implementation
- * only allows one word to be sent per data packet.
+ * @param baud Baud rate
  *
- * @param buffer A pointer to the buffer containing the data to be written.
- * @param address The starting address of the memory to be written.
- * @param length The length of the memory block to be written in bytes.
- * 
- * @return RTE_OK if the memory block was written successfully, RTE_ERROR otherwise.
+ * @return speed_t constant (B0 if there is no constant for the baud rate)
  */
 
-static int com_write_memory_block(const unsigned char* buffer, unsigned address, unsigned length)
+static speed_t get_baud_rate(int baud)
 {
-    if ((length != 4U) || (address & 3U))
-    {
-        return RTE_ERROR;
-    }
-
-    // Address is address of word to be written and not byte (divide by 4)
-    int ret = com_send_command(RTECOM_WRITE_RTEDBG, address / 4U, *((uint32_t *)buffer));
-
-    if (ret != RTE_OK)
+    switch (baud)
     {
-        return RTE_ERROR;
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 500000:  return B500000;
+        case 576000:  return B576000;
+        case 921600:  return B921600;
+        case 1000000: return B1000000;
+        case 1152000: return B1152000;
+        case 1500000: return B1500000;
+        case 2000000: return B2000000;
+        case 2500000: return B2500000;
+        case 3000000: return B3000000;
+        case 3500000: return B3500000;
+        case 4000000: return B4000000;
+        default:      return B0;    // Set with set_exact_baud_rate()
     }
-
-    return check_response(RTECOM_WRITE_RTEDBG);
 }
 
 
 /**
- * @brief Writes memory to the embedded system via the COM port.
+ * @brief Configure the serial port attributes (raw mode, baud rate, parity, stop bits).
+ *        The port is used in the non-blocking mode - poll() is used to wait for data.
  *
- * This function writes memory to the embedded system in blocks of 4 bytes,
- * ensuring that the total length is a multiple of 4.
+ * @param fd Serial port file descriptor
  *
- * @param buffer A pointer to the buffer containing the data to be written.
- * @param address The starting address of the memory to be written.
- * @param length The total length of the memory to be written in bytes.
- * 
- * @return RTE_OK if the memory was written successfully, RTE_ERROR otherwise.
+ * @return RTE_OK if the port was configured successfully, RTE_ERROR otherwise.
  */
 
-int com_write_memory(const unsigned char* buffer, unsigned address, unsigned length)
+static int set_serial_attributes(int fd)
 {
-    if (length & 3U)
-    {
-        log_data("\nWrite memory length (%u) must be divisible by 4.", length);
-        return RTE_ERROR;
-    }
+    struct termios tty;
 
-    if (address & 3U)
+    if (tcgetattr(fd, &tty) != 0)
     {
-        log_data("\nWrite address length (0x%X) must be divisible by 4.", address);
+        log_linux_error("tcgetattr");
         return RTE_ERROR;
     }
 
-    clock_t last_time = clock();
+    // Set a standard baud rate first - the exact baud rate is set by set_exact_baud_rate()
+    speed_t speed = get_baud_rate((int)parameters.com_port.baudrate);
+    cfsetospeed(&tty, (speed != B0) ? speed : B38400);
+    cfsetispeed(&tty, (speed != B0) ? speed : B38400);
 
-    for (unsigned i = 0U; i < length; i += 4U)
-    {
-        if (length > 4)
-        {
-            clock_t new_time = clock();
+    // Configure for raw mode
+    tty.c_cflag &= ~PARENB;         // No parity
+    tty.c_cflag &= ~CSTOPB;         // One stop bit
+    tty.c_cflag &= ~CSIZE;          // Clear data size bits
+    tty.c_cflag |= CS8;             // 8 data bits
+    tty.c_cflag &= ~CRTSCTS;        // No hardware flow control
+    tty.c_cflag |= CREAD | CLOCAL;  // Enable receiver, ignore modem control lines
 
-            if ((new_time - last_time) > 99)
-            {
-                putchar('.');
-                last_time = new_time;
-            }
-        }
+    // Configure parity based on parameters
+    switch (parameters.com_port.parity)
+    {
+        case ODDPARITY:
+            tty.c_cflag |= PARENB | PARODD;
+            break;
 
-        int ret = com_write_memory_block(buffer, address, 4U);
+        case EVENPARITY:
+            tty.c_cflag |= PARENB;
+            tty.c_cflag &= ~PARODD;
+            break;
 
-        if (ret != RTE_OK)
-        {
-            com_resynchronize();
-            return RTE_ERROR;
-        }
-        address += 4U;
-        buffer += 4U;
+        case NOPARITY:
+        default:
+            tty.c_cflag &= ~PARENB;
+            break;
     }
 
-    return RTE_OK;
-}
+    // Configure stop bits
+    if (parameters.com_port.stop_bits == TWOSTOPBITS)
+    {
+        tty.c_cflag |= CSTOPB;
+    }
+    else
+    {
+        tty.c_cflag &= ~CSTOPB;
+    }
 
+    // Input flags - turn off input processing
+    tty.c_iflag &= ~(IXON | IXOFF | IXANY); // Turn off s/w flow ctrl
+    tty.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL); // Disable any special handling of received bytes
 
-/**
- * @brief Purge any existing data in the COM port communication buffers.
- */
+    // Output flags - turn off output processing
+    tty.c_oflag &= ~OPOST;  // Prevent special interpretation of output bytes (e.g. newline chars)
+    tty.c_oflag &= ~ONLCR;  // Prevent conversion of newline to carriage return/line feed
 
-void com_flush(void)
-{
-    if (h_com_port != INVALID_HANDLE_VALUE)
+    // read() returns immediately - the receive timeouts are handled with poll()
+    tty.c_cc[VTIME] = 0;
+    tty.c_cc[VMIN] = 0;
+
+    // Local flags
+    tty.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG); // Raw mode
+
+    if (tcsetattr(fd, TCSANOW, &tty) != 0)
     {
-        PurgeComm(h_com_port, PURGE_RXCLEAR | PURGE_TXCLEAR);
+        log_linux_error("tcsetattr");
+        return RTE_ERROR;
     }
+
+    return set_exact_baud_rate(fd, speed);
 }
 
 
 /**
- * @brief Wait for response from embedded system
- * 
- * The embedded system returns ACK if the index is within the g_rtedbg structure
- * and the command (e.g. data write) has been performed, otherwise NACK (see below).
- * No response is sent if the command was not received correctly (e.g. bad checksum).
- * 
- * @param commmand - command sent to embedded system is response if the data/address
- *                   value is not correct (NACK value).
- * 
- * @return RTE_OK if embedded system responded with ACK, RTE_ERROR otherwise.
+ * @brief Set the baud rate with the termios2 interface (any integer baud rate supported
+ *        by the UART driver) and check the baud rate reported back by the driver.
+ *
+ * @param fd    Serial port file descriptor
+ * @param speed Standard baud rate constant already set with tcsetattr() (B0 - none)
+ *
+ * @return RTE_OK if the baud rate has been set, RTE_ERROR otherwise.
  */
 
-static int check_response(char command)
+static int set_exact_baud_rate(int fd, speed_t speed)
 {
-    int ret_val = RTE_ERROR;
-    clock_t recv_start_time = clock();
+    unsigned long requested = parameters.com_port.baudrate;
+    unsigned long actual = 0;
 
-    if (h_com_port == INVALID_HANDLE_VALUE)
+    if (com_set_baud_rate(fd, requested, &actual) != RTE_OK)
     {
+        if (speed != B0)
+        {
+            return RTE_OK;      // The standard baud rate has been set by tcsetattr()
+        }
+
+        log_data("\nBaud rate %llu is not supported by the serial port driver. ", (long long)requested);
         return RTE_ERROR;
     }
 
-    DWORD bytes_read = 0;
-    unsigned char data;
-    bool success = ReadFile(h_com_port, &data, 1, &bytes_read, NULL);
+    unsigned long difference = (actual > requested) ? (actual - requested) : (requested - actual);
 
-    if (success)
+    // The UART baud rate error must be below approx. 2%
+    if ((difference * 50U) > requested)
     {
-        if (bytes_read > 0)
-        {
-            if (data == RTECOM_ACK)
-            {
-                ret_val = RTE_OK;
-            }
-            else if (data == command)
-            {
-                log_string(" NACK received ", NULL);
-            }
-            else
-            {
-                log_data(" Bad response 0x%02X ", data);
-                com_purge_and_log();
-            }
-        }
-        else
-        {
-            last_error = ERR_RCV_TIMEOUT;
-            log_data(" timeout after %u ms ", clock() - recv_start_time);
-        }
+        log_data("\nBaud rate %llu requested", (long long)requested);
+        log_data(", the serial port driver set %llu. ", (long long)actual);
+        return RTE_ERROR;
     }
-    else
+
+    if (difference != 0)
     {
-        log_api_error("Read from COM port error");
+        log_data("(baud rate %llu) ", (long long)actual);
     }
 
-    return ret_val;
+    return RTE_OK;
 }
 
 
 /**
- * @brief Returns a pointer to the short error message text.
- *        Trailing spaces are used to overwrite previous message(s).
+ * @brief Enable the low latency mode of the serial port driver if it is available
+ *        (the received data is passed to the application without delay).
  *
- * @return Text message to show in case of error.
+ * @param fd Serial port file descriptor
  */
 
-const char* com_get_error_text(void)
+static void set_low_latency(int fd)
 {
-    switch (last_error)
-    {
-        case ERR_COM_CANNOT_OPEN_PORT:
-            return "COM port closed           ";
-
-        case ERR_COM_BUFFER_OVERRUN:
-            return "buffer overrun            ";
+    struct serial_struct serial;
 
-        case ERR_RCV_TIMEOUT:
-            return "receive timeout           ";
+    if ((ioctl(fd, TIOCGSERIAL, &serial) == 0) && ((serial.flags & ASYNC_LOW_LATENCY) == 0))
+    {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        (void)ioctl(fd, TIOCSSERIAL, &serial);
+    }
+}
 
-        case ERR_COM_RECEIVE:
-            return "receive error             ";
 
-        case ERR_SEND_TIMEOUT:
-            return "send timeout              ";
+/**
+ * @brief Log Linux system error with context
+ *
+ * @param operation Name of the operation that failed
+ */
 
-        default:
-            return "                          ";
-    }
+static void log_linux_error(const char* operation)
+{
+    char error_text[256];
+    snprintf(error_text, sizeof(error_text), "\n%s failed: %s", operation, strerror(errno));
+    log_string(error_text, NULL);
 }
 
 
 /**
- * @brief Display error message if the logging is redirected to a log file.
+ * @brief Open and configure the serial port.
+ *        COM1 -> /dev/ttyS0, COM2 -> /dev/ttyS1, etc. Device paths (e.g. /dev/ttyUSB0)
+ *        and device names without the /dev/ prefix are also supported.
  *
- * @param message Text message to show in case of error.
+ * @return RTE_OK if the port was opened and configured successfully, RTE_ERROR otherwise.
  */
 
-void com_display_errors(const char* message)
+int com_open(void)
 {
-    if (!logging_to_file() || (last_error == 0))
-    {
-        printf("\n");
-        return;
-    }
+    char device_path[64];
+    last_error = ERR_COM_CANNOT_OPEN_PORT;
 
-    printf(message);
-    switch (last_error)
+    if (strncmp(parameters.com_port.name, "COM", 3) == 0)
     {
-        case ERR_COM_CANNOT_OPEN_PORT:
-            printf("cannot open port %s", parameters.com_port.name);
-            break;
-
-        case ERR_COM_BUFFER_OVERRUN:
-            printf("buffer overrun");
-            break;
+        int port_num = atoi(&parameters.com_port.name[3]);
 
-        case ERR_RCV_TIMEOUT:
-            printf("receive timeoout");
-            break;
+        if (port_num <= 0)
+        {
+            log_string("Invalid COM port number", NULL);
+            return RTE_ERROR;
+        }
 
-        case ERR_COM_RECEIVE:
-            printf("receive error");
-            break;
+        snprintf(device_path, sizeof(device_path), "/dev/ttyS%d", port_num - 1);
+    }
+    else if (parameters.com_port.name[0] == '/')
+    {
+        strncpy(device_path, parameters.com_port.name, sizeof(device_path) - 1);
+        device_path[sizeof(device_path) - 1] = '\0';
+    }
+    else
+    {
+        snprintf(device_path, sizeof(device_path), "/dev/%s", parameters.com_port.name);
+    }
 
-        case ERR_SEND_TIMEOUT:
-            printf("send timeout");
-            break;
+    log_string("Open port %s: ", device_path);
+    serial_fd = open(device_path, O_RDWR | O_NOCTTY | O_NONBLOCK);
 
-        case ERR_BAD_INPUT_DATA:
-            printf("bad function parameter");
-            break;
+    if (serial_fd < 0)
+    {
+        log_linux_error("open");
+        return RTE_ERROR;
+    }
 
-        default:
-            break;
+    if (set_serial_attributes(serial_fd) != RTE_OK)
+    {
+        close(serial_fd);
+        serial_fd = -1;
+        return RTE_ERROR;
     }
 
+    set_low_latency(serial_fd);
+
+    // Purge any existing data in the buffers
+    tcflush(serial_fd, TCIOFLUSH);
+    line_counters_valid = (ioctl(serial_fd, TIOCGICOUNT, &line_counters) == 0);
+    log_string("OK", NULL);
     last_error = ERR_NO_ERROR;
-    printf("\nCheck the log file for details.\n");
+    block_commands_supported = true;   // The firmware may have been changed
+    return RTE_OK;
 }
 
 
 /**
- * @brief Logs the last Windows API error with context text.
- *
- * @param text Context message to print before the error.
+ * @brief Closes the currently open serial port.
  */
 
-static void log_api_error(const char* text)
+void com_close(void)
 {
-    DWORD error = GetLastError();
-
-    if (!error || (text == NULL))
-    {
-        return;
-    }
-
-    log_string("\n%s: ", text);
-    const char* error_text = get_error_message_text(error);
-
-    if (error_text == NULL)
-    {
-        log_string("unknown error ", NULL);
-    }
-    else
+    if (serial_fd >= 0)
     {
-        log_string("%s", error_text);
+        com_flush();
+        close(serial_fd);
+        serial_fd = -1;
     }
 }
 
 
 /**
- * @brief Formats an error message for the specified error code.
+ * @brief Wait until the serial port is ready for reading or writing.
  *
- * This function formats an error message for the given error code using
- * FormatMessage() to retrieve the system error message. The message is stored
- * in a static buffer, which means it will be overwritten with each call.
+ * @param events  POLLIN or POLLOUT
+ * @param timeout Max. waiting time [ms]
  *
- * @param error_code The error code (typically from GetLastError())
- * 
- * @return Pointer to a static buffer containing the formatted error message
+ * @return 1 - port ready, 0 - timeout, -1 - error
  */
 
-const char* get_error_message_text(DWORD error_code)
+static int wait_for_serial_port(short events, long timeout)
 {
-    // Static buffer to hold the error message
-    static char error_buffer[512];
+    long deadline = clock_ms() + timeout;
 
-    DWORD length;
-    LPVOID temp_buffer = NULL;
+    for (;;)
+    {
+        struct pollfd pfd;
+        pfd.fd = serial_fd;
+        pfd.events = events;
+        pfd.revents = 0;
 
-    // Get the error message from the system
-    length = FormatMessageA(
-        FORMAT_MESSAGE_ALLOCATE_BUFFER |
-        FORMAT_MESSAGE_FROM_SYSTEM |
-        FORMAT_MESSAGE_IGNORE_INSERTS,
-        NULL,
-        error_code,
-        MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-        (LPSTR)&temp_buffer,
-        0, NULL);
+        long time_left = deadline - clock_ms();
+        int rez = poll(&pfd, 1, (time_left > 0) ? (int)time_left : 0);
 
-    if (length == 0)
-    {
-        // FormatMessage failed
-        snprintf(error_buffer, sizeof(error_buffer),
-            "Unknown error code: %lu (0x%08lX)", error_code, error_code);
-    }
-    else
-    {
-        // Copy the message to the static buffer
-        // Trim trailing whitespace and newlines
-        while (length > 0 && isspace(((LPSTR)temp_buffer)[length - 1]))
+        if (rez > 0)
         {
-            length--;
+            return 1;       // Ready or error reported by revents (detected by read/write)
         }
 
-        if (length >= sizeof(error_buffer))
+        if (rez == 0)
         {
-            length = sizeof(error_buffer) - 1;
+            return 0;
         }
 
-        memcpy(error_buffer, temp_buffer, length);
-        error_buffer[length] = '\0';
-
-        // Free the buffer allocated by FormatMessage
-        LocalFree(temp_buffer);
+        if (errno != EINTR)
+        {
+            log_linux_error("poll");
+            return -1;
+        }
     }
-
-    return error_buffer;
 }
 
-#else  // Linux implementation
 
-#include <fcntl.h>
-#include <termios.h>
-#include <unistd.h>
-#include <sys/ioctl.h>
-#include <errno.h>
-#include <cstring>
-#include "platform_compat.h"
+/**
+ * @brief Sends data over the serial port and waits until it has been transmitted.
+ *
+ * @param p_data A pointer to the data to be sent.
+ * @param length The length of the data to be sent in bytes.
+ *
+ * @return RTE_OK if the data was sent successfully, RTE_ERROR otherwise.
+ */
 
-//********** Global variables ***********
-static int serial_fd = -1;              // Serial port file descriptor
-static char linux_error_buffer[256];    // Error message buffer
+static int com_send(const char* p_data, unsigned length)
+{
+    if ((serial_fd < 0) || (p_data == NULL) || (length == 0))
+    {
+        last_error = ERR_BAD_INPUT_DATA;
+        return RTE_ERROR;
+    }
 
-//*********** Local functions ***********
-static speed_t get_baud_rate(int baud);
-static int set_serial_attributes(int fd);
-static void log_linux_error(const char* operation);
+    log_communication_hex("Send", p_data, length);
+    unsigned bytes_written = 0;
 
-/***
- * @brief Convert integer baud rate to speed_t constant
+    while (bytes_written < length)
+    {
+        ssize_t rez = write(serial_fd, p_data + bytes_written, length - bytes_written);
+
+        if (rez > 0)
+        {
+            bytes_written += (unsigned)rez;
+            continue;
+        }
+
+        if ((rez < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+        {
+            log_linux_error("Write to COM port");
+            tcflush(serial_fd, TCOFLUSH);
+            last_error = ERR_SEND_TIMEOUT;
+            return RTE_ERROR;
+        }
+
+        if (wait_for_serial_port(POLLOUT, parameters.com_port.recv_start_timeout) <= 0)
+        {
+            log_string("\nWrite to COM port timeout", NULL);
+            tcflush(serial_fd, TCOFLUSH);
+            last_error = ERR_SEND_TIMEOUT;
+            return RTE_ERROR;
+        }
+    }
+
+    // Ensure all data is transmitted before returning
+    if (tcdrain(serial_fd) != 0)
+    {
+        log_linux_error("Flush COM buffer");
+        last_error = ERR_SEND_TIMEOUT;
+        return RTE_ERROR;
+    }
+
+    return RTE_OK;
+}
+
+
+/**
+ * @brief Discards any unexpected data received on the serial port and logs it.
+ *
+ * @return true if data has been discarded
  */
-static speed_t get_baud_rate(int baud)
+
+static bool com_purge_and_log(void)
 {
-    switch (baud) {
-        case 9600:    return B9600;
-        case 19200:   return B19200;
-        case 38400:   return B38400;
-        case 57600:   return B57600;
-        case 115200:  return B115200;
-        case 230400:  return B230400;
-        case 460800:  return B460800;
-        case 500000:  return B500000;
-        case 576000:  return B576000;
-        case 921600:  return B921600;
-        case 1000000: return B1000000;
-        case 1152000: return B1152000;
-        case 1500000: return B1500000;
-        case 2000000: return B2000000;
-        case 2500000: return B2500000;
-        case 3000000: return B3000000;
-        case 3500000: return B3500000;
-        case 4000000: return B4000000;
-        default:      return B9600;  // Default fallback
+    if (serial_fd < 0)
+    {
+        return false;
     }
+
+    unsigned char data[40];
+    ssize_t bytes_read = read(serial_fd, data, sizeof(data));
+
+    if (bytes_read <= 0)
+    {
+        return false;   // No data available = OK
+    }
+
+    log_communication_hex("Unexpected data received", (const char *)data, (int)bytes_read);
+    int bytes_remaining = 0;
+
+    if ((ioctl(serial_fd, FIONREAD, &bytes_remaining) == 0) && (bytes_remaining > 0))
+    {
+        log_data("... + %u bytes", (long long)bytes_remaining);
+    }
+
+    tcflush(serial_fd, TCIFLUSH);
+    return true;
 }
 
-/***
- * @brief Configure serial port attributes
+
+/**
+ * @brief Logs the serial line errors detected by the driver since the last check.
+ *        The counters are not available for all drivers (e.g. USB serial converters
+ *        and pseudo terminals).
  */
-static int set_serial_attributes(int fd)
+
+static void com_check_line_errors(void)
 {
-    struct termios tty;
-    
-    if (tcgetattr(fd, &tty) != 0) {
-        log_linux_error("tcgetattr");
+    if (!line_counters_valid)
+    {
+        return;
+    }
+
+    struct serial_icounter_struct counters;
+
+    if (ioctl(serial_fd, TIOCGICOUNT, &counters) != 0)
+    {
+        return;
+    }
+
+    bool brk = counters.brk != line_counters.brk;
+    bool frame = counters.frame != line_counters.frame;
+    bool overrun = (counters.overrun != line_counters.overrun)
+        || (counters.buf_overrun != line_counters.buf_overrun);
+    bool parity = counters.parity != line_counters.parity;
+    line_counters = counters;
+
+    if (!brk && !frame && !overrun && !parity)
+    {
+        return;
+    }
+
+    last_error = ERR_COM_RECEIVE;
+    const char* separator = "";
+    log_string("\nCOM error: ", NULL);
+
+    if (brk)
+    {
+        log_string("break", NULL);
+        separator = ", ";
+    }
+
+    if (frame)
+    {
+        log_string("%sframming", separator);
+        separator = ", ";
+    }
+
+    if (overrun)
+    {
+        log_string("%sbuffer overrun", separator);
+        last_error = ERR_COM_BUFFER_OVERRUN;
+        separator = ", ";
+    }
+
+    if (parity)
+    {
+        log_string("%sparity", separator);
+    }
+}
+
+
+/**
+ * @brief Receives data from the serial port.
+ *
+ * The data is read in chunks as it arrives. The function fails if no data has been
+ * received for the receive timeout time (-com_timeout=xx).
+ *
+ * @param buffer A pointer to the buffer where the received data will be stored.
+ * @param size   The number of bytes to receive.
+ * @param type   A string describing the type of data being received (for logging).
+ *
+ * @return RTE_OK if the data was received successfully, RTE_ERROR otherwise.
+ */
+
+static int com_receive(unsigned char* buffer, unsigned size, const char* type)
+{
+    unsigned total_received = 0U;
+    long recv_start_time = clock_ms();
+
+    if ((serial_fd < 0) || (buffer == NULL) || (size == 0))
+    {
+        last_error = ERR_BAD_INPUT_DATA;
         return RTE_ERROR;
     }
 
-    // Set baud rate
-    speed_t speed = get_baud_rate(parameters.com_port.baudrate);
-    cfsetospeed(&tty, speed);
-    cfsetispeed(&tty, speed);
+    while (total_received < size)
+    {
+        ssize_t bytes_read = read(serial_fd, buffer + total_received, size - total_received);
 
-    // Configure for raw mode
-    tty.c_cflag &= ~PARENB;  // No parity
-    tty.c_cflag &= ~CSTOPB;  // One stop bit
-    tty.c_cflag &= ~CSIZE;   // Clear data size bits
-    tty.c_cflag |= CS8;      // 8 data bits
-    tty.c_cflag &= ~CRTSCTS; // No hardware flow control
-    tty.c_cflag |= CREAD | CLOCAL; // Enable receiver, ignore modem control lines
+        if (bytes_read > 0)
+        {
+            total_received += (unsigned)bytes_read;
+            continue;
+        }
 
-    // Configure parity based on parameters
-    switch (parameters.com_port.parity) {
-        case ODDPARITY:
-            tty.c_cflag |= PARENB | PARODD;
-            break;
-        case EVENPARITY:
-            tty.c_cflag |= PARENB;
-            tty.c_cflag &= ~PARODD;
-            break;
-        case NOPARITY:
-        default:
-            tty.c_cflag &= ~PARENB;
-            break;
+        if ((bytes_read < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+        {
+            log_linux_error("Read from COM port");
+            last_error = ERR_COM_RECEIVE;
+            return RTE_ERROR;
+        }
+
+        int rez = wait_for_serial_port(POLLIN, parameters.com_port.recv_start_timeout);
+
+        if (rez < 0)
+        {
+            last_error = ERR_COM_RECEIVE;
+            return RTE_ERROR;
+        }
+
+        if (rez == 0)
+        {
+            break;      // Timeout
+        }
+    }
+
+    if (total_received > 0)
+    {
+        com_check_line_errors();
+        log_communication_hex(type, (const char *)buffer, total_received);
+    }
+
+    if (total_received < size)
+    {
+        last_error = ERR_RCV_TIMEOUT;
+        log_data(" timeout after %u ms ", clock_ms() - recv_start_time);
+    }
+
+    return (total_received == size) ? RTE_OK : RTE_ERROR;
+}
+
+
+/**
+ * @brief Attempts to resynchronize the communication with the embedded system.
+ *
+ * This function sends a sequence of 0xFF characters to the embedded system to
+ * try to force it into a known state. It also handles the echo in single-wire
+ * communication mode.
+ */
+
+static void com_resynchronize(void)
+{
+    int result = com_send((const char*)"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF", 10);
+
+    if ((result == RTE_OK) && parameters.com_port.single_wire_communication)
+    {
+        unsigned char echo[RTECOM_SEND_PACKET_LEN];
+        (void)com_receive(echo, RTECOM_SEND_PACKET_LEN, "Echo");
     }
 
-    // Configure stop bits
-    if (parameters.com_port.stop_bits == TWOSTOPBITS) {
-        tty.c_cflag |= CSTOPB;
-    } else {
-        tty.c_cflag &= ~CSTOPB;
+    com_flush();
+}
+
+
+/**
+ * @brief Purge any existing data in the serial port communication buffers.
+ */
+
+void com_flush(void)
+{
+    if (serial_fd >= 0)
+    {
+        tcflush(serial_fd, TCIOFLUSH);
+    }
+}
+
+
+#endif  // _WIN32
+
+
+/**
+ * @brief Sends a command to the embedded system via the COM port.
+ *        Unexpected data in the receive buffer is discarded first.
+ *
+ * @param command The command to be sent.
+ * @param address The address associated with the command.
+ * @param data    The data associated with the command.
+ *
+ * @return RTE_OK if the command was sent successfully, RTE_ERROR otherwise.
+ */
+
+static int com_send_command(uint8_t command, uint32_t address, uint32_t data)
+{
+    com_purge_and_log();            // There should be no data in the input buffer
+    return com_send_packet(command, address, data);
+}
+
+
+/**
+ * @brief Sends a command packet to the embedded system via the COM port.
+ *
+ * This function sends a command packet to the embedded system, including the
+ * command, address, data, and checksum. It also handles the echo in single-wire
+ * communication mode.
+ *
+ * @param command The command to be sent.
+ * @param address The address associated with the command.
+ * @param data    The data associated with the command.
+ *
+ * @return RTE_OK if the command was sent successfully, RTE_ERROR otherwise.
+ */
+
+static int com_send_packet(uint8_t command, uint32_t address, uint32_t data)
+{
+    rtecom_send_data_t message;
+    memset(&message, 0, sizeof(message));
+    message.command = command;
+    message.address = address;
+    message.data = data;            // Write = data, Read = length
+
+    // Calculate the checksum
+    uint8_t checksum = RTECOM_CHECKSUM;
+    uint8_t *msg = (uint8_t *)&message.address;
+
+    for (int i = 0; i < 8; i++)
+    {
+        checksum ^= *msg++;
+    }
+
+    message.checksum = checksum;
+    int result = com_send((char*)&message.command, RTECOM_SEND_PACKET_LEN);
+
+    if (result != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    // In single-wire communication, it also receives all characters sent.
+    // The echo must be the same as the data sent.
+    if (parameters.com_port.single_wire_communication)
+    {
+        unsigned char echo[RTECOM_SEND_PACKET_LEN] = { 0 };
+        result = com_receive(echo, RTECOM_SEND_PACKET_LEN, "Echo");
+
+        if (result != RTE_OK)
+        {
+            log_string("Bad or no echo", NULL);
+            com_flush();
+            return RTE_ERROR;
+        }
+
+        if (memcmp(echo, &message.command, RTECOM_SEND_PACKET_LEN) != 0)
+        {
+            sleep_ms(COM_BAD_RESPONSE_DELAY);
+            log_string("\nBad echo  ", NULL);
+            com_flush();
+            return RTE_ERROR;
+        }
+    }
+
+    return  RTE_OK;
+}
+
+
+/**
+ * @brief Reads a block of memory from the embedded system via the COM port.
+ *
+ * This function sends a read command to the embedded system and then receives
+ * the requested memory block.
+ *
+ * @param buffer  A pointer to the buffer where the received data will be stored.
+ * @param address The starting address of the memory block to be read.
+ * @param length  The length of the memory block to be read in bytes.
+ *
+ * @return RTE_OK if the memory block was read successfully, RTE_ERROR otherwise.
+ */
+
+static int com_read_memory_block(unsigned char* buffer, unsigned int address, unsigned int length)
+{
+    if ((length > RTECOM_MAX_RECV_LEN) || (length == 0U))
+    {
+        return RTE_ERROR;
+    }
+
+    int rez = com_send_command(RTECOM_READ_RTEDBG, address, length);
+
+    if (rez != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    return com_receive(buffer, length, "Recv");
+}
+
+
+/**
+ * @brief Reads memory from the embedded system with pipelined read commands (-com_pipeline).
+ *
+ * The read command for the next block is sent before the current block is received,
+ * so the embedded system can start sending the next block immediately after the
+ * current one - the line is not idle while the host sends the next command.
+ * At most one command waits in the embedded system receive buffer. The blocks are
+ * received in the order of the commands, so the data is placed into the buffer
+ * sequentially. After an error the remaining data (including the queued block) is
+ * discarded by the resynchronization in the calling function.
+ *
+ * @param buffer   A pointer to the buffer where the received data will be stored.
+ * @param address  The starting address of the memory to be read.
+ * @param length   The total length of the memory to be read in bytes.
+ * @param max_size Maximal block size
+ *
+ * @return RTE_OK if the memory was read successfully, RTE_ERROR otherwise.
+ */
+
+static int com_read_memory_pipelined(unsigned char* buffer, unsigned int address, unsigned int length,
+                                     unsigned max_size)
+{
+    unsigned size = length > max_size ? max_size : length;
+
+    if (com_send_command(RTECOM_READ_RTEDBG, address, size) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    while (length > 0)
+    {
+        unsigned remaining = length - size;
+        unsigned next_size = remaining > max_size ? max_size : remaining;
+
+        // Queue the command for the next block while the current block is being sent
+        if ((next_size > 0) && (com_send_packet(RTECOM_READ_RTEDBG, address + size, next_size) != RTE_OK))
+        {
+            return RTE_ERROR;
+        }
+
+        if (com_receive(buffer, size, "Recv") != RTE_OK)
+        {
+            return RTE_ERROR;
+        }
+
+        buffer += size;
+        address += size;
+        length -= size;
+        size = next_size;
+    }
+
+    return RTE_OK;
+}
+
+
+/**
+ * @brief Reads memory from the embedded system via the COM port.
+ *
+ * This function reads memory from the embedded system in blocks, handling
+ * cases where the requested length exceeds the maximum receive length.
+ * The read commands are pipelined if enabled with -com_pipeline (not possible
+ * with single-wire communication - the line is half-duplex).
+ *
+ * @param buffer  A pointer to the buffer where the received data will be stored.
+ * @param address The starting address of the memory to be read.
+ * @param length  The total length of the memory to be read in bytes.
+ *
+ * @return RTE_OK if the memory was read successfully, RTE_ERROR otherwise.
+ */
+
+int com_read_memory(unsigned char* buffer, unsigned int address, unsigned int length)
+{
+    // Maximal packet length while receiving data
+    unsigned max_size = (parameters.max_message_size < RTECOM_MAX_RECV_LEN) ?
+        parameters.max_message_size : RTECOM_MAX_RECV_LEN;
+
+    if (parameters.com_port.pipelined_reads && !parameters.com_port.single_wire_communication)
+    {
+        if (com_read_memory_pipelined(buffer, address, length, max_size) != RTE_OK)
+        {
+            // Wait until the embedded system stops sending the queued data block
+            while (com_purge_and_log())
+            {
+                sleep_ms(COM_BAD_RESPONSE_DELAY);
+            }
+
+            com_resynchronize();
+            return RTE_ERROR;
+        }
+
+        return RTE_OK;
+    }
+
+    unsigned size = 0;
+
+    for (; length > 0; length -= size)
+    {
+        size = length > max_size ? max_size : length;
+        int rez = com_read_memory_block(buffer, address, size);
+        buffer += size;
+        address += size;
+
+        if (rez != RTE_OK)
+        {
+            com_resynchronize();
+            return RTE_ERROR;
+        }
+    }
+
+    return RTE_OK;
+}
+
+
+/**
+ * @brief Sends the data that follows a block command packet and checks the echo
+ *        in single-wire communication mode.
+ *
+ * @param data   A pointer to the data to be sent.
+ * @param length The length of the data in bytes.
+ *
+ * @return RTE_OK if the data was sent successfully, RTE_ERROR otherwise.
+ */
+
+static int com_send_payload(const unsigned char* data, unsigned length)
+{
+    if (com_send((const char*)data, length) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    if (!parameters.com_port.single_wire_communication)
+    {
+        return RTE_OK;
+    }
+
+    unsigned char echo[RTECOM_MAX_WRITE_BLOCK_WORDS * 4U];
+
+    if ((com_receive(echo, length, "Echo") != RTE_OK) || (memcmp(echo, data, length) != 0))
+    {
+        sleep_ms(COM_BAD_RESPONSE_DELAY);
+        log_string("\nBad echo  ", NULL);
+        com_flush();
+        return RTE_ERROR;
+    }
+
+    return RTE_OK;
+}
+
+
+/**
+ * @brief Executes a block command (RTECOM_FILL_RTEDBG or RTECOM_WRITE_RTEDBG_BLOCK).
+ *
+ * The embedded system confirms the command packet before the data is sent, so the
+ * data is never interpreted as a command by a firmware without block command support.
+ *
+ * @param command    RTECOM_FILL_RTEDBG or RTECOM_WRITE_RTEDBG_BLOCK
+ * @param address    Byte address of the first word (relative to the g_rtedbg start)
+ * @param words      Number of words to fill or write
+ * @param payload    Fill pattern (one word) or data to be written
+ * @param length     Payload length in bytes
+ *
+ * @return RTE_OK    - data written
+ *         COM_NACK  - command refused by the embedded system
+ *         RTE_ERROR - communication error
+ */
+
+static int com_block_command(uint8_t command, unsigned address, unsigned words,
+                             const unsigned char* payload, unsigned length)
+{
+    // Address is address of word to be written and not byte (divide by 4)
+    if (com_send_command(command, address / 4U, words) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    int rez = check_response(command);
+
+    if (rez != RTE_OK)
+    {
+        return rez;
+    }
+
+    if (com_send_payload(payload, length) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    return check_response(command);
+}
+
+
+/**
+ * @brief Writes memory to the embedded system with block commands.
+ *        Data consisting of a single repeated word is written with one fill command,
+ *        other data with write block commands.
+ *
+ * @param buffer  A pointer to the buffer containing the data to be written.
+ * @param address The starting address of the memory to be written.
+ * @param length  The total length of the memory to be written in bytes.
+ *
+ * @return RTE_OK    - data written
+ *         COM_NACK  - block commands not supported (nothing has been written)
+ *         RTE_ERROR - communication error
+ */
+
+static int com_write_memory_blocks(const unsigned char* buffer, unsigned address, unsigned length)
+{
+    unsigned i = 4U;
+
+    while ((i < length) && (memcmp(&buffer[i], buffer, 4U) == 0))
+    {
+        i += 4U;
     }
 
-    // Input flags - turn off input processing
-    tty.c_iflag &= ~(IXON | IXOFF | IXANY); // Turn off s/w flow ctrl
-    tty.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL); // Disable any special handling of received bytes
+    if (i == length)
+    {
+        return com_block_command(RTECOM_FILL_RTEDBG, address, length / 4U, buffer, 4U);
+    }
 
-    // Output flags - turn off output processing
-    tty.c_oflag &= ~OPOST; // Prevent special interpretation of output bytes (e.g. newline chars)
-    tty.c_oflag &= ~ONLCR; // Prevent conversion of newline to carriage return/line feed
+    bool first_block = true;
 
-    // Control characters
-    tty.c_cc[VTIME] = parameters.com_port.recv_start_timeout / 100; // Wait timeout in deciseconds
-    tty.c_cc[VMIN] = 0;    // Return immediately with any received data
+    while (length > 0)
+    {
+        unsigned size = (length > (RTECOM_MAX_WRITE_BLOCK_WORDS * 4U)) ?
+            (RTECOM_MAX_WRITE_BLOCK_WORDS * 4U) : length;
+        int rez = com_block_command(RTECOM_WRITE_RTEDBG_BLOCK, address, size / 4U, buffer, size);
 
-    // Local flags
-    tty.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG); // Raw mode
+        if (rez != RTE_OK)
+        {
+            return ((rez == COM_NACK) && first_block) ? COM_NACK : RTE_ERROR;
+        }
 
-    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
-        log_linux_error("tcsetattr");
-        return RTE_ERROR;
+        first_block = false;
+        buffer += size;
+        address += size;
+        length -= size;
     }
 
     return RTE_OK;
 }
 
-/***
- * @brief Log Linux system error with context
- */
-static void log_linux_error(const char* operation)
-{
-    snprintf(linux_error_buffer, sizeof(linux_error_buffer), 
-             "%s failed: %s", operation, strerror(errno));
-    log_string(linux_error_buffer, NULL);
-}
 
-/***
- * @brief Open and configure serial port
+/**
+ * @brief Writes a block of memory to the embedded system via the COM port.
+ *
+ * This function sends a write command to the embedded system to write a block
+ * of memory. The address of the data transferred to the embedded system is
+ * that of a 32-bit word, rather than a byte. The RTECOM_WRITE_RTEDBG command
+ * only allows one word to be sent per data packet.
+ *
+ * @param buffer A pointer to the buffer containing the data to be written.
+ * @param address The starting address of the memory to be written.
+ * @param length The length of the memory block to be written in bytes.
+ *
+ * @return RTE_OK if the memory block was written successfully, RTE_ERROR otherwise.
  */
-int com_open(void)
+
+static int com_write_memory_block(const unsigned char* buffer, unsigned address, unsigned length)
 {
-    char device_path[64];
-    
-    // Convert COM port name to Linux device path
-    // COM1 -> /dev/ttyS0, COM2 -> /dev/ttyS1, etc.
-    // Also support direct device paths like /dev/ttyUSB0
-    if (strncmp(parameters.com_port.name, "COM", 3) == 0) {
-        int port_num = atoi(&parameters.com_port.name[3]);
-        if (port_num > 0) {
-            snprintf(device_path, sizeof(device_path), "/dev/ttyS%d", port_num - 1);
-        } else {
-            log_string("Invalid COM port number", NULL);
-            return RTE_ERROR;
-        }
-    } else if (parameters.com_port.name[0] == '/') {
-        // Direct device path (e.g., /dev/ttyUSB0, /dev/ttyACM0)
-        strncpy(device_path, parameters.com_port.name, sizeof(device_path) - 1);
-        device_path[sizeof(device_path) - 1] = '\0';
-    } else {
-        // Assume it's a device name without /dev/ prefix
-        snprintf(device_path, sizeof(device_path), "/dev/%s", parameters.com_port.name);
+    if ((length != 4U) || (address & 3U))
+    {
+        return RTE_ERROR;
     }
 
-    log_string("Opening serial port: ", device_path);
+    uint32_t data;
+    memcpy(&data, buffer, sizeof(data));
 
-    // Open serial port
-    serial_fd = open(device_path, O_RDWR | O_NOCTTY | O_NONBLOCK);
-    if (serial_fd < 0) {
-        log_linux_error("open");
-        return RTE_ERROR;
-    }
+    // Address is address of word to be written and not byte (divide by 4)
+    int ret = com_send_command(RTECOM_WRITE_RTEDBG, address / 4U, data);
 
-    // Configure serial port
-    if (set_serial_attributes(serial_fd) != RTE_OK) {
-        close(serial_fd);
-        serial_fd = -1;
+    if (ret != RTE_OK)
+    {
         return RTE_ERROR;
     }
 
-    // Flush any existing data
-    tcflush(serial_fd, TCIOFLUSH);
-
-    log_string(" - OK", NULL);
-    return RTE_OK;
+    return (check_response(RTECOM_WRITE_RTEDBG) == RTE_OK) ? RTE_OK : RTE_ERROR;
 }
 
-/***
- * @brief Close serial port
- */
-void com_close(void)
-{
-    if (serial_fd >= 0) {
-        close(serial_fd);
-        serial_fd = -1;
-        log_string("Serial port closed", NULL);
-    }
-}
 
-/***
- * @brief Read data from embedded system via serial port
+/**
+ * @brief Writes memory to the embedded system via the COM port.
+ *
+ * Blocks longer than one word are written with the block commands (fill or write
+ * block). If the embedded system does not support them, the data is written word
+ * by word (the block commands are not tried again until the port is reopened).
+ * The total length must be a multiple of 4.
+ *
+ * @param buffer A pointer to the buffer containing the data to be written.
+ * @param address The starting address of the memory to be written.
+ * @param length The total length of the memory to be written in bytes.
+ *
+ * @return RTE_OK if the memory was written successfully, RTE_ERROR otherwise.
  */
-int com_read_memory(unsigned char* buffer, unsigned int address, unsigned int length)
+
+int com_write_memory(const unsigned char* buffer, unsigned address, unsigned length)
 {
-    if (serial_fd < 0) {
-        log_string("Serial port not open", NULL);
+    if (length & 3U)
+    {
+        log_data("\nWrite memory length (%u) must be divisible by 4.", length);
         return RTE_ERROR;
     }
 
-    // Send read command to embedded system
-    char cmd[32];
-    snprintf(cmd, sizeof(cmd), "R%08X%04X\n", address, length);
-    
-    if (write(serial_fd, cmd, strlen(cmd)) < 0) {
-        log_linux_error("write");
+    if (address & 3U)
+    {
+        log_data("\nWrite address length (0x%X) must be divisible by 4.", address);
         return RTE_ERROR;
     }
 
-    // Read response
-    ssize_t bytes_read = read(serial_fd, buffer, length);
-    if (bytes_read < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            log_string("Read timeout", NULL);
-            return RTE_ERROR;  // Use RTE_ERROR instead of RTE_TIMEOUT
+    if ((length > 4U) && block_commands_supported)
+    {
+        int rez = com_write_memory_blocks(buffer, address, length);
+
+        if (rez == RTE_OK)
+        {
+            return RTE_OK;
         }
-        log_linux_error("read");
-        return RTE_ERROR;
+
+        if (rez != COM_NACK)
+        {
+            com_resynchronize();
+            return RTE_ERROR;
+        }
+
+        block_commands_supported = false;
+        log_string("\nBlock write commands not supported - writing word by word.", NULL);
     }
 
-    if (bytes_read != (ssize_t)length) {
-        log_data("Expected %lld bytes, got different amount", (long long)length);
-        return RTE_ERROR;
+    long last_time = clock_ms();
+
+    for (unsigned i = 0U; i < length; i += 4U)
+    {
+        if (length > 4)
+        {
+            long new_time = clock_ms();
+
+            if ((new_time - last_time) > 99)
+            {
+                putchar('.');
+                last_time = new_time;
+            }
+        }
+
+        int ret = com_write_memory_block(buffer, address, 4U);
+
+        if (ret != RTE_OK)
+        {
+            com_resynchronize();
+            return RTE_ERROR;
+        }
+        address += 4U;
+        buffer += 4U;
     }
 
     return RTE_OK;
 }
 
-/***
- * @brief Write data to embedded system via serial port
+
+/**
+ * @brief Fills a memory block in the embedded system with a 32-bit pattern.
+ *
+ * The block is filled with a single RTECOM_FILL_RTEDBG command if the embedded
+ * system supports the block commands (see com_write_memory()), otherwise it is
+ * written word by word.
+ *
+ * @param address The starting address of the memory to be filled.
+ * @param pattern Value written to every word of the block.
+ * @param length  The length of the block in bytes (multiple of 4).
+ *
+ * @return RTE_OK if the memory was filled successfully, RTE_ERROR otherwise.
  */
-int com_write_memory(const unsigned char* buffer, unsigned address, unsigned length)
+
+int com_fill_memory(unsigned address, unsigned pattern, unsigned length)
 {
-    if (serial_fd < 0) {
-        log_string("Serial port not open", NULL);
-        return RTE_ERROR;
-    }
+    unsigned* buffer = (unsigned*)malloc(length);
 
-    // Send write command followed by data
-    char cmd[32];
-    snprintf(cmd, sizeof(cmd), "W%08X%04X", address, length);
-    
-    if (write(serial_fd, cmd, strlen(cmd)) < 0) {
-        log_linux_error("write command");
+    if (buffer == NULL)
+    {
+        log_string("\nCould not allocate memory buffer.", NULL);
         return RTE_ERROR;
     }
-    
-    if (write(serial_fd, buffer, length) < 0) {
-        log_linux_error("write data");
-        return RTE_ERROR;
+
+    for (unsigned i = 0; i < length / 4U; i++)
+    {
+        buffer[i] = pattern;
     }
 
-    return RTE_OK;
+    int rez = com_write_memory((const unsigned char*)buffer, address, length);
+    free(buffer);
+    return rez;
 }
 
-/***
- * @brief Flush serial port buffers
+
+/**
+ * @brief Wait for response from embedded system
+ *
+ * The embedded system returns ACK if the index is within the g_rtedbg structure
+ * and the command (e.g. data write) has been performed, otherwise NACK (see below).
+ * No response is sent if the command was not received correctly (e.g. bad checksum).
+ *
+ * @param commmand - command sent to embedded system is response if the data/address
+ *                   value is not correct (NACK value).
+ *
+ * @return RTE_OK    - embedded system responded with ACK
+ *         COM_NACK  - NACK received
+ *         RTE_ERROR - no response or bad response
  */
-void com_flush(void)
+
+static int check_response(char command)
 {
-    if (serial_fd >= 0) {
-        tcflush(serial_fd, TCIOFLUSH);
+    unsigned char data;
+
+    if (com_receive(&data, 1U, "Response") != RTE_OK)
+    {
+        return RTE_ERROR;
     }
-}
 
-/***
- * @brief Display COM port error message
- */
-void com_display_errors(const char* message)
-{
-    if (message) {
-        printf("%s", message);
+    if (data == RTECOM_ACK)
+    {
+        return RTE_OK;
     }
-    
-    if (serial_fd < 0) {
-        printf(" (Serial port not open)");
+
+    if (data == (unsigned char)command)
+    {
+        log_string(" NACK received ", NULL);
+        return COM_NACK;
     }
+
+    log_data(" Bad response 0x%02X ", data);
+    com_purge_and_log();
+    return RTE_ERROR;
 }
 
-/***
- * @brief Get COM port error text
+
+/**
+ * @brief Returns a pointer to the short error message text.
+ *        Trailing spaces are used to overwrite previous message(s).
+ *
+ * @return Text message to show in case of error.
  */
+
 const char* com_get_error_text(void)
 {
-    if (serial_fd < 0) {
-        return "Serial port not open";
+    switch (last_error)
+    {
+        case ERR_COM_CANNOT_OPEN_PORT:
+            return "COM port closed           ";
+
+        case ERR_COM_BUFFER_OVERRUN:
+            return "buffer overrun            ";
+
+        case ERR_RCV_TIMEOUT:
+            return "receive timeout           ";
+
+        case ERR_COM_RECEIVE:
+            return "receive error             ";
+
+        case ERR_SEND_TIMEOUT:
+            return "send timeout              ";
+
+        default:
+            return "                          ";
     }
-    
-    return linux_error_buffer[0] ? linux_error_buffer : "No error";
 }
 
-#endif  // _WIN32
+
+/**
+ * @brief Display error message if the logging is redirected to a log file.
+ *
+ * @param message Text message to show in case of error.
+ */
+
+void com_display_errors(const char* message)
+{
+    if (!logging_to_file() || (last_error == 0))
+    {
+        printf("\n");
+        return;
+    }
+
+    printf(message);
+    switch (last_error)
+    {
+        case ERR_COM_CANNOT_OPEN_PORT:
+            printf("cannot open port %s", parameters.com_port.name);
+            break;
+
+        case ERR_COM_BUFFER_OVERRUN:
+            printf("buffer overrun");
+            break;
+
+        case ERR_RCV_TIMEOUT:
+            printf("receive timeoout");
+            break;
+
+        case ERR_COM_RECEIVE:
+            printf("receive error");
+            break;
+
+        case ERR_SEND_TIMEOUT:
+            printf("send timeout");
+            break;
+
+        case ERR_BAD_INPUT_DATA:
+            printf("bad function parameter");
+            break;
+
+        default:
+            break;
+    }
+
+    last_error = ERR_NO_ERROR;
+    printf("\nCheck the log file for details.\n");
+}
 
 /*==== End of file ====*/
@@ -19,6 +19,7 @@ int  com_open(void);
 void com_close(void);
 int  com_read_memory(unsigned char* buffer, unsigned int address, unsigned int length);
 int  com_write_memory(const unsigned char* buffer, unsigned address, unsigned length);
+int  com_fill_memory(unsigned address, unsigned pattern, unsigned length);
 void com_flush(void);
 void com_display_errors(const char* message);
 const char* com_get_error_text(void);
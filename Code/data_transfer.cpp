@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    data_transfer.cpp
+ * @brief   Transfer sequence of the g_rtedbg structure shared by the single target and
+ *          multi-target transfers. The data logging is paused while the structure is read,
+ *          the circular buffer is cleared (-clear) or restarted (single shot mode) and the
+ *          message filter is restored before the data is written to a file - the logging
+ *          is stopped only for the time of the data transfer.
+ * @author  B. Premzel
+ */
+
+#include "pch.h"
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+#include "RTEgetData.h"
+#include "cmd_line.h"
+#include "rtedbg.h"
+#include "logger.h"
+#include "platform_compat.h"
+#include "data_transfer.h"
+
+
+/*---------------- Local functions ---------------*/
+static int reset_buffer(const transfer_target_t* target, const rtedbg_header_t* header);
+
+
+/***
+ * @brief Pause the data logging, read the g_rtedbg structure, clear or restart the
+ *        circular buffer if required and restore the message filter (or set the -filter
+ *        value). The filter is restored after all errors that occur after the logging has
+ *        been paused.
+ *
+ * @param target      Embedded system memory access and the host copy read function
+ * @param header      g_rtedbg header read after the logging has been paused
+ * @param old_filter  Message filter value before the logging was paused
+ *
+ * @return TRANSFER_OK - data transferred and the message filter restored, other - see transfer_result_t
+ */
+
+transfer_result_t transfer_rtedbg_structure(const transfer_target_t* target, rtedbg_header_t* header,
+    uint32_t* old_filter)
+{
+    const unsigned filter_address = target->start_address + offsetof(rtedbg_header_t, filter);
+
+    if (target->read_memory(target->connection, (unsigned char*)old_filter, filter_address, 4U) != RTE_OK)
+    {
+        return TRANSFER_COMMUNICATION_ERROR;
+    }
+
+    // Pause data logging if the old message filter is not zero.
+    if ((*old_filter != 0)
+        && (target->write_memory(target->connection, (const unsigned char*)"\x00\x00\x00\x00",
+            filter_address, 4U) != RTE_OK))
+    {
+        return TRANSFER_COMMUNICATION_ERROR;
+    }
+
+    transfer_result_t result = TRANSFER_OK;
+    memset(header, 0, sizeof(rtedbg_header_t));     // Filter copy not used if the header is not read
+
+    if (target->read_memory(target->connection, (unsigned char*)header, target->start_address,
+        sizeof(rtedbg_header_t)) != RTE_OK)
+    {
+        result = TRANSFER_COMMUNICATION_ERROR;
+    }
+    else if (target->read_structure(target->connection, header, *old_filter) != RTE_OK)
+    {
+        result = TRANSFER_READ_ERROR;
+    }
+    else
+    {
+        // The filter must still be zero - otherwise the data may be partially corrupted
+        uint32_t message_filter;
+
+        if (target->read_memory(target->connection, (unsigned char*)&message_filter, filter_address, 4U)
+            != RTE_OK)
+        {
+            result = TRANSFER_COMMUNICATION_ERROR;
+        }
+        else if (message_filter != 0)
+        {
+            result = TRANSFER_LOGGING_ENABLED;
+        }
+        else if (reset_buffer(target, header) != RTE_OK)
+        {
+            result = TRANSFER_BUFFER_NOT_RESET;
+        }
+    }
+
+    // Restore the message filter or set the new value (-filter=value)
+    const rtedbg_header_t& rtedbg_header = *header;     // Name used by the rtedbg.h macros
+    uint32_t filter = *old_filter;
+
+    if ((filter == 0) && RTE_FILTER_OFF_ENABLED)
+    {
+        filter = rtedbg_header.filter_copy;
+    }
+
+    if (parameters.set_filter)
+    {
+        filter = parameters.filter;     // User defined filter value (command line argument)
+    }
+
+    if (target->write_memory(target->connection, (const unsigned char*)&filter, filter_address, 4U) != RTE_OK)
+    {
+        return TRANSFER_COMMUNICATION_ERROR;
+    }
+
+    return result;
+}
+
+
+/***
+ * @brief Fill the circular buffer with 0xFFFFFFFF if enabled (-clear) and erase the buffer
+ *        index if the buffer has been cleared or the single shot logging was active.
+ *
+ * @param target  Embedded system memory access
+ * @param header  g_rtedbg header
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - buffer not cleared or index not erased
+ */
+
+static int reset_buffer(const transfer_target_t* target, const rtedbg_header_t* header)
+{
+    const rtedbg_header_t& rtedbg_header = *header;     // Name used by the rtedbg.h macros
+
+    if (parameters.clear_buffer)
+    {
+        unsigned circular_buffer_size = rtedbg_header.buffer_size * 4U;
+        LARGE_INTEGER start_time;
+        start_timer(&start_time);
+        log_string("\nClearing the circular buffer...", NULL);
+
+        // The fill is done by the target if possible - see port_fill_memory()
+        if (target->fill_memory(target->connection, target->start_address + sizeof(rtedbg_header_t),
+            0xFFFFFFFFU, circular_buffer_size) != RTE_OK)
+        {
+            return RTE_ERROR;
+        }
+
+        long long speed =
+            (long long)((double)circular_buffer_size / time_elapsed(&start_time));
+
+        if (speed > 20U)
+        {
+            log_data(", %llu kB/s. ", speed);
+        }
+        else
+        {
+            speed = (long long)((double)(circular_buffer_size * 1000U) / time_elapsed(&start_time));
+            log_data(", %llu B/s. ", speed);
+        }
+    }
+
+    if (parameters.clear_buffer || (RTE_SINGLE_SHOT_WAS_ACTIVE && RTE_SINGLE_SHOT_LOGGING_ENABLED))
+    {
+        // Restart logging at the start of the circular buffer
+        return target->write_memory(target->connection, (const unsigned char*)"\x00\x00\x00\x00",
+            target->start_address, 4U);
+    }
+
+    return RTE_OK;
+}
+
+/*==== End of file ====*/
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    data_transfer.h
+ * @author  B. Premzel
+ * @brief   Transfer sequence of the g_rtedbg structure shared by the single target
+ *          (serial port or GDB server) and multi-target (-targets) transfers.
+ */
+
+#ifndef _DATA_TRANSFER_H
+#define _DATA_TRANSFER_H
+
+#include <stdint.h>
+#include "rtedbg.h"
+
+typedef struct
+{
+    void* connection;                       // Passed to the functions below
+    unsigned start_address;                 // Address of the g_rtedbg structure
+
+    // Memory access of the embedded system
+    int (*read_memory)(void* connection, unsigned char* buffer, unsigned address, unsigned length);
+    int (*write_memory)(void* connection, const unsigned char* buffer, unsigned address, unsigned length);
+    int (*fill_memory)(void* connection, unsigned address, unsigned pattern, unsigned length);
+
+    // Check the header and read the g_rtedbg structure to the host copy while the logging
+    // is paused. The errors are reported by the function.
+    int (*read_structure)(void* connection, const rtedbg_header_t* header, uint32_t old_filter);
+} transfer_target_t;
+
+typedef enum
+{
+    TRANSFER_OK,
+    TRANSFER_COMMUNICATION_ERROR,           // Communication with the embedded system failed
+    TRANSFER_READ_ERROR,                    // read_structure() failed
+    TRANSFER_LOGGING_ENABLED,               // The firmware enabled the logging during the transfer
+    TRANSFER_BUFFER_NOT_RESET               // Data transferred, but the circular buffer was not
+                                            // cleared or its index not erased
+} transfer_result_t;
+
+transfer_result_t transfer_rtedbg_structure(const transfer_target_t* target, rtedbg_header_t* header,
+    uint32_t* old_filter);
+
+#endif  // _DATA_TRANSFER_H
+
+/*==== End of file ====*/
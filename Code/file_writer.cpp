@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    file_writer.cpp
+ * @brief   Background thread writing the g_rtedbg structure snapshots to the binary
+ *          file. The snapshot is copied to one of the writer buffers and the message
+ *          filter can be restored in the embedded system immediately after the data
+ *          transfer - the logging does not have to be paused during the file write.
+ *          The program does not wait for the write unless the data file is needed (-decode).
+ *          The write errors are reported by file_writer_check() in the -p mode command loop
+ *          and by file_writer_stop().
+ * @author  B. Premzel
+ */
+
+#include "pch.h"
+#include <stdlib.h>
+#include <stdarg.h>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <system_error>
+#include "RTEgetData.h"
+#include "cmd_line.h"
+#include "logger.h"
+#include "platform_compat.h"
+#include "snapshot_file.h"
+#include "file_writer.h"
+
+
+typedef struct
+{
+    unsigned* data;         // Copy of the g_rtedbg structure
+    unsigned capacity;      // Size of the allocated buffer [bytes]
+    unsigned size;          // Size of the data [bytes]
+    uint64_t timestamp;     // Host time of the transfer (container file)
+    bool pending;           // true - data waiting to be written or being written
+} write_buffer_t;
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static std::thread writer_thread;
+static std::mutex writer_mutex;             // Protects the variables below
+static std::condition_variable writer_event;    // Signalled when a buffer is submitted or written
+static write_buffer_t buffers[FILE_WRITER_BUFFERS];
+static unsigned submit_index = 0;           // Buffer to be filled next
+static unsigned write_index = 0;            // Buffer to be written next
+static bool writer_running = false;
+static bool stop_request = false;
+static bool write_failed = false;           // Set if a file write failed after the last file_writer_wait()
+static std::vector<std::pair<bool, std::string>> writer_messages;  // Messages of the writer thread (true - log message)
+static thread_local bool in_writer_thread = false;
+
+
+/*---------------- Local functions ---------------*/
+static void writer_thread_function(void);
+static int  write_snapshot(const unsigned* data, unsigned size, uint64_t timestamp);
+static errno_t open_data_file(FILE** file, const char* mode);
+static void report_create_error(void);
+static bool start_writer_thread(void);
+static void print_writer_messages(void);
+
+
+/***
+ * @brief Check that the binary file can be created before the data is transferred (the
+ *        file contents are not changed). The circular buffer must not be cleared or
+ *        restarted if the data cannot be saved.
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - file could not be created
+ */
+
+int file_writer_prepare(void)
+{
+    FILE* bin_file;
+
+    if (open_data_file(&bin_file, "ab") != 0)
+    {
+        report_create_error();
+        return RTE_ERROR;
+    }
+
+    (void)fclose(bin_file);
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Copy the g_rtedbg structure to a free writer buffer and pass it to the writer
+ *        thread. The function waits only if all buffers are still waiting to be written.
+ *        The data is written directly if the thread cannot be started.
+ *
+ * @param data       g_rtedbg structure image (with the filter value to be saved)
+ * @param size       Size of the structure [bytes]
+ * @param timestamp  Host time of the transfer [ms since 1.1.1970 UTC] - see snapshot_file_time()
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - out of memory or file write failed (if written directly)
+ */
+
+int file_writer_submit(const unsigned* data, unsigned size, uint64_t timestamp)
+{
+    if (!writer_running && !start_writer_thread())
+    {
+        return write_snapshot(data, size, timestamp);
+    }
+
+    std::unique_lock<std::mutex> lock(writer_mutex);
+    write_buffer_t* buffer = &buffers[submit_index];
+    writer_event.wait(lock, [buffer] { return !buffer->pending; });
+    lock.unlock();
+
+    // The buffer is not used by the writer thread until it is marked as pending
+    if (buffer->capacity < size)
+    {
+        unsigned* new_data = (unsigned*)realloc(buffer->data, size);
+
+        if (new_data == NULL)
+        {
+            log_string("\nCould not allocate memory buffer.", NULL);
+            return RTE_ERROR;
+        }
+
+        buffer->data = new_data;
+        buffer->capacity = size;
+    }
+
+    memcpy(buffer->data, data, size);
+    buffer->size = size;
+    buffer->timestamp = timestamp;
+
+    lock.lock();
+    buffer->pending = true;
+    submit_index = (submit_index + 1U) % FILE_WRITER_BUFFERS;
+    lock.unlock();
+    writer_event.notify_all();
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Wait until all submitted snapshots have been written.
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - at least one file write failed after the previous call
+ */
+
+int file_writer_wait(void)
+{
+    std::unique_lock<std::mutex> lock(writer_mutex);
+    writer_event.wait(lock, []
+        {
+            for (unsigned i = 0; i < FILE_WRITER_BUFFERS; i++)
+            {
+                if (buffers[i].pending)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        });
+
+    lock.unlock();
+    return file_writer_check();
+}
+
+
+/***
+ * @brief Print the messages of the writer thread and report the write errors without
+ *        waiting for the submitted snapshots (called periodically in the -p mode).
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - at least one file write failed after the previous call
+ */
+
+int file_writer_check(void)
+{
+    std::unique_lock<std::mutex> lock(writer_mutex);
+    int rez = write_failed ? RTE_ERROR : RTE_OK;
+    write_failed = false;
+    lock.unlock();
+    print_writer_messages();
+    return rez;
+}
+
+
+/***
+ * @brief Write the remaining snapshots, stop the writer thread, release the buffers
+ *        and close the container file.
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - at least one file write failed after the previous file_writer_wait()
+ *                     or file_writer_check()
+ */
+
+int file_writer_stop(void)
+{
+    if (writer_running)
+    {
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            stop_request = true;
+        }
+
+        writer_event.notify_all();
+        writer_thread.join();
+        writer_running = false;
+        stop_request = false;
+    }
+
+    int rez = file_writer_check();
+    snapshot_file_close();
+
+    for (unsigned i = 0; i < FILE_WRITER_BUFFERS; i++)
+    {
+        free(buffers[i].data);
+        buffers[i].data = NULL;
+        buffers[i].capacity = 0;
+    }
+
+    return rez;
+}
+
+
+/***
+ * @brief Start the writer thread.
+ *
+ * @return true if the thread has been started
+ */
+
+static bool start_writer_thread(void)
+{
+    try
+    {
+        writer_thread = std::thread(writer_thread_function);
+    }
+    catch (const std::system_error&)
+    {
+        log_string("\nCould not start the file writer thread - the data will be written directly.", NULL);
+        return false;
+    }
+
+    writer_running = true;
+    return true;
+}
+
+
+/***
+ * @brief Write the submitted snapshots in the order of submission until the stop is
+ *        requested and all buffers have been written.
+ */
+
+static void writer_thread_function(void)
+{
+    in_writer_thread = true;
+    std::unique_lock<std::mutex> lock(writer_mutex);
+
+    for (;;)
+    {
+        write_buffer_t* buffer = &buffers[write_index];
+        writer_event.wait(lock, [buffer] { return buffer->pending || stop_request; });
+
+        if (!buffer->pending)
+        {
+            break;      // Stop requested and all data written
+        }
+
+        lock.unlock();
+        int rez = write_snapshot(buffer->data, buffer->size, buffer->timestamp);
+        lock.lock();
+
+        if (rez != RTE_OK)
+        {
+            write_failed = true;
+        }
+
+        buffer->pending = false;
+        write_index = (write_index + 1U) % FILE_WRITER_BUFFERS;
+        writer_event.notify_all();
+    }
+}
+
+
+/***
+ * @brief Write the g_rtedbg structure to the binary file and append it to the
+ *        container file (if defined).
+ *
+ * @param data       g_rtedbg structure image
+ * @param size       Size of the structure [bytes]
+ * @param timestamp  Host time of the transfer
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - file operation failed
+ */
+
+static int write_snapshot(const unsigned* data, unsigned size, uint64_t timestamp)
+{
+    FILE * bin_file;
+
+    file_writer_message(false, "\nWriting data to a file");
+
+    if (open_data_file(&bin_file, "wb") != 0)
+    {
+        report_create_error();
+        return RTE_ERROR;
+    }
+
+    size_t written = fwrite(data, 1U, size, bin_file);
+
+    if (written != size)
+    {
+        char error_text[256];
+#ifdef _WIN32
+        (void)_strerror_s(error_text, sizeof(error_text), NULL);
+#else
+        strerror_s(error_text, sizeof(error_text), errno);
+#endif
+        file_writer_message(true, "\nCould not write to the file: %s. Error: %s", parameters.bin_file_name, error_text);
+        (void)fclose(bin_file);
+
+        if (logging_to_file())
+        {
+            file_writer_message(false, "\nCould not write to the file: %s. Error: %s", parameters.bin_file_name, error_text);
+        }
+
+        return RTE_ERROR;
+    }
+
+    (void)fclose(bin_file);
+
+    if (logging_to_file())
+    {
+        file_writer_message(false, "\nData written to \"%s\"\n", parameters.bin_file_name);
+    }
+
+    if (parameters.container_file != NULL)
+    {
+        return snapshot_file_append(parameters.container_file, data, size, timestamp);
+    }
+
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Open the binary file. The open is retried for up to 900 ms if the access is
+ *        denied - the file may be temporarily locked.
+ *
+ * @param file  Pointer to the file pointer
+ * @param mode  File open mode
+ *
+ * @return 0 - no error, error code otherwise (errno is set)
+ */
+
+static errno_t open_data_file(FILE** file, const char* mode)
+{
+    errno_t rez = fopen_s(file, parameters.bin_file_name, mode);
+
+    if ((rez != 0) && (errno == EACCES))
+    {
+        // Try again. The file may be temporarily locked.
+        for (size_t i = 0; i < 9; i++)
+        {
+            file_writer_message(false, ".");
+            sleep_ms(100);
+            rez = fopen_s(file, parameters.bin_file_name, mode);
+
+            if (rez == 0)
+            {
+                break;
+            }
+        }
+    }
+
+    return rez;
+}
+
+
+/***
+ * @brief Report that the binary file could not be created (errno is set).
+ */
+
+static void report_create_error(void)
+{
+    char err_string[256];
+    (void)strerror_s(err_string, sizeof(err_string), errno);
+    file_writer_message(false, "\n************************************************************");
+    file_writer_message(true, "\nCould not create file \"%s\": %s", parameters.bin_file_name, err_string);
+
+    if (logging_to_file())
+    {
+        file_writer_message(false, "\nCould not create file \"%s\": %s", parameters.bin_file_name, err_string);
+    }
+
+    file_writer_message(false, "\n************************************************************\n");
+}
+
+
+/***
+ * @brief Print a message to the console or to the log. The messages of the writer thread
+ *        (also from snapshot_file_append()) are saved and printed by the main thread
+ *        (file_writer_wait(), file_writer_stop()), so they are not mixed with the other
+ *        console and log output.
+ *
+ * @param log_message  true - log message (log_string()), false - console message
+ * @param format       printf() format string followed by the values
+ */
+
+void file_writer_message(bool log_message, const char* format, ...)
+{
+    char text[512];
+    va_list args;
+    va_start(args, format);
+    (void)vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    if (in_writer_thread)
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        writer_messages.push_back(std::make_pair(log_message, std::string(text)));
+    }
+    else if (log_message)
+    {
+        log_string("%s", text);
+    }
+    else
+    {
+        fputs(text, stdout);
+    }
+}
+
+
+/***
+ * @brief Print the messages saved by the writer thread (called by the main thread).
+ */
+
+static void print_writer_messages(void)
+{
+    std::vector<std::pair<bool, std::string>> messages;
+
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        messages.swap(writer_messages);
+    }
+
+    for (size_t i = 0; i < messages.size(); i++)
+    {
+        if (messages[i].first)
+        {
+            log_string("%s", messages[i].second.c_str());
+        }
+        else
+        {
+            fputs(messages[i].second.c_str(), stdout);
+        }
+    }
+}
+
+/*==== End of file ====*/
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    file_writer.h
+ * @author  B. Premzel
+ * @brief   Background thread writing the g_rtedbg structure snapshots to the binary
+ *          file (and container file). The data transfer from the embedded system does
+ *          not have to wait for the file write to finish.
+ */
+
+#ifndef _FILE_WRITER_H
+#define _FILE_WRITER_H
+
+#include <stdint.h>
+
+#define FILE_WRITER_BUFFERS     2U      // Number of snapshot buffers (double buffering)
+
+int  file_writer_prepare(void);
+int  file_writer_submit(const unsigned* data, unsigned size, uint64_t timestamp);
+int  file_writer_wait(void);
+int  file_writer_check(void);
+int  file_writer_stop(void);
+void file_writer_message(bool log_message, const char* format, ...);
+
+#endif  // _FILE_WRITER_H
+
+/*==== End of file ====*/
@@ -22,11 +22,40 @@
                                         // The send() function blocks only if no buffer space is available
                                         // within the transport system to hold the data to be transmitted.
 #define ERROR_DATA_TIMEOUT      50      // Max. time in ms to wait for a message following the 'O' type error message
+#define SOCKET_FLUSH_TIME        1      // Max. time in ms to wait for more data while flushing the socket
 
 #define DEFAULT_MESSAGE_SIZE  4096      // Default max. send message size (sent to the GDB server) if there is
                                         // no 'PacketSize' field in the capability data
 
 #define TCP_BUFF_LENGTH      65535      // The maximum TCP packet size including header
+#define INITIAL_BUFFER_SIZE   8192      // Message buffer size until the max. message sizes are known
+#define MESSAGE_BUFFER_RESERVE  16      // Message buffer space in addition to the max. message size
+
+#define MAX_PIPELINE_DEPTH      16      // Max. number of memory read requests sent to the GDB server
+                                        // before the first reply has to be received
+#define PIPELINE_BUFFER_BUDGET 65536    // Max. amount of reply data [bytes] in flight if the pipeline
+                                        // depth is determined automatically
+#define PIPELINE_DRAIN_TIME     50      // Time-out in ms for each outstanding reply that is discarded
+                                        // after an error in the pipelined mode
+
+#define MAX_GDB_CONNECTIONS      8      // Max. number of connections to the GDB server for parallel reads
+#define MIN_STRIPE_SIZE       4096      // Min. size of a block read over one connection [bytes]
+
+#define DEFAULT_FILL_COMMAND  "mww 0x%A 0x%V %N"    // Monitor command used to fill memory (OpenOCD syntax)
+                                        // if not defined with the -fill_cmd=xxx parameter
+#define MAX_FILL_COMMAND_LEN   200      // Max. length of the monitor fill command text
+#define MIN_FILL_LENGTH         64      // Shorter blocks are written instead of filled
+
+#define DEFAULT_TUNING_FILE "RTEgetData.tune"   // Packet size tuning results (-autotune)
+#define TUNING_MIN_PACKET_SIZE 256      // Smallest read packet size tested by the packet size tuning [bytes]
+#define TUNING_MAX_BLOCK_SIZE 65536     // Max. size of the block read with each packet size [bytes]
+#define TUNING_REPEAT_COUNT      3      // Number of block reads for each packet size (the fastest is used)
+#define TUNING_TOLERANCE        97      // A smaller packet size is selected if its transfer rate is at least
+                                        // TUNING_TOLERANCE % of the best rate
+#define TUNING_MODEL_ERROR       5      // Max. deviation of the latency model from the measured rates [%]
+                                        // for the extrapolation to larger packet sizes
+#define MAX_TUNING_STEPS        16      // Max. number of packet sizes tested
+#define MAX_TUNING_ENTRIES      64      // Max. number of GDB servers in the tuning file
 
 #endif  //__GDB_DEFS_H
 
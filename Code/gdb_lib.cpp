@@ -16,6 +16,10 @@
  * - Writing to the embedded system memory
  * - Other GDB-related operations
  *
+ * The state of a connection is held in a GdbSession object (see gdb_session.h).
+ * The gdb_xxx() functions at the end of the file use the default session of the
+ * calling thread.
+ *
  * Tested GDB servers:
  * - Segger J-LINK
  * - ST-LINK
@@ -34,44 +38,103 @@
 #include <stdint.h>
 #include <string.h>
 #include <cctype>
-#include "gdb_lib.h"
+#include "gdb_session.h"
 #include "logger.h"
 #include "cmd_line.h"
 #include "RTEgetData.h"
 #include "platform_compat.h"
+#include "hex_codec.h"
+#include "session_record.h"
 
 
- /*---------------- GLOBAL VARIABLES ------------------*/
-char message_buffer[TCP_BUFF_LENGTH];           // Buffer for TCP message send/receive
-
-static SOCKET gdb_socket = INVALID_SOCKET;
-static unsigned data_received;                  // Number of bytes received in the buffer
-static bool ack_mode_enabled = false;           // If true, send message acknowledgments
-static unsigned max_memo_read_packet_size;      // Maximum read_memory_packet() size
-static unsigned max_memo_write_packet_size;     // Maximum write_memory_packet() size
-static unsigned max_gdb_send_message_size;      // Maximum size of message that can be sent to the GDB server
-static unsigned max_gdb_recv_message_size;      // Maximum size of message that can be received from the GDB server
-clock_t app_start_time;                         // Time of connection to GDB server
-
+// Memory read request sent to the GDB server (pipelined mode)
+typedef struct
+{
+    unsigned offset;                            // Offset of the requested data from the start of block
+    unsigned length;                            // Number of bytes requested
+} read_request_t;
 
 /*---------------- Local functions ---------------*/
 static int get_hex_digit(const char * ptr);
-static int gdb_get_message(size_t timeout);
-static int read_memory_packet(unsigned char* buffer, unsigned int address, unsigned int length);
-static int write_memory_packet(const unsigned char* buffer, unsigned address, unsigned length);
-static int gdb_send_command(const char * command);
-static void gdb_send_ack(void);
-static void gdb_check_ack(void);
-static void calculate_max_message_sizes(void);
-static void print_O_type_message(void);
+static int hex_char_value(unsigned char c);
+static bool socket_timeout_error(void);
+static void set_timeout_error(void);
+static int prepare_fill_command(char* command, size_t size, unsigned address, unsigned pattern,
+                                unsigned length);
+static unsigned char escape_binary_data(const unsigned char* buffer, unsigned length, char* destination,
+    unsigned* escaped_length);
 static void print_remaining_messages(void);
-static int gdb_send(const char* msg, int length);
-static bool gdb_error_reported(void);
 static const char* get_core_content(char* message);
-static int parse_capability_data(const char* recvbuf);
-static int gdb_connect_socket(unsigned short gdb_port);
-static int gdb_check_server_capabilities(void);
-static int gdb_request_no_ack_mode(void);
+
+
+/***
+ * @brief Create a session that is not connected yet. The message buffers are enlarged
+ *        or reduced after the message sizes have been negotiated with the GDB server.
+ *        The server IP address and g_rtedbg address are taken from the command line
+ *        parameters - see set_target().
+ */
+
+GdbSession::GdbSession(void) :
+    message_buffer((char*)malloc(INITIAL_BUFFER_SIZE)),
+    message_buffer_size(INITIAL_BUFFER_SIZE),
+    send_buffer((char*)malloc(INITIAL_BUFFER_SIZE)),
+    send_buffer_size(INITIAL_BUFFER_SIZE),
+    server_ip_address(parameters.ip_address),
+    rtedbg_address(parameters.start_address),
+    gdb_socket(INVALID_SOCKET),
+    socket_library_started(false),
+    record_connection(0),
+    data_received(0),
+    packet_length(0),
+    data_pending(0),
+    pending_data_first_char(0),
+    pipeline_depth(1),
+    binary_read_enabled(false),
+    binary_write_enabled(false),
+    fill_command_state(FILL_CMD_UNKNOWN),
+    rle_packets(0),
+    rle_chars_saved(0),
+    ack_mode_enabled(false),
+    max_memo_read_packet_size(0),
+    read_packet_size_limit(0),
+    server_capabilities_hash(0),
+    max_memo_write_packet_size(0),
+    max_gdb_send_message_size(DEFAULT_MESSAGE_SIZE),
+    max_gdb_recv_message_size(DEFAULT_MESSAGE_SIZE)
+{
+}
+
+
+/***
+ * @brief Close the connection (if still open) and release the message buffers.
+ */
+
+GdbSession::~GdbSession(void)
+{
+    if (gdb_socket != INVALID_SOCKET)
+    {
+        cleanup();
+    }
+
+    free(message_buffer);
+    free(send_buffer);
+}
+
+
+/***
+ * @brief Define the GDB server IP address and the g_rtedbg structure address if they
+ *        differ from the command line parameters (multiple targets). Must be called
+ *        before connect_to_server().
+ *
+ * @param ip_address     GDB server IP address
+ * @param start_address  Address of the g_rtedbg structure
+ */
+
+void GdbSession::set_target(const char* ip_address, unsigned start_address)
+{
+    server_ip_address = ip_address;
+    rtedbg_address = start_address;
+}
 
 
 /***
@@ -83,33 +146,42 @@ static int gdb_request_no_ack_mode(void);
  *         RTE_ERROR - Could not connect to the GDB server
  */
 
-int gdb_connect(unsigned short gdb_port)
+int GdbSession::connect_to_server(unsigned short gdb_port)
 {
     last_error = ERR_NO_ERROR;
-    app_start_time = clock_ms();
+
+    if ((message_buffer == NULL) || (send_buffer == NULL))
+    {
+        log_string("\nCould not allocate memory buffer.", NULL);
+        return RTE_ERROR;
+    }
+
+    start_log_timer();
+    data_pending = 0;
     int res = gdb_connect_socket(gdb_port);
     if (res != RTE_OK)
     {
-        gdb_socket_cleanup();
+        cleanup();
         return RTE_ERROR;
     }
 
     ack_mode_enabled = true;
 
     // Check for initial acknowledgment from GDB server
-    res = recv(gdb_socket, message_buffer, sizeof(message_buffer), 0);
+    res = gdb_recv(message_buffer, message_buffer_size - 1U, SOCKET_FLUSH_TIME);
 
     if (res > 0)    // Data received
     {
         log_communication_text("Recv", message_buffer, res);
-        gdb_flush_socket();
+        flush_socket();
     }
 
     res = gdb_check_server_capabilities();
 
     if (res != RTE_OK)
     {
-        gdb_socket_cleanup();
+        cleanup();
+        log_flush();
 #ifdef _WIN32
         _fcloseall();
 #else
@@ -118,7 +190,23 @@ int gdb_connect(unsigned short gdb_port)
         return RTE_ERROR;
     }
 
-    return gdb_request_no_ack_mode();
+    res = gdb_request_no_ack_mode();
+
+    if ((res == RTE_OK) && binary_read_enabled)
+    {
+        check_binary_read_support();
+    }
+
+    if (res == RTE_OK)
+    {
+        check_binary_write_support();
+    }
+
+    // The monitor fill command is checked when it is used for the first time
+    bool fill_disabled = (parameters.fill_command != NULL) && (strcmp(parameters.fill_command, "none") == 0);
+    fill_command_state = fill_disabled ? FILL_CMD_NOT_AVAILABLE : FILL_CMD_UNKNOWN;
+
+    return res;
 }
 
 
@@ -131,7 +219,7 @@ int gdb_connect(unsigned short gdb_port)
  *         RTE_ERROR - Could not connect to the socket
  */
  
-int gdb_connect_socket(unsigned short gdb_port)
+int GdbSession::gdb_connect_socket(unsigned short gdb_port)
 {
     int res;
 #ifdef _WIN32
@@ -152,6 +240,8 @@ int gdb_connect_socket(unsigned short gdb_port)
         log_data("Winsock startup error %d\n", (long long)res);
         return RTE_ERROR;
     }
+
+    socket_library_started = true;
 #endif
 
     // Create a SOCKET for connecting to server
@@ -171,7 +261,7 @@ int gdb_connect_socket(unsigned short gdb_port)
     // The sockaddr_in structure specifies the address family,
     // IP address, and port of the server to be connected to.
     clientService.sin_family = AF_INET;
-    clientService.sin_addr.s_addr = inet_addr(parameters.ip_address);
+    clientService.sin_addr.s_addr = inet_addr(server_ip_address);
     clientService.sin_port = htons(gdb_port);
     // TODO: Replace inet_addr() with inet_pton() to support IPv4 and IPv6 addresses
     //       and make other necessary changes to make it work.
@@ -182,29 +272,34 @@ int gdb_connect_socket(unsigned short gdb_port)
     if (res == SOCKET_ERROR)
     {
         log_wsock_error("unable to connect to the GDB server.\n");
-        gdb_socket_cleanup();
+        cleanup();
         return RTE_ERROR;
     }
 
-    // Set receive timeout value for the gdb_socket.
-#ifdef _WIN32
-    DWORD timeout = 1;            // Minimal value to enable some kind of polling
-    (void)setsockopt(gdb_socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+    record_connection = session_record_connect();
 
-    // Set send timeout value for the gdb_socket.
-    timeout = DEFAULT_SEND_TIMEOUT;
-    (void)setsockopt(gdb_socket, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+    // Non-blocking socket - gdb_recv() and gdb_send() wait for the socket with poll()
+    // and process the data as soon as it arrives.
+#ifdef _WIN32
+    u_long non_blocking = 1;
+    res = ioctlsocket(gdb_socket, FIONBIO, &non_blocking);
 #else
-    struct timeval timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 1000;       // 1ms
-    (void)setsockopt(gdb_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-
-    timeout.tv_sec = DEFAULT_SEND_TIMEOUT / 1000;
-    timeout.tv_usec = (DEFAULT_SEND_TIMEOUT % 1000) * 1000;
-    (void)setsockopt(gdb_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int flags = fcntl(gdb_socket, F_GETFL, 0);
+    res = (flags < 0) ? SOCKET_ERROR : fcntl(gdb_socket, F_SETFL, flags | O_NONBLOCK);
 #endif
 
+    if (res == SOCKET_ERROR)
+    {
+        log_wsock_error("unable to set the non-blocking socket mode.\n");
+        cleanup();
+        return RTE_ERROR;
+    }
+
+    // Send the short request messages immediately (disable the Nagle algorithm)
+    int no_delay = 1;
+    (void)setsockopt(gdb_socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&no_delay, sizeof(no_delay));
+    request_quick_ack();
+
     log_timing("OK (%.1f ms)", &StartingTime);
     return RTE_OK;
 }
@@ -221,7 +316,7 @@ int gdb_connect_socket(unsigned short gdb_port)
  *          RTE_OK    - data was sent successfully
  */
 
-static int gdb_send(const char* msg, int length)
+int GdbSession::gdb_send(const char* msg, int length)
 {
     if ((msg == NULL) || (length <= 0))
     {
@@ -230,40 +325,177 @@ static int gdb_send(const char* msg, int length)
         return RTE_ERROR;
     }
 
-    int res = send(gdb_socket, msg, length, 0);
     log_communication_text("Send", msg, length);
+    clock_t start_time = clock_ms();
+    int data_sent = 0;
 
-    if (res == SOCKET_ERROR)
+    while (data_sent < length)
     {
-#ifdef _WIN32
-        DWORD wsock_err = WSAGetLastError();
+        int res = send(gdb_socket, msg + data_sent, length - data_sent, SEND_FLAGS);
 
-        if (wsock_err == WSAETIMEDOUT)
-#else
-        int wsock_err = errno;
+        if (res > 0)
+        {
+            session_record_event(record_connection, SESSION_SENT, msg + data_sent, (unsigned)res);
+            data_sent += res;
+            continue;
+        }
 
-        if (wsock_err == ETIMEDOUT)
-#endif
+        if (socket_timeout_error())
+        {
+            // No space in the socket send buffer - wait until the data can be sent
+            long time_left = DEFAULT_SEND_TIMEOUT - (long)(clock_ms() - start_time);
+            res = (time_left > 0) ? wait_for_socket(true, time_left) : 0;
+
+            if (res > 0)
+            {
+                continue;
+            }
+
+            if (res == 0)
+            {
+                set_timeout_error();
+            }
+        }
+
+        if (socket_timeout_error())
         {
-            last_error = ERR_SEND_TIMEOUT;
-            log_string(" - GDB Winsock send timeout. ", NULL);
+            if (data_sent > 0)
+            {
+                log_data(" - message not sent completely (only %llu). ", (long long)data_sent);
+                last_error = ERR_MSG_NOT_SENT_COMPLETELY;
+            }
+            else
+            {
+                last_error = ERR_SEND_TIMEOUT;
+                log_string(" - GDB Winsock send timeout. ", NULL);
+            }
         }
         else
         {
             last_error = ERR_SOCKET;
             log_wsock_error(" - GDB Winsock send error");
         }
+
         return RTE_ERROR;
     }
 
-    if (res != length)
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Receive data from the GDB server. Wait max. 'timeout' ms for the data to arrive.
+ *
+ * @param buffer   Pointer to the receive buffer
+ * @param length   Size of the receive buffer
+ * @param timeout  Max. waiting time [ms] (0 - return immediately if no data is available)
+ *
+ * @return Number of bytes received,
+ *         0 if the connection has been closed by the GDB server,
+ *         SOCKET_ERROR if no data has been received (socket_timeout_error() returns
+ *         true in case of time-out)
+ */
+
+int GdbSession::gdb_recv(char* buffer, unsigned length, long timeout)
+{
+    clock_t start_time = clock_ms();
+
+    for (;;)
     {
-        log_data(" - message not sent completely (only %llu). ", (long long)res);
-        last_error = ERR_MSG_NOT_SENT_COMPLETELY;
-        return RTE_ERROR;
+        int res = recv(gdb_socket, buffer, (int)length, 0);
+
+        if (res > 0)
+        {
+            session_record_event(record_connection, SESSION_RECEIVED, buffer, (unsigned)res);
+            request_quick_ack();
+            return res;
+        }
+
+        if ((res == 0) || !socket_timeout_error())
+        {
+            return res;
+        }
+
+        // No data available yet - wait until it arrives or the time runs out
+        long time_left = timeout - (long)(clock_ms() - start_time);
+
+        if (time_left <= 0)
+        {
+            set_timeout_error();
+            return SOCKET_ERROR;
+        }
+
+        if (wait_for_socket(false, time_left) == SOCKET_ERROR)
+        {
+            return SOCKET_ERROR;
+        }
     }
+}
 
-    return RTE_OK;
+
+/***
+ * @brief Wait until data can be received from or sent to the GDB server.
+ *
+ * @param wait_for_send  true - wait for free space in the socket send buffer,
+ *                       false - wait for the received data
+ * @param timeout        Max. waiting time [ms]
+ *
+ * @return >0 - socket is ready (or the connection has been closed or an error reported),
+ *          0 - time-out, SOCKET_ERROR - poll() error
+ */
+
+int GdbSession::wait_for_socket(bool wait_for_send, long timeout)
+{
+#ifdef _WIN32
+    WSAPOLLFD poll_data;
+#else
+    struct pollfd poll_data;
+#endif
+    poll_data.fd = gdb_socket;
+    poll_data.events = wait_for_send ? POLLOUT : POLLIN;
+    poll_data.revents = 0;
+
+#ifdef _WIN32
+    return WSAPoll(&poll_data, 1, (INT)timeout);
+#else
+    int res;
+
+    do
+    {
+        res = poll(&poll_data, 1, (int)timeout);
+    }
+    while ((res < 0) && (errno == EINTR));
+
+    return res;
+#endif
+}
+
+
+/***
+ * @brief Set the socket error code to time-out (checked by socket_timeout_error()).
+ */
+
+static void set_timeout_error(void)
+{
+#ifdef _WIN32
+    WSASetLastError(WSAETIMEDOUT);
+#else
+    errno = ETIMEDOUT;
+#endif
+}
+
+
+/***
+ * @brief Request immediate acknowledgment of the received data (Linux only).
+ *        The TCP_QUICKACK mode is not permanent and must be set again after each receive.
+ */
+
+void GdbSession::request_quick_ack(void)
+{
+#ifdef TCP_QUICKACK
+    int quick_ack = 1;
+    (void)setsockopt(gdb_socket, IPPROTO_TCP, TCP_QUICKACK, &quick_ack, sizeof(quick_ack));
+#endif
 }
 
 
@@ -274,7 +506,7 @@ static int gdb_send(const char* msg, int length)
  *         false - no error reported and message starts with '$'
  */
 
-static bool gdb_error_reported(void)
+bool GdbSession::gdb_error_reported(void)
 {
     if (message_buffer[0] != '$')
     {
@@ -321,42 +553,84 @@ static bool gdb_error_reported(void)
  * @brief Read memory packet from the embedded system memory.
  *        Maximal packet size depends on the GDB server type.
  * 
- * @param buffer  Buffer to which the data should be written
+ * @param buffer         Buffer to which the data should be written
+ * @param address        Address of data in the embedded system
+ * @param length         Length of memory block [bytes]
+ * @param bytes_received Number of bytes actually received (the GDB server may return
+ *                       less data than requested)
+ * 
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - could not read memory
+ */
+
+int GdbSession::read_memory_packet(unsigned char* buffer, unsigned int address, unsigned int length,
+    unsigned* bytes_received)
+{
+    if (send_read_memory_request(address, length) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    return receive_read_memory_reply(buffer, length, bytes_received);
+}
+
+
+/***
+ * @brief Send the memory read request to the GDB server.
+ *        The command is prepared in a local buffer because the message_buffer
+ *        may already contain replies to previous requests (pipelined mode).
+ * 
  * @param address Address of data in the embedded system
  * @param length  Length of memory block [bytes]
  * 
  * @return RTE_OK    - no error
- *         RTE_ERROR - could not read memory
+ *         RTE_ERROR - could not send the request
  */
 
-static int read_memory_packet(unsigned char* buffer, unsigned int address, unsigned int length)
+int GdbSession::send_read_memory_request(unsigned int address, unsigned int length)
 {
-    if (((length * 2 + 4) > TCP_BUFF_LENGTH) || (length == 0))
+    if ((read_reply_size(length) >= message_buffer_size) || (length == 0))
     {
         last_error = ERR_BAD_INPUT_DATA;
         return RTE_ERROR;
     }
 
-    // Prepare GDB command
-    sprintf_s(message_buffer, sizeof(message_buffer), "$m%08x,%02x", address, length);
+    // Prepare GDB command - 'x' = binary memory read, 'm' = hex memory read
+    char command[32];
+    sprintf_s(command, sizeof(command), "$%c%08x,%02x", binary_read_enabled ? 'x' : 'm', address, length);
     unsigned char sum = 0;
-    size_t buf_len = strlen(message_buffer);
+    size_t buf_len = strlen(command);
 
     // Calculate checksum
     for (size_t n = 1; n < buf_len; n++)
     {
-        sum += message_buffer[n];
+        sum += command[n];
     }
-    sprintf_s(&message_buffer[buf_len], 5, "#%02x", sum);       // Add checksum
+    sprintf_s(&command[buf_len], 5, "#%02x", sum);       // Add checksum
 
-    buf_len = strlen(message_buffer);
-    int res = gdb_send(message_buffer, (int)buf_len); // Send GDB command
-    if (res != RTE_OK)
-    {
-        return RTE_ERROR;
-    }
+    buf_len = strlen(command);
+    return gdb_send(command, (int)buf_len);     // Send GDB command
+}
+
+
+/***
+ * @brief Receive the reply to a memory read request and convert it to binary.
+ *        Reply to the 'm' request:  "$<hex data>#xx"
+ *        Reply to the 'x' request:  "$b<binary data>#xx" (characters '#', '$', '}' and '*'
+ *                                   are escaped with '}' followed by the character XOR 0x20)
+ * 
+ * @param buffer         Buffer to which the data should be written
+ * @param length         Length of memory block [bytes]
+ * @param bytes_received Number of bytes received - may be less than requested
+ * 
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - bad or no reply
+ */
 
-    res = gdb_get_message(0);               // Response (if OK) = "+$....hex_bytes...#xx"
+int GdbSession::receive_read_memory_reply(unsigned char* buffer, unsigned int length, unsigned* bytes_received)
+{
+    *bytes_received = 0;
+    int res = gdb_get_message(0);           // Response (if OK) = "+$....hex_bytes...#xx"
     if (res != RTE_OK)
     {
         return RTE_ERROR;
@@ -367,97 +641,485 @@ static int read_memory_packet(unsigned char* buffer, unsigned int address, unsig
         return RTE_ERROR;
     }
 
-    if (strchr(message_buffer, '*') != NULL)
-    {
-        log_string("\nError run length encoding not implemented. ", NULL);
-        last_error = ERR_RUN_LENGTH_ENCODING_NOT_IMPLEMENTED;
-        return RTE_ERROR;
-    }
+    // The message ends with "#xx" - binary data may contain zeros, i.e. no string functions
+    const unsigned data_length = packet_length - 4U;    // Without the '$' and '#xx'
+    const char* data = &message_buffer[1];
+    unsigned char sum;
+
+    int bytes_decoded = decode_reply_data(data, data_length, buffer, length, &sum);
 
     // Verify checksum
-    sum = 0;
-    unsigned int i;
+    res = get_hex_digit(&data[data_length + 1U]);
 
-    for (i = 0; i < (length * 2); i++)
+    if ((res < 0) || (sum != res))
     {
-        sum += message_buffer[i + 1];
+        log_string(" - bad message checksum. ", NULL);
+        last_error = ERR_BAD_MSG_CHECKSUM;
+        return RTE_ERROR;
     }
 
-    if (message_buffer[i + 1] != '#')
+    if (bytes_decoded <= 0)
     {
-        log_string(" - bad message format - '#' not found: %.50s. ", &message_buffer[i+1]);
-        last_error = ERR_BAD_MSG_FORMAT;    // Checksum not found
+        log_string(" - bad message format. ", NULL);
+        last_error = ERR_BAD_MSG_FORMAT;
         return RTE_ERROR;
     }
 
-    res = get_hex_digit(&message_buffer[i + 2]);
+    *bytes_received = (unsigned)bytes_decoded;
+    return RTE_OK;
+}
+
 
-    if ((res < 0) || (sum != res))
+/***
+ * @brief Convert the data part of the memory read reply to binary and calculate the checksum.
+ *        Reply to the 'm' request contains hex data and reply to the 'x' request contains
+ *        'b' followed by the escaped binary data.
+ *        Run-length encoded sequences ("c*n" = character 'c' repeated n - 29 more times)
+ *        are expanded directly into the buffer. The checksum is calculated over the
+ *        encoded data in the same pass.
+ * 
+ * @param data        Pointer to the data part of the reply (without the '$' and '#xx')
+ * @param data_length Length of the data part
+ * @param buffer      Buffer to which the data should be written
+ * @param length      Size of buffer [bytes]
+ * @param checksum    Checksum of the data part
+ * 
+ * @return Number of bytes written to the buffer or -1 in case of bad data
+ */
+
+int GdbSession::decode_reply_data(const char* data, unsigned data_length, unsigned char* buffer, unsigned length,
+    unsigned char* checksum)
+{
+    reply_decoder_t decoder = { buffer, length, 0, -1, false, false };
+    unsigned char sum = 0;
+    unsigned i = 0;
+    unsigned char previous_char = 0;
+    bool repeat_possible = false;           // Previous character may be repeated
+    bool run_length_encoded = false;
+
+    if (binary_read_enabled)
     {
-        log_string(" - bad message checksum. ", NULL);
-        last_error = ERR_BAD_MSG_CHECKSUM;
-        return RTE_ERROR;
+        if ((data_length == 0) || (data[0] != 'b'))
+        {
+            decoder.error = true;
+        }
+        else
+        {
+            sum = 'b';
+            i = 1;
+        }
     }
 
-    // Convert the hex data to binary and copy it to the 'buffer'
-    for (i = 0; i < length; i++)
+    while (i < data_length)
     {
-        int temp = get_hex_digit(&message_buffer[2 * i + 1]);
+        // Characters up to the next run-length encoded sequence
+        const char* rle_start = (const char*)memchr(&data[i], '*', data_length - i);
+        const unsigned literal_end = (rle_start != NULL) ? (unsigned)(rle_start - data) : data_length;
 
-        if (temp >= 0)
+        if (literal_end > i)
         {
-            buffer[i] = (unsigned char)temp;
+            sum += decode_reply_literals(&decoder, &data[i], literal_end - i);
+            previous_char = (unsigned char)data[literal_end - 1U];
+            repeat_possible = true;
+            i = literal_end;
+            continue;
         }
-        else
+
+        // Run-length encoding - '*' followed by the repeat count + 29
+        sum += '*';
+        i++;
+
+        if (!repeat_possible || (i >= data_length))
         {
-            log_string(" - bad message format. ", NULL);
-            last_error = ERR_BAD_MSG_FORMAT;
-            return RTE_ERROR;
+            decoder.error = true;
+            continue;
+        }
+
+        unsigned char count_char = (unsigned char)data[i];
+        sum += count_char;
+        i++;
+        int repeat_count = (int)count_char - 29;
+
+        // The shortest run is three repeats (' ') - shorter runs are not encoded
+        if (repeat_count < 3)
+        {
+            decoder.error = true;
+            continue;
+        }
+
+        for (int n = 0; n < repeat_count; n++)
+        {
+            decode_reply_char(&decoder, previous_char);
         }
+
+        rle_chars_saved += (unsigned)repeat_count - 2U;
+        run_length_encoded = true;
+        repeat_possible = false;
+    }
+
+    if (run_length_encoded)
+    {
+        rle_packets++;
+    }
+
+    *checksum = sum;
+
+    if (decoder.error || decoder.escape || (decoder.first_digit >= 0))
+    {
+        return -1;
     }
 
-    return RTE_OK;      // Received the requested number of data
+    return (int)decoder.bytes_decoded;
 }
 
 
 /***
- * @brief Read memory block from the embedded system memory.
- *        Maximum size depends on the maximum memory read packet size.
- *
- * @param buffer  Pointer to the buffer where the read data will be stored
- * @param address Starting address in the embedded system memory to read from
- * @param length  Number of bytes to read
- *
- * @return RTE_OK    - Operation successful
- *         RTE_ERROR - Error occurred (check last_error for details)
+ * @brief Decode a sequence of characters without run-length encoding.
+ *        Hex data is converted with the vectorized hex decoder if possible.
+ * 
+ * @param decoder  Decoder state
+ * @param chars    Characters to decode
+ * @param count    Number of characters
+ * 
+ * @return Sum of characters (modulo 256)
  */
 
-int gdb_read_memory(unsigned char* buffer, unsigned int address, unsigned int length)
+unsigned char GdbSession::decode_reply_literals(reply_decoder_t* decoder, const char* chars, unsigned count)
 {
-    unsigned data_read = 0;
-    int res;
+    unsigned char sum = 0;
+    unsigned i = 0;
 
-    do
+    if (!binary_read_enabled)
     {
-        unsigned packet_size = length - data_read;
-
-        if (packet_size > max_memo_read_packet_size)
+        if (decoder->first_digit >= 0)
         {
-            packet_size = max_memo_read_packet_size;
+            // Second digit of a byte started before the run-length encoded sequence
+            sum += (unsigned char)chars[0];
+            decode_reply_char(decoder, (unsigned char)chars[0]);
+            i = 1;
         }
 
-        res = read_memory_packet(buffer + data_read, address + data_read, packet_size);
+        const unsigned bytes = (count - i) / 2U;
 
-        if (res != RTE_OK)
+        if (!decoder->error && (bytes <= (decoder->length - decoder->bytes_decoded)))
         {
-            break;
+            unsigned char hex_sum;
+
+            if (!hex_decode(&chars[i], bytes, &decoder->buffer[decoder->bytes_decoded], &hex_sum))
+            {
+                decoder->error = true;
+            }
+
+            decoder->bytes_decoded += bytes;
+            sum += hex_sum;
+            i += 2U * bytes;
         }
+    }
 
-        data_read += packet_size;
+    for (; i < count; i++)
+    {
+        sum += (unsigned char)chars[i];
+        decode_reply_char(decoder, (unsigned char)chars[i]);
     }
-    while (data_read < length);
 
-    return res;
+    return sum;
+}
+
+
+/***
+ * @brief Decode one (already expanded) character of the memory read reply.
+ * 
+ * @param decoder  Decoder state
+ * @param c        Character to decode
+ */
+
+void GdbSession::decode_reply_char(reply_decoder_t* decoder, unsigned char c)
+{
+    if (decoder->error)
+    {
+        return;
+    }
+
+    if (binary_read_enabled)
+    {
+        if (decoder->escape)
+        {
+            c ^= 0x20;
+            decoder->escape = false;
+        }
+        else if (c == '}')
+        {
+            decoder->escape = true;
+            return;
+        }
+    }
+    else
+    {
+        int digit = hex_char_value(c);
+
+        if (digit < 0)
+        {
+            decoder->error = true;
+            return;
+        }
+
+        if (decoder->first_digit < 0)
+        {
+            decoder->first_digit = digit;
+            return;
+        }
+
+        c = (unsigned char)((decoder->first_digit << 4) | digit);
+        decoder->first_digit = -1;
+    }
+
+    if (decoder->bytes_decoded >= decoder->length)
+    {
+        decoder->error = true;      // More data than requested
+        return;
+    }
+
+    decoder->buffer[decoder->bytes_decoded++] = c;
+}
+
+
+/***
+ * @brief Convert a hexadecimal character to its value
+ * 
+ * @param c  Character to convert
+ * 
+ * @return Value (0-15) or -1 if the character is not a hex digit
+ */
+
+static int hex_char_value(unsigned char c)
+{
+    if ((c >= '0') && (c <= '9'))
+    {
+        return c - '0';
+    }
+
+    if ((c >= 'a') && (c <= 'f'))
+    {
+        return c - 'a' + 10;
+    }
+
+    if ((c >= 'A') && (c <= 'F'))
+    {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+
+/***
+ * @brief Max. size of reply to a memory read request.
+ * 
+ * @param length  Number of bytes requested
+ * 
+ * @return Reply size in bytes ('$', data and '#xx')
+ */
+
+unsigned GdbSession::read_reply_size(unsigned length)
+{
+    if (binary_read_enabled)
+    {
+        return length + 5U;         // '$', 'b', data and '#xx' (without escape characters)
+    }
+
+    return length * 2U + 4U;        // '$', hex data and '#xx'
+}
+
+
+/***
+ * @brief Read memory block from the embedded system memory.
+ *        Maximum size depends on the maximum memory read packet size.
+ *        Several read requests are sent to the GDB server before the replies are
+ *        processed if the pipelined mode is enabled.
+ *
+ * @param buffer  Pointer to the buffer where the read data will be stored
+ * @param address Starting address in the embedded system memory to read from
+ * @param length  Number of bytes to read
+ *
+ * @return RTE_OK    - Operation successful
+ *         RTE_ERROR - Error occurred (check last_error for details)
+ */
+
+int GdbSession::read_memory(unsigned char* buffer, unsigned int address, unsigned int length)
+{
+    int res;
+    rle_packets = 0;
+    rle_chars_saved = 0;
+
+    if ((pipeline_depth > 1U) && (length > max_memo_read_packet_size))
+    {
+        res = read_memory_pipelined(buffer, address, length);
+    }
+    else
+    {
+        res = read_memory_lock_step(buffer, address, length);
+    }
+
+    if (parameters.debug_mode && (rle_packets > 0))
+    {
+        log_data("\nRun-length encoded replies: %llu", (long long)rle_packets);
+        log_data(", characters saved: %llu\n", (long long)rle_chars_saved);
+    }
+
+    return res;
+}
+
+
+/***
+ * @brief Read memory block from the embedded system memory - the next read
+ *        request is sent after the reply to the previous one has been received.
+ *
+ * @param buffer  Pointer to the buffer where the read data will be stored
+ * @param address Starting address in the embedded system memory to read from
+ * @param length  Number of bytes to read
+ *
+ * @return RTE_OK    - Operation successful
+ *         RTE_ERROR - Error occurred (check last_error for details)
+ */
+
+int GdbSession::read_memory_lock_step(unsigned char* buffer, unsigned int address, unsigned int length)
+{
+    unsigned data_read = 0;
+    int res;
+
+    do
+    {
+        unsigned packet_size = length - data_read;
+
+        if (packet_size > max_memo_read_packet_size)
+        {
+            packet_size = max_memo_read_packet_size;
+        }
+
+        unsigned bytes_received;
+        res = read_memory_packet(buffer + data_read, address + data_read, packet_size, &bytes_received);
+
+        if (res != RTE_OK)
+        {
+            break;
+        }
+
+        data_read += bytes_received;    // The rest is requested again if a shorter block was received
+    }
+    while (data_read < length);
+
+    return res;
+}
+
+
+/***
+ * @brief Read memory block from the embedded system memory with up to 'pipeline_depth'
+ *        read requests in flight. The GDB server processes the requests in order and
+ *        the replies are copied to the buffer in the same order. If the server returns
+ *        less data than requested, the rest is requested again at the end of the queue.
+ *        The pipelined mode is disabled for the rest of the session if the server
+ *        does not reply properly. The rest of the data is then read in the lock-step mode.
+ *
+ * @param buffer  Pointer to the buffer where the read data will be stored
+ * @param address Starting address in the embedded system memory to read from
+ * @param length  Number of bytes to read
+ *
+ * @return RTE_OK    - Operation successful
+ *         RTE_ERROR - Error occurred (check last_error for details)
+ */
+
+int GdbSession::read_memory_pipelined(unsigned char* buffer, unsigned int address, unsigned int length)
+{
+    read_request_t requests[MAX_PIPELINE_DEPTH];    // Queue of requests in flight
+    unsigned first_request = 0;         // Index of the oldest request in the queue
+    unsigned requests_in_flight = 0;
+    unsigned data_requested = 0;        // Number of bytes requested from the GDB server
+
+    while ((data_requested < length) || (requests_in_flight > 0))
+    {
+        // Keep the pipeline full
+        while ((data_requested < length) && (requests_in_flight < pipeline_depth))
+        {
+            unsigned packet_size = length - data_requested;
+
+            if (packet_size > max_memo_read_packet_size)
+            {
+                packet_size = max_memo_read_packet_size;
+            }
+
+            if (send_read_memory_request(address + data_requested, packet_size) != RTE_OK)
+            {
+                return RTE_ERROR;
+            }
+
+            read_request_t* request = &requests[(first_request + requests_in_flight) % MAX_PIPELINE_DEPTH];
+            request->offset = data_requested;
+            request->length = packet_size;
+            data_requested += packet_size;
+            requests_in_flight++;
+        }
+
+        read_request_t request = requests[first_request];
+        first_request = (first_request + 1U) % MAX_PIPELINE_DEPTH;
+        requests_in_flight--;
+
+        unsigned bytes_received;
+
+        if (receive_read_memory_reply(buffer + request.offset, request.length, &bytes_received) != RTE_OK)
+        {
+            if ((last_error == ERR_CONNECTION_CLOSED) || (last_error == ERR_SOCKET))
+            {
+                return RTE_ERROR;
+            }
+
+            // Discard the replies to the outstanding requests and continue in the lock-step mode
+            log_string("\nPipelined read failed - switching to the lock-step mode. ", NULL);
+            pipeline_depth = 1;
+            unsigned restart_offset = request.offset;
+
+            for (unsigned i = 0; i < requests_in_flight; i++)
+            {
+                // The rest of a short reply may have been requested after the failed request
+                const read_request_t* outstanding = &requests[(first_request + i) % MAX_PIPELINE_DEPTH];
+
+                if (outstanding->offset < restart_offset)
+                {
+                    restart_offset = outstanding->offset;
+                }
+            }
+
+            for (unsigned i = 0; i < requests_in_flight; i++)
+            {
+                if (gdb_get_message(PIPELINE_DRAIN_TIME) != RTE_OK)
+                {
+                    break;
+                }
+            }
+
+            flush_socket();
+            last_error = ERR_NO_ERROR;
+
+            return read_memory_lock_step(buffer + restart_offset, address + restart_offset,
+                length - restart_offset);
+        }
+
+        if (bytes_received < request.length)
+        {
+            // Short reply - request the rest of the block
+            request.offset += bytes_received;
+            request.length -= bytes_received;
+
+            if (send_read_memory_request(address + request.offset, request.length) != RTE_OK)
+            {
+                return RTE_ERROR;
+            }
+
+            requests[(first_request + requests_in_flight) % MAX_PIPELINE_DEPTH] = request;
+            requests_in_flight++;
+        }
+    }
+
+    return RTE_OK;
 }
 
 
@@ -473,7 +1135,7 @@ int gdb_read_memory(unsigned char* buffer, unsigned int address, unsigned int le
  *         RTE_ERROR - Error occurred (check last_error for details)
  */
 
-int gdb_write_memory(const unsigned char* buffer, unsigned address, unsigned length)
+int GdbSession::write_memory(const unsigned char* buffer, unsigned address, unsigned length)
 {
     unsigned data_written = 0;
     int res;
@@ -487,6 +1149,12 @@ int gdb_write_memory(const unsigned char* buffer, unsigned address, unsigned len
             packet_size = max_memo_write_packet_size;
         }
 
+        if (binary_write_enabled)
+        {
+            // Escaped characters take two bytes in the message
+            packet_size = binary_write_length(buffer + data_written, packet_size);
+        }
+
         res = write_memory_packet(buffer + data_written, address + data_written, packet_size);
 
         if (res != RTE_OK)
@@ -502,9 +1170,206 @@ int gdb_write_memory(const unsigned char* buffer, unsigned address, unsigned len
 }
 
 
+/***
+ * @brief Fill a memory block in the embedded CPU with a 32-bit pattern.
+ *        The GDB server monitor fill command (-fill_cmd=xxx, OpenOCD "mww" by default)
+ *        is used if available, so only the command is transferred instead of the
+ *        complete block. The block is written with memory write packets otherwise.
+ *
+ * @param address  Starting address in the embedded system's memory
+ * @param pattern  Value written to every word of the block
+ * @param length   Number of bytes to fill (multiple of 4)
+ *
+ * @return RTE_OK    - Operation successful
+ *         RTE_ERROR - Error occurred (check last_error for details)
+ */
+
+int GdbSession::fill_memory(unsigned address, unsigned pattern, unsigned length)
+{
+    if ((fill_command_state != FILL_CMD_NOT_AVAILABLE) && (length >= MIN_FILL_LENGTH))
+    {
+        if (fill_with_monitor_command(address, pattern, length) == RTE_OK)
+        {
+            return RTE_OK;
+        }
+
+        fill_command_state = FILL_CMD_NOT_AVAILABLE;
+        log_string("\nMonitor fill command not available - the data will be written. ", NULL);
+        last_error = ERR_NO_ERROR;
+        flush_socket();
+    }
+
+    unsigned* buffer = (unsigned*)malloc(length);
+
+    if (buffer == NULL)
+    {
+        log_string("\nCould not allocate memory buffer.", NULL);
+        return RTE_ERROR;
+    }
+
+    for (unsigned i = 0; i < length / 4U; i++)
+    {
+        buffer[i] = pattern;
+    }
+
+    int res = write_memory((const unsigned char*)buffer, address, length);
+    free(buffer);
+    return res;
+}
+
+
+/***
+ * @brief Fill a memory block with the monitor fill command. The first time the command
+ *        is used after connecting to the GDB server, the words at both ends of the block
+ *        are set to a different value before the fill and checked afterwards. Some GDB
+ *        servers reply with "OK" to unknown monitor commands.
+ *
+ * @param address  Starting address in the embedded system's memory
+ * @param pattern  Value written to every word of the block
+ * @param length   Number of bytes to fill (multiple of 4)
+ *
+ * @return RTE_OK    - Memory filled
+ *         RTE_ERROR - The command failed or did not change the memory
+ */
+
+int GdbSession::fill_with_monitor_command(unsigned address, unsigned pattern, unsigned length)
+{
+    char text[MAX_FILL_COMMAND_LEN + 1];
+
+    if (prepare_fill_command(text, sizeof(text), address, pattern, length) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    bool check_fill = (fill_command_state == FILL_CMD_UNKNOWN);
+    unsigned end_words[2] = { ~pattern, ~pattern };
+    unsigned last_word = address + length - 4U;
+
+    if (check_fill)
+    {
+        if ((write_memory((const unsigned char*)&end_words[0], address, 4U) != RTE_OK)
+            || (write_memory((const unsigned char*)&end_words[1], last_word, 4U) != RTE_OK))
+        {
+            return RTE_ERROR;
+        }
+    }
+
+    // Monitor commands are sent hex encoded: "qRcmd,<hex encoded command text>"
+    char command[2 * MAX_FILL_COMMAND_LEN + 8];
+    unsigned text_length = (unsigned)strlen(text);
+    memcpy(command, "qRcmd,", 6U);
+    (void)hex_encode((const unsigned char*)text, text_length, &command[6]);
+    command[6 + 2 * text_length] = '\0';
+
+    log_string("\nMonitor command \"%s\"", text);
+
+    if (execute_command(command) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    last_error = ERR_NO_ERROR;      // Time-out while waiting for more 'O' messages
+
+    if (check_fill)
+    {
+        if ((read_memory((unsigned char*)&end_words[0], address, 4U) != RTE_OK)
+            || (read_memory((unsigned char*)&end_words[1], last_word, 4U) != RTE_OK)
+            || (end_words[0] != pattern) || (end_words[1] != pattern))
+        {
+            return RTE_ERROR;
+        }
+
+        fill_command_state = FILL_CMD_AVAILABLE;
+    }
+
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Prepare the monitor fill command text from the template (-fill_cmd=xxx).
+ *        Placeholders: %A - address (hex), %V - pattern (hex), %N - number of words,
+ *        %L - number of bytes, %% - percent character.
+ *
+ * @param command  Buffer for the command text
+ * @param size     Size of the buffer
+ * @param address  Starting address in the embedded system's memory
+ * @param pattern  Value written to every word of the block
+ * @param length   Number of bytes to fill
+ *
+ * @return RTE_OK    - Command text prepared
+ *         RTE_ERROR - Bad template or command text too long
+ */
+
+static int prepare_fill_command(char* command, size_t size, unsigned address, unsigned pattern,
+                                unsigned length)
+{
+    const char* fill_template =
+        (parameters.fill_command != NULL) ? parameters.fill_command : DEFAULT_FILL_COMMAND;
+    size_t command_length = 0;
+
+    while (*fill_template != '\0')
+    {
+        char value[16];
+
+        if (*fill_template == '%')
+        {
+            switch (fill_template[1])
+            {
+                case 'A':
+                    sprintf_s(value, sizeof(value), "%08X", address);
+                    break;
+
+                case 'V':
+                    sprintf_s(value, sizeof(value), "%08X", pattern);
+                    break;
+
+                case 'N':
+                    sprintf_s(value, sizeof(value), "%u", length / 4U);
+                    break;
+
+                case 'L':
+                    sprintf_s(value, sizeof(value), "%u", length);
+                    break;
+
+                case '%':
+                    sprintf_s(value, sizeof(value), "%%");
+                    break;
+
+                default:
+                    log_string("\nUnknown placeholder in the fill command \"%s\".", fill_template);
+                    return RTE_ERROR;
+            }
+
+            fill_template += 2;
+        }
+        else
+        {
+            value[0] = *fill_template++;
+            value[1] = '\0';
+        }
+
+        size_t value_length = strlen(value);
+
+        if ((command_length + value_length) >= size)
+        {
+            log_string("\nThe fill command is too long.", NULL);
+            return RTE_ERROR;
+        }
+
+        memcpy(&command[command_length], value, value_length);
+        command_length += value_length;
+    }
+
+    command[command_length] = '\0';
+    return (command_length > 0) ? RTE_OK : RTE_ERROR;
+}
+
+
 /***
  * @brief Write the contents of a memory packet to the memory in the embedded CPU.
- *        Maximal packet size depends on the GDB server type.
+ *        The binary 'X' packet is used if the GDB server supports it, otherwise
+ *        the hex 'M' packet. Maximal packet size depends on the GDB server type.
  * 
  * @param buffer  Pointer to the data that should be written to the specified address
  * @param address Address of data in the embedded system
@@ -514,37 +1379,43 @@ int gdb_write_memory(const unsigned char* buffer, unsigned address, unsigned len
  *         RTE_ERROR - Data not written (check last_error for details)
  */
 
-static int write_memory_packet(const unsigned char * buffer, unsigned address, unsigned length)
+int GdbSession::write_memory_packet(const unsigned char * buffer, unsigned address, unsigned length)
 {
-    if (((length * 2 + 16 + 4) > TCP_BUFF_LENGTH) || (length == 0))
+    if ((length == 0) || (length > max_memo_write_packet_size)
+        || (binary_write_enabled && (binary_write_length(buffer, length) != length)))
     {
         last_error = ERR_BAD_INPUT_DATA;
         return RTE_ERROR;
     }
 
-    sprintf_s(message_buffer, sizeof(message_buffer), "$M%08X,%04X:", address, length);
-    char * position = &message_buffer[16];
+    sprintf_s(send_buffer, send_buffer_size, "$%c%08X,%04X:", binary_write_enabled ? 'X' : 'M',
+        address, length);
+    unsigned char sum = 0;
+    unsigned data_length;
 
-    for (unsigned i = 0; i < length; i++)
+    for (unsigned i = 1; i < 16; i++)
     {
-        sprintf_s(position, (size_t)(&message_buffer[TCP_BUFF_LENGTH] - position),
-            "%02X", *buffer++);
-        position += 2;
+        sum += send_buffer[i];
     }
 
-    const unsigned data_size = 15 + 2 * length;
-    unsigned char sum = 0;
-    position = &message_buffer[1];
-
-    for (unsigned i = 0; i < data_size; i++)
+    if (binary_write_enabled)
+    {
+        // Copy the data with escaped special characters and add their checksum
+        sum += escape_binary_data(buffer, length, &send_buffer[16], &data_length);
+    }
+    else
     {
-        sum += *position++;
+        // Convert the data to hex and add the checksum of hex characters
+        sum += hex_encode(buffer, length, &send_buffer[16]);
+        data_length = 2 * length;
     }
 
-    sprintf_s(position, (size_t)(&message_buffer[TCP_BUFF_LENGTH] - position), "#%02X", sum);
+    char * position = &send_buffer[16 + data_length];
+
+    sprintf_s(position, (size_t)(&send_buffer[send_buffer_size] - position), "#%02X", sum);
 
-    unsigned msg_len = (unsigned)(position + 3 - message_buffer);
-    if (gdb_send(message_buffer, msg_len) != RTE_OK)
+    unsigned msg_len = (unsigned)(position + 3 - send_buffer);
+    if (gdb_send(send_buffer, msg_len) != RTE_OK)
     {
         return RTE_ERROR;
     }
@@ -571,7 +1442,80 @@ static int write_memory_packet(const unsigned char * buffer, unsigned address, u
 
 
 /***
- * @brief Receive a message from the GDB server
+ * @brief Number of bytes from the buffer that fit into a binary memory write packet.
+ *        Characters '#', '$', '}' and '*' are escaped and take two bytes in the packet.
+ *
+ * @param buffer  Pointer to the data
+ * @param length  Max. number of bytes to write (max_memo_write_packet_size or less)
+ *
+ * @return Number of bytes whose escaped data fits into max_memo_write_packet_size bytes
+ */
+
+unsigned GdbSession::binary_write_length(const unsigned char* buffer, unsigned length)
+{
+    unsigned packet_size = 0;
+    unsigned count = 0;
+
+    while (count < length)
+    {
+        unsigned char c = buffer[count];
+        unsigned size = ((c == '#') || (c == '$') || (c == '}') || (c == '*')) ? 2U : 1U;
+
+        if ((packet_size + size) > max_memo_write_packet_size)
+        {
+            break;
+        }
+
+        packet_size += size;
+        count++;
+    }
+
+    return count;
+}
+
+
+/***
+ * @brief Copy the data to the binary memory write packet. Characters '#', '$', '}' and '*'
+ *        are escaped with '}' followed by the original character XOR 0x20.
+ *
+ * @param buffer          Pointer to the data
+ * @param length          Number of bytes to copy
+ * @param destination     Pointer to the data part of the message
+ * @param escaped_length  Number of characters written to the message
+ *
+ * @return Sum of the characters written to the message (modulo 256)
+ */
+
+static unsigned char escape_binary_data(const unsigned char* buffer, unsigned length, char* destination,
+    unsigned* escaped_length)
+{
+    unsigned char sum = 0;
+    char* position = destination;
+
+    for (unsigned i = 0; i < length; i++)
+    {
+        unsigned char c = buffer[i];
+
+        if ((c == '#') || (c == '$') || (c == '}') || (c == '*'))
+        {
+            *position++ = '}';
+            sum += (unsigned char)'}';
+            c ^= 0x20U;
+        }
+
+        *position++ = (char)c;
+        sum += c;
+    }
+
+    *escaped_length = (unsigned)(position - destination);
+    return sum;
+}
+
+
+/***
+ * @brief Receive a message from the GDB server.
+ *        The data received after the end of the message (replies to the next requests
+ *        in the pipelined mode) remains in the buffer and is processed on the next call.
  * 
  * @param timeout  Max. waiting time for a message [ms]
  * 
@@ -579,23 +1523,73 @@ static int write_memory_packet(const unsigned char * buffer, unsigned address, u
  *         RTE_ERROR - message not received
  */
 
-static int gdb_get_message(size_t timeout)
+int GdbSession::gdb_get_message(size_t timeout)
 {
     clock_t start_time = clock_ms();
-    data_received = 0;
+    LARGE_INTEGER wait_start_time;
+
+    if (parameters.debug_mode)
+    {
+        start_timer(&wait_start_time);
+    }
 
     if (timeout == 0)
     {
         timeout = RECV_TIMEOUT;
     }
 
-    char * msg_ptr = message_buffer;
-    *msg_ptr = 0;
-    const unsigned max_len = sizeof(message_buffer);
+    // Move the data received after the previous message to the start of the buffer
+    if (data_pending > 0)
+    {
+        message_buffer[packet_length] = pending_data_first_char;
+        memmove(message_buffer, &message_buffer[packet_length], data_pending);
+    }
+
+    data_received = data_pending;
+    data_pending = 0;
+    packet_length = 0;
+    message_buffer[data_received] = 0;
+
+    const unsigned max_len = message_buffer_size - 1U;     // Leave space for the string terminator
+    unsigned data_checked = 0;              // Number of bytes already checked for the '#' character
+    const char* end_of_data = NULL;         // Position of the '#' character
 
     for(;;)
     {
-        int res = recv(gdb_socket, msg_ptr, max_len - data_received, 0);
+        if ((end_of_data == NULL) && (data_received > data_checked))
+        {
+            end_of_data = (const char*)memchr(
+                &message_buffer[data_checked], '#', data_received - data_checked);
+            data_checked = data_received;
+        }
+
+        // Check message - shortest regular message is '$#xx'
+        if ((end_of_data != NULL) && (end_of_data + 3 <= &message_buffer[data_received]))
+        {
+            gdb_send_ack();
+            packet_length = (unsigned)(end_of_data + 3 - message_buffer);
+            data_pending = data_received - packet_length;
+            pending_data_first_char = message_buffer[packet_length];
+            message_buffer[packet_length] = 0;  // Terminate the string
+
+            if (parameters.debug_mode)
+            {
+                // Time from the start of waiting until the complete message has been received
+                log_timing("              [Wait: %.3f ms]\n", &wait_start_time);
+            }
+
+            return RTE_OK;
+        }
+
+        if (data_received >= max_len)
+        {
+            log_data(" - buffer index overflow: %u", (long long)data_received);
+            return RTE_ERROR;
+        }
+
+        long time_left = (long)timeout - (long)(clock_ms() - start_time);
+        int res = gdb_recv(&message_buffer[data_received], max_len - data_received,
+            (time_left > 0) ? time_left : 0);
 
         if (res == 0)
         {
@@ -608,47 +1602,41 @@ static int gdb_get_message(size_t timeout)
 
         if (res < 0)        // Error reported?
         {
-#ifdef _WIN32
-            int sock_err = WSAGetLastError();
-            if (sock_err != WSAETIMEDOUT)
-#else
-            int sock_err = errno;
-            if (sock_err != ETIMEDOUT)
-#endif
+            if (!socket_timeout_error())
             {
                 last_error = ERR_SOCKET;
                 return RTE_ERROR;
             }
 
-            if ((clock_ms() - start_time) > timeout)
-            {
-                log_string(" - time out error. ", NULL);
-                message_buffer[data_received] = 0;  // Terminate the string
-                last_error = ERR_RCV_TIMEOUT;
-                return RTE_ERROR;
-            }
-
-            continue;
+            log_string(" - time out error. ", NULL);
+            message_buffer[data_received] = 0;  // Terminate the string
+            last_error = ERR_RCV_TIMEOUT;
+            return RTE_ERROR;
         }
 
-        log_communication_text("Recv", msg_ptr, res);
-        msg_ptr += res;
+        log_communication_text("Recv", &message_buffer[data_received], res);
         data_received += res;
+    }
+}
 
-        if (data_received >= (sizeof(message_buffer) - 1U))
-        {
-            log_data(" - buffer index overflow: %u", (long long)data_received);
-            return RTE_ERROR;
-        }
 
-        // Check message - shortest regular message is '$#xx'
-        if ((data_received >= 4U) && (message_buffer[data_received - 3U] == '#'))
-        {
-            gdb_send_ack();
-            message_buffer[data_received] = 0;  // Terminate the string
-            return RTE_OK;
-        }
-    }
+/***
+ * @brief Check if the last socket operation failed because of the timeout.
+ *        The non-blocking socket functions report EWOULDBLOCK (EAGAIN) if no data
+ *        is available, gdb_recv() reports ETIMEDOUT if the waiting time has elapsed.
+ * 
+ * @return true  - timeout
+ *         false - other error
+ */
+
+static bool socket_timeout_error(void)
+{
+#ifdef _WIN32
+    int error = WSAGetLastError();
+    return (error == WSAETIMEDOUT) || (error == WSAEWOULDBLOCK);
+#else
+    return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ETIMEDOUT);
+#endif
 }
 
 
@@ -704,7 +1692,7 @@ static int get_hex_digit(const char * ptr)
  * @return RTE_OK on success, RTE_ERROR on failure
  */
 
-static int gdb_send_command(const char * command)
+int GdbSession::gdb_send_command(const char * command)
 {
     char sendbuff[1024U];
     size_t len = strlen(command);
@@ -741,7 +1729,7 @@ static int gdb_send_command(const char * command)
  * @return RTE_OK on success, RTE_ERROR if NoAckMode is not supported
  */
 
-static int parse_capability_data(const char * recvbuf)
+int GdbSession::parse_capability_data(const char * recvbuf)
 {
     // Check if GDB server supports the QStartNoAckMode
     if (strstr(recvbuf, "QStartNoAckMode+") == NULL)
@@ -750,6 +1738,14 @@ static int parse_capability_data(const char * recvbuf)
         return RTE_ERROR;
     }
 
+    // The reply identifies the server type and version (used by the packet size tuning)
+    server_capabilities_hash = 2166136261U;     // FNV-1a hash
+
+    for (const char* p = recvbuf; *p != '\0'; p++)
+    {
+        server_capabilities_hash = (server_capabilities_hash ^ (unsigned char)*p) * 16777619U;
+    }
+
     // Determine max. message size that can be received by the GDB server
     max_gdb_send_message_size = DEFAULT_MESSAGE_SIZE;
     const char * text_position = strstr(recvbuf, "PacketSize=");
@@ -778,7 +1774,16 @@ static int parse_capability_data(const char * recvbuf)
         max_gdb_send_message_size = DEFAULT_MESSAGE_SIZE;
     }
 
+    // Binary memory read ('x' packet) support - checked with a test read after connecting
+    binary_read_enabled = (strstr(recvbuf, "binary-upload+") != NULL);
+
+    if (binary_read_enabled)
+    {
+        log_string(", binary memory read", NULL);
+    }
+
     calculate_max_message_sizes();
+    log_data(", read pipeline depth %llu", (long long)pipeline_depth);
 
     return RTE_OK;
 }
@@ -788,7 +1793,7 @@ static int parse_capability_data(const char * recvbuf)
  * @brief Calculate max. message sizes for the communication with the GDB server.
  */
 
-static void calculate_max_message_sizes(void)
+void GdbSession::calculate_max_message_sizes(void)
 {
     if (max_gdb_send_message_size > TCP_BUFF_LENGTH)
     {
@@ -807,6 +1812,8 @@ static void calculate_max_message_sizes(void)
         }
     }
 
+    allocate_buffers();
+
     /* Calculate the maximal read and write memory size (bytes).
      * Note: The present library implementation can not handle TCP messages with
      * a length over 65535 bytes -> max. possible read_memory size = (65535 - 4) / 2.
@@ -814,11 +1821,190 @@ static void calculate_max_message_sizes(void)
      * Size is made divisible by 4 because some debug probes transfer data more
      * slowly when it is not.
      */
-    max_memo_read_packet_size = ((max_gdb_recv_message_size - 4) / 8) * 4;
-        // Read packet: '$' at the start and checksum '#xx' at the end (no zero at end of string)
+    if (binary_read_enabled)
+    {
+        max_memo_read_packet_size = ((max_gdb_recv_message_size - 5) / 4) * 4;
+            // Read packet: '$b' at the start and checksum '#xx' at the end. The GDB server returns
+            // less data if the escaped data does not fit into the message.
+
+        if (max_memo_read_packet_size > (((message_buffer_size - 6) / 8) * 4))
+        {
+            // All bytes escaped must still fit into the receive buffer
+            max_memo_read_packet_size = ((message_buffer_size - 6) / 8) * 4;
+        }
+    }
+    else
+    {
+        max_memo_read_packet_size = ((max_gdb_recv_message_size - 4) / 8) * 4;
+            // Read packet: '$' at the start and checksum '#xx' at the end (no zero at end of string)
+    }
+
+    read_packet_size_limit = max_memo_read_packet_size;
+
+    if (binary_write_enabled)
+    {
+        max_memo_write_packet_size = ((max_gdb_send_message_size - 16 - 4) / 4) * 4;
+            // Write packet: '$Xxxxxxxxx,xxxx:' at the start + '#xx' & zero at the end of string.
+            // Less data is sent in a packet if some bytes have to be escaped.
+    }
+    else
+    {
+        max_memo_write_packet_size = ((max_gdb_send_message_size - 16 - 4) / 8) * 4;
+            // Write packet: '$Mxxxxxxxx,xxxx:' at the start + '#xx' & zero at the end of string
+    }
+
+    calculate_pipeline_depth();
+}
+
+
+/***
+ * @brief Calculate the number of memory read requests sent to the GDB server before
+ *        the replies are processed (depends on the read packet size if not defined
+ *        with the -pipeline=N argument).
+ */
+
+void GdbSession::calculate_pipeline_depth(void)
+{
+    pipeline_depth = parameters.pipeline_depth;
+
+    if (pipeline_depth == 0)
+    {
+        // Keep approximately PIPELINE_BUFFER_BUDGET bytes of reply data in flight
+        pipeline_depth = PIPELINE_BUFFER_BUDGET / read_reply_size(max_memo_read_packet_size);
+
+        if (pipeline_depth < 2U)
+        {
+            pipeline_depth = 2U;
+        }
+
+        if (pipeline_depth > MAX_PIPELINE_DEPTH)
+        {
+            pipeline_depth = MAX_PIPELINE_DEPTH;
+        }
+    }
+}
+
+
+/***
+ * @brief Resize the message buffers according to the max. message sizes.
+ *        The receive buffer must hold the longest reply (all bytes escaped in the
+ *        binary mode) and the string terminator. The max. message sizes are reduced
+ *        if a buffer cannot be enlarged.
+ */
+
+void GdbSession::allocate_buffers(void)
+{
+    unsigned recv_factor = binary_read_enabled ? 2U : 1U;
+    unsigned recv_size = recv_factor * max_gdb_recv_message_size + MESSAGE_BUFFER_RESERVE;
+    unsigned send_size = max_gdb_send_message_size + MESSAGE_BUFFER_RESERVE;
+    bool allocation_failed = false;
+
+    if (recv_size <= data_received)
+    {
+        recv_size = data_received + 1U;     // Keep the data not processed yet
+    }
+
+    if (recv_size != message_buffer_size)
+    {
+        char* buffer = (char*)realloc(message_buffer, recv_size);
+
+        if (buffer != NULL)
+        {
+            message_buffer = buffer;
+            message_buffer_size = recv_size;
+        }
+        else
+        {
+            allocation_failed = true;
+        }
+    }
+
+    if (send_size != send_buffer_size)
+    {
+        char* buffer = (char*)realloc(send_buffer, send_size);
+
+        if (buffer != NULL)
+        {
+            send_buffer = buffer;
+            send_buffer_size = send_size;
+        }
+        else
+        {
+            allocation_failed = true;
+        }
+    }
+
+    if (allocation_failed)
+    {
+        log_string("\nCould not allocate memory buffer - the message size has been reduced.", NULL);
+
+        if ((recv_factor * max_gdb_recv_message_size + MESSAGE_BUFFER_RESERVE) > message_buffer_size)
+        {
+            max_gdb_recv_message_size = (message_buffer_size - MESSAGE_BUFFER_RESERVE) / recv_factor;
+        }
+
+        if ((max_gdb_send_message_size + MESSAGE_BUFFER_RESERVE) > send_buffer_size)
+        {
+            max_gdb_send_message_size = send_buffer_size - MESSAGE_BUFFER_RESERVE;
+        }
+    }
+}
+
+
+/***
+ * @brief Check if the binary memory read ('x' packet) is really supported by reading
+ *        zero bytes from the start of the data logging structure. GDB servers that do
+ *        not support it return an empty reply. The hex memory read ('m' packet) is
+ *        used in such a case.
+ */
+
+void GdbSession::check_binary_read_support(void)
+{
+    char command[32];
+    sprintf_s(command, sizeof(command), "x%08x,0", rtedbg_address);
+
+    if ((gdb_send_command(command) == RTE_OK) && (gdb_get_message(0) == RTE_OK))
+    {
+        // Expected reply: "$b#62" (no data) or an error message if the address is not accessible
+        if ((message_buffer[1] == 'b') || (message_buffer[1] == 'E'))
+        {
+            return;
+        }
+    }
+
+    log_string("\nBinary memory read not supported - using hex memory read. ", NULL);
+    last_error = ERR_NO_ERROR;
+    binary_read_enabled = false;
+    flush_socket();
+    calculate_max_message_sizes();
+}
+
+
+/***
+ * @brief Check if the binary memory write ('X' packet) is supported by writing zero bytes
+ *        to the start of the data logging structure. GDB servers that do not support it
+ *        return an empty reply. The hex memory write ('M' packet) is used in such a case.
+ */
+
+void GdbSession::check_binary_write_support(void)
+{
+    char command[32];
+    sprintf_s(command, sizeof(command), "X%08x,0:", rtedbg_address);
+    binary_write_enabled = false;
+
+    if ((gdb_send_command(command) == RTE_OK) && (gdb_get_message(0) == RTE_OK))
+    {
+        // Expected reply: "$OK#9a" or an error message if the address is not accessible
+        if ((message_buffer[1] == 'O') || (message_buffer[1] == 'E'))
+        {
+            binary_write_enabled = true;
+            log_string(", binary memory write", NULL);
+        }
+    }
 
-    max_memo_write_packet_size = ((max_gdb_send_message_size - 16 - 4) / 8) * 4;
-        // Write packet: '$Mxxxxxxxx,xxxx:' at the start + '#xx' & zero at the end of string
+    last_error = ERR_NO_ERROR;
+    flush_socket();
+    calculate_max_message_sizes();
 }
 
 
@@ -830,7 +2016,7 @@ static void calculate_max_message_sizes(void)
  *         RTE_ERROR - an error occurred during the process
  */
 
-int gdb_check_server_capabilities(void)
+int GdbSession::gdb_check_server_capabilities(void)
 {
     LARGE_INTEGER StartingTime;
     start_timer(&StartingTime);
@@ -865,7 +2051,7 @@ int gdb_check_server_capabilities(void)
  *        No error check if the GDB server responded properly. We'll disconnect anyway.
  */
 
-void gdb_detach(void)
+void GdbSession::detach(void)
 {
     if (parameters.detach)
     {
@@ -888,7 +2074,7 @@ void gdb_detach(void)
  *        The string is in the message_buffer.
  */
 
-static void print_O_type_message(void)
+void GdbSession::print_O_type_message(void)
 {
     char* hex_string = message_buffer;
 
@@ -992,7 +2178,7 @@ static const char* get_core_content(char* message)
  *         RTE_ERROR - command could not be executed
  */
 
-int gdb_execute_command(const char * command)
+int GdbSession::execute_command(const char * command)
 {
     last_error = ERR_NO_ERROR;
     log_string("\n   \"%s\": ", command);
@@ -1044,7 +2230,7 @@ int gdb_execute_command(const char * command)
     {
         const char* text = get_core_content(message_buffer);
         log_string("\"%s\"", *text == '\0' ? "unsupported command" : text);
-        gdb_flush_socket();
+        flush_socket();
         return RTE_ERROR;
     }
 
@@ -1058,14 +2244,21 @@ int gdb_execute_command(const char * command)
  *        This is done in case the GDB server sends an unexpected message.
  */
 
-void gdb_flush_socket(void)
+void GdbSession::flush_socket(void)
 {
     char recvbuf[256];
     int res;
 
+    if (data_pending > 0)
+    {
+        message_buffer[packet_length] = pending_data_first_char;
+        log_communication_text("Discarded", &message_buffer[packet_length], (int)data_pending);
+        data_pending = 0;
+    }
+
     do
     {
-        res = recv(gdb_socket, recvbuf, sizeof(recvbuf), 0);
+        res = gdb_recv(recvbuf, sizeof(recvbuf), SOCKET_FLUSH_TIME);
         if (res > 0)
         {
             log_communication_text("Recv", recvbuf, res);
@@ -1082,7 +2275,7 @@ void gdb_flush_socket(void)
  *        Otherwise, it will respond with an error message.
  */
 
-int gdb_request_no_ack_mode(void)
+int GdbSession::gdb_request_no_ack_mode(void)
 {
     ack_mode_enabled = true;
 
@@ -1106,7 +2299,7 @@ int gdb_request_no_ack_mode(void)
     else
     {
         ack_mode_enabled = false;
-        gdb_flush_socket();
+        flush_socket();
     }
 
     return RTE_OK;
@@ -1118,7 +2311,7 @@ int gdb_request_no_ack_mode(void)
  *         Do not send it if the "QStartNoAckMode" was enabled.
  */
 
-static void gdb_send_ack(void)
+void GdbSession::gdb_send_ack(void)
 {
     if (ack_mode_enabled)
     {
@@ -1133,14 +2326,15 @@ static void gdb_send_ack(void)
  *         If the acknowledgement is not received within the specified timeout, it logs an error.
  */
 
-static void gdb_check_ack(void)
+void GdbSession::gdb_check_ack(void)
 {
     clock_t start_time = clock_ms();   // Record the start time
 
     while ((clock_ms() - start_time) < LONG_RECV_TIMEOUT) // Loop until timeout
     {
         message_buffer[0] = 0;      // Clear the message buffer
-        int res = recv(gdb_socket, message_buffer, 1, 0); // Receive a single character
+        // Receive a single character
+        int res = gdb_recv(message_buffer, 1, LONG_RECV_TIMEOUT - (long)(clock_ms() - start_time));
 
         switch (res)
         {
@@ -1155,18 +2349,12 @@ static void gdb_check_ack(void)
                 }
                 log_communication_text("Recv", message_buffer, res); // Log the received data
                 log_string("\nBad ACK received: %s", message_buffer); // Log the bad ACK
-                gdb_flush_socket(); // Flush any remaining data in the socket buffer
+                flush_socket(); // Flush any remaining data in the socket buffer
                 break;
 
             case SOCKET_ERROR: // Socket error
             {
-#ifdef _WIN32
-                int sock_err = WSAGetLastError();
-                if (sock_err != WSAETIMEDOUT)
-#else
-                int sock_err = errno;
-                if (sock_err != ETIMEDOUT)
-#endif
+                if (!socket_timeout_error())
                 {
                     log_wsock_error("\nSocket error while waiting for ACK");
                     return;
@@ -1190,15 +2378,24 @@ static void gdb_check_ack(void)
  *         a triggered breakpoint, reset, etc. Such message is logged and discarded.
  */
 
-void gdb_handle_unexpected_messages(void)
+void GdbSession::handle_unexpected_messages(void)
 {
     int res = 0;
 
+    if (data_pending > 0)
+    {
+        message_buffer[packet_length] = pending_data_first_char;
+        message_buffer[packet_length + data_pending] = 0;
+        log_string("\nUnexpected message: %s", &message_buffer[packet_length]);
+        data_pending = 0;
+    }
+
     do
     {
-        res = recv(gdb_socket, message_buffer, TCP_BUFF_LENGTH, 0);
+        res = gdb_recv(message_buffer, message_buffer_size - 1U, SOCKET_FLUSH_TIME);
         if (res > 0)
         {
+            message_buffer[res] = 0;
             // Log an unexpected GDB message
             log_string("\nUnexpected message: %s", message_buffer);
         }
@@ -1207,16 +2404,82 @@ void gdb_handle_unexpected_messages(void)
 }
 
 
+/***
+ * @brief Return the present max. size of the memory read packets [bytes].
+ */
+
+unsigned GdbSession::read_packet_size(void)
+{
+    return max_memo_read_packet_size;
+}
+
+
+/***
+ * @brief Return the largest memory read packet size possible for the connected
+ *        GDB server (negotiated message size or -msgsize) [bytes].
+ */
+
+unsigned GdbSession::read_packet_limit(void)
+{
+    return read_packet_size_limit;
+}
+
+
+/***
+ * @brief Set the max. size of the memory read packets (e.g. the size found by the
+ *        packet size tuning). The size is rounded down to a multiple of 4 and limited
+ *        to the size possible for the GDB server. The pipeline depth is recalculated
+ *        unless the pipelined mode has been disabled.
+ *
+ * @param size  New max. read packet size [bytes]
+ */
+
+void GdbSession::set_read_packet_size(unsigned size)
+{
+    size &= ~3U;
+
+    if ((size == 0) || (size > read_packet_size_limit))
+    {
+        size = read_packet_size_limit;
+    }
+
+    max_memo_read_packet_size = size;
+
+    if (pipeline_depth > 1U)
+    {
+        calculate_pipeline_depth();
+    }
+}
+
+
+/***
+ * @brief Return the hash of the GDB server capabilities reply. Servers of the same type
+ *        and version normally have the same hash.
+ */
+
+unsigned GdbSession::server_id(void)
+{
+    return server_capabilities_hash;
+}
+
+
 /***
  * @brief  Close and cleanup the socket used for communication with the GDB server.
  */
 
-void gdb_socket_cleanup(void)
+void GdbSession::cleanup(void)
 {
     log_string("\n", NULL);
     (void)closesocket(gdb_socket);  // Close the socket
+    gdb_socket = INVALID_SOCKET;
+    session_record_event(record_connection, SESSION_CLOSED, NULL, 0);
+    record_connection = 0;
 #ifdef _WIN32
-    (void)WSACleanup();             // Cleanup the Winsock library
+    if (socket_library_started)
+    {
+        (void)WSACleanup();         // Cleanup the Winsock library
+        socket_library_started = false;
+    }
 #endif
 }
 
@@ -1240,7 +2503,6 @@ const char* gdb_get_error_text(void)
         case ERR_SOCKET:
         case ERR_BAD_MSG_FORMAT:
         case ERR_BAD_MSG_CHECKSUM:
-        case ERR_RUN_LENGTH_ENCODING_NOT_IMPLEMENTED:
         case ERR_BAD_INPUT_DATA:
         case ERR_MSG_NOT_SENT_COMPLETELY:
         case ERR_BAD_RESPONSE:
@@ -1281,7 +2543,6 @@ void gdb_display_errors(const char* message)
 
         case ERR_BAD_MSG_FORMAT:
         case ERR_BAD_MSG_CHECKSUM:
-        case ERR_RUN_LENGTH_ENCODING_NOT_IMPLEMENTED:
         case ERR_BAD_INPUT_DATA:
         case ERR_MSG_NOT_SENT_COMPLETELY:
         case ERR_BAD_RESPONSE:
@@ -1300,4 +2561,95 @@ void gdb_display_errors(const char* message)
     printf("\nCheck the log file for details.\n");
 }
 
+/*---------------- Default session of the thread ---------------*/
+// The gdb_xxx() functions use the default session of the calling thread.
+
+/***
+ * @brief Return the default GDB server session of the calling thread.
+ */
+
+static GdbSession& thread_session(void)
+{
+    static thread_local GdbSession session;
+    return session;
+}
+
+
+int gdb_connect(unsigned short gdb_port)
+{
+    return thread_session().connect_to_server(gdb_port);
+}
+
+
+int gdb_read_memory(unsigned char* buffer, unsigned int address, unsigned int length)
+{
+    return thread_session().read_memory(buffer, address, length);
+}
+
+
+int gdb_write_memory(const unsigned char* buffer, unsigned address, unsigned length)
+{
+    return thread_session().write_memory(buffer, address, length);
+}
+
+
+int gdb_fill_memory(unsigned address, unsigned pattern, unsigned length)
+{
+    return thread_session().fill_memory(address, pattern, length);
+}
+
+
+void gdb_detach(void)
+{
+    thread_session().detach();
+}
+
+
+int gdb_execute_command(const char* command)
+{
+    return thread_session().execute_command(command);
+}
+
+
+void gdb_flush_socket(void)
+{
+    thread_session().flush_socket();
+}
+
+
+void gdb_socket_cleanup(void)
+{
+    thread_session().cleanup();
+}
+
+
+void gdb_handle_unexpected_messages(void)
+{
+    thread_session().handle_unexpected_messages();
+}
+
+
+unsigned gdb_get_read_packet_size(void)
+{
+    return thread_session().read_packet_size();
+}
+
+
+unsigned gdb_get_read_packet_limit(void)
+{
+    return thread_session().read_packet_limit();
+}
+
+
+void gdb_set_read_packet_size(unsigned size)
+{
+    thread_session().set_read_packet_size(size);
+}
+
+
+unsigned gdb_get_server_id(void)
+{
+    return thread_session().server_id();
+}
+
 /*==== End of file ====*/
@@ -15,9 +15,13 @@
     #include <winsock2.h>
     #include <Ws2tcpip.h>
     #include <Windows.h>
+    #define SEND_FLAGS 0
 #else
     #include <sys/socket.h>
     #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <fcntl.h>
     #include <arpa/inet.h>
     #include <unistd.h>
     #include <netdb.h>
@@ -26,21 +30,24 @@
     #define INVALID_SOCKET -1
     #define SOCKET_ERROR -1
     #define closesocket close
+    #define SEND_FLAGS MSG_NOSIGNAL     // Report an error instead of the SIGPIPE signal
 #endif
 #include <time.h>
 #include "gdb_defs.h"
 
-extern char message_buffer[];
-extern clock_t app_start_time;
-
 int  gdb_connect(unsigned short gdb_port);
 int  gdb_read_memory(unsigned char * buffer, unsigned int address, unsigned int length);
 int  gdb_write_memory(const unsigned char * buffer, unsigned address, unsigned length);
+int  gdb_fill_memory(unsigned address, unsigned pattern, unsigned length);
 void gdb_detach(void);
 int  gdb_execute_command(const char * command);
 void gdb_flush_socket(void);
 void gdb_socket_cleanup(void);
 void gdb_handle_unexpected_messages(void);
+unsigned gdb_get_read_packet_size(void);
+unsigned gdb_get_read_packet_limit(void);
+void gdb_set_read_packet_size(unsigned size);
+unsigned gdb_get_server_id(void);
 void gdb_display_errors(const char* message);
 const char* gdb_get_error_text(void);
 
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    gdb_pool.cpp
+ * @brief   Parallel memory reads over several connections to the GDB server (-connections=K).
+ *          Large blocks are split into stripes that are read concurrently. The first stripe
+ *          is read over the main connection, the others by worker threads. Each worker
+ *          thread has its own connection to the GDB server (GdbSession object). The
+ *          transfer rate increases only if the GDB server (and not the debug probe link)
+ *          limits it and the server accepts several connections
+ *          (e.g. OpenOCD with "-gdb-max-connections").
+ * @author  B. Premzel
+ */
+
+#include "pch.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <system_error>
+#include "RTEgetData.h"
+#include "cmd_line.h"
+#include "logger.h"
+#include "gdb_session.h"
+#include "gdb_pool.h"
+
+
+typedef struct
+{
+    std::thread thread;
+    bool connect_done;          // Connection attempt finished
+    bool connected;             // true - the worker can read data
+    bool read_request;          // Stripe defined below is waiting to be read
+    bool exit_request;          // Close the connection and stop the thread
+    unsigned char* buffer;      // Stripe data buffer
+    unsigned address;           // Stripe address in the embedded system memory
+    unsigned length;            // Stripe length [bytes]
+    unsigned packet_size;       // Max. read packet size (the same as for the main connection)
+    int result;                 // Result of the last read (RTE_OK / RTE_ERROR)
+} pool_worker_t;
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static pool_worker_t workers[MAX_GDB_CONNECTIONS - 1];
+static unsigned number_of_workers = 0;      // Number of started worker threads
+static bool pool_opened = false;            // Additional connections have been opened
+static std::mutex pool_mutex;               // Protects the worker status variables
+static std::condition_variable pool_event;  // Signalled when a worker status changes
+
+
+/*---------------- Local functions ---------------*/
+static void open_pool(void);
+static void worker_thread_function(pool_worker_t* worker);
+
+
+/***
+ * @brief Read a memory block over all available GDB server connections.
+ *        Blocks shorter than two stripes are read over the main connection only.
+ *        A stripe that could not be read by a worker is read again over the main
+ *        connection and the worker connection is closed.
+ *
+ * @param buffer   Buffer for the data
+ * @param address  Starting address in the embedded system's memory
+ * @param length   Number of bytes to read
+ *
+ * @return RTE_OK    - Operation successful
+ *         RTE_ERROR - Error occurred (check last_error for details)
+ */
+
+int gdb_pool_read_memory(unsigned char* buffer, unsigned address, unsigned length)
+{
+    if (!pool_opened)
+    {
+        open_pool();
+    }
+
+    pool_worker_t* active[MAX_GDB_CONNECTIONS - 1];
+    unsigned stripes = 1;
+    unsigned max_stripes = length / MIN_STRIPE_SIZE;
+    std::unique_lock<std::mutex> lock(pool_mutex);
+
+    for (unsigned i = 0; (i < number_of_workers) && (stripes < max_stripes); i++)
+    {
+        if (workers[i].connected)
+        {
+            active[stripes - 1U] = &workers[i];
+            stripes++;
+        }
+    }
+
+    if (stripes < 2U)
+    {
+        lock.unlock();
+        return gdb_read_memory(buffer, address, length);
+    }
+
+    unsigned stripe_size = ((length / stripes) + 3U) & ~3U;
+
+    for (unsigned i = 1; i < stripes; i++)
+    {
+        pool_worker_t* worker = active[i - 1U];
+        unsigned offset = i * stripe_size;
+        worker->buffer = buffer + offset;
+        worker->address = address + offset;
+        worker->length = (i == (stripes - 1U)) ? (length - offset) : stripe_size;
+        worker->read_request = true;
+    }
+
+    lock.unlock();
+    pool_event.notify_all();
+
+    int rez = gdb_read_memory(buffer, address, stripe_size);
+    err_code_t error = last_error;
+
+    lock.lock();
+    pool_event.wait(lock, [&active, stripes]
+        {
+            for (unsigned i = 0; i < (stripes - 1U); i++)
+            {
+                if (active[i]->read_request)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        });
+    lock.unlock();
+
+    for (unsigned i = 0; i < (stripes - 1U); i++)
+    {
+        pool_worker_t* worker = active[i];
+
+        if (worker->result == RTE_OK)
+        {
+            continue;
+        }
+
+        log_data("\nRead over the GDB server connection %llu failed - connection closed.",
+            (long long)(worker - workers) + 2);
+
+        if (rez == RTE_OK)
+        {
+            rez = gdb_read_memory(worker->buffer, worker->address, worker->length);
+            error = last_error;
+        }
+    }
+
+    last_error = error;
+    return rez;
+}
+
+
+/***
+ * @brief Close the additional connections and stop the worker threads.
+ *        The connections are opened again at the next gdb_pool_read_memory() call.
+ */
+
+void gdb_pool_close(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+
+        for (unsigned i = 0; i < number_of_workers; i++)
+        {
+            workers[i].exit_request = true;
+        }
+    }
+
+    pool_event.notify_all();
+
+    for (unsigned i = 0; i < number_of_workers; i++)
+    {
+        if (workers[i].thread.joinable())
+        {
+            workers[i].thread.join();
+        }
+    }
+
+    number_of_workers = 0;
+    pool_opened = false;
+}
+
+
+/***
+ * @brief Open the additional connections to the GDB server (-connections=K).
+ *        The connections are opened one after another so that the log messages of
+ *        different connections are not mixed. No more connections are opened after
+ *        the first one that fails (the GDB server does not accept more clients).
+ */
+
+static void open_pool(void)
+{
+    pool_opened = true;
+    unsigned connections = (parameters.connections > 1U) ? parameters.connections : 1U;
+    unsigned packet_size = gdb_get_read_packet_size();  // Possibly tuned (-autotune)
+
+    for (unsigned i = 0; i < (connections - 1U); i++)
+    {
+        pool_worker_t* worker = &workers[i];
+        worker->connect_done = false;
+        worker->connected = false;
+        worker->read_request = false;
+        worker->exit_request = false;
+        worker->packet_size = packet_size;
+        log_data("\nAdditional GDB server connection %llu: ", (long long)i + 2);
+
+        try
+        {
+            worker->thread = std::thread(worker_thread_function, worker);
+        }
+        catch (const std::system_error&)
+        {
+            log_string("could not start the thread.", NULL);
+            break;
+        }
+
+        number_of_workers++;
+        std::unique_lock<std::mutex> lock(pool_mutex);
+        pool_event.wait(lock, [worker] { return worker->connect_done; });
+
+        if (!worker->connected)
+        {
+            log_string("\nThe GDB server does not accept more connections.", NULL);
+            break;
+        }
+    }
+
+    last_error = ERR_NO_ERROR;
+}
+
+
+/***
+ * @brief Connect to the GDB server and read the stripes assigned to the worker until
+ *        the exit is requested or a read fails.
+ *
+ * @param worker  Worker status and stripe data
+ */
+
+static void worker_thread_function(pool_worker_t* worker)
+{
+    GdbSession session;
+    bool connected = (session.connect_to_server(parameters.gdb_port) == RTE_OK);
+    bool opened = connected;
+
+    if (connected)
+    {
+        session.set_read_packet_size(worker->packet_size);
+    }
+
+    std::unique_lock<std::mutex> lock(pool_mutex);
+    worker->connected = connected;
+    worker->connect_done = true;
+    pool_event.notify_all();
+
+    while (connected)
+    {
+        pool_event.wait(lock, [worker] { return worker->read_request || worker->exit_request; });
+
+        if (worker->exit_request)
+        {
+            break;
+        }
+
+        lock.unlock();
+        int rez = session.read_memory(worker->buffer, worker->address, worker->length);
+        lock.lock();
+
+        worker->result = rez;
+        worker->read_request = false;
+
+        if (rez != RTE_OK)
+        {
+            worker->connected = false;  // The stripe is read over the main connection
+            connected = false;
+        }
+
+        pool_event.notify_all();
+    }
+
+    lock.unlock();
+
+    // connect_to_server() closes the socket itself if the connection fails
+    if (opened)
+    {
+        session.cleanup();
+    }
+}
+
+/*==== End of file ====*/
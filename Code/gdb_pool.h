@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    gdb_pool.h
+ * @author  B. Premzel
+ * @brief   Parallel memory reads over several connections to the GDB server
+ *          (-connections=K).
+ */
+
+#ifndef _GDB_POOL_H
+#define _GDB_POOL_H
+
+int  gdb_pool_read_memory(unsigned char* buffer, unsigned address, unsigned length);
+void gdb_pool_close(void);
+
+#endif  // _GDB_POOL_H
+
+/*==== End of file ====*/
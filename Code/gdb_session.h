@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    gdb_session.h
+ * @author  B. Premzel
+ * @brief   Connection to a GDB server. The object holds the complete state of one
+ *          GDB remote protocol connection (socket, message buffers, negotiated message
+ *          sizes and modes), so several connections can be used in one process - e.g.
+ *          parallel reads over additional connections (see gdb_pool.cpp).
+ *          The gdb_xxx() functions (gdb_lib.h) use the default session of the calling thread.
+ */
+
+#ifndef _GDB_SESSION_H
+#define _GDB_SESSION_H
+
+#include "gdb_lib.h"
+
+
+// State of the memory read reply decoder
+typedef struct
+{
+    unsigned char* buffer;                      // Buffer to which the data is written
+    unsigned length;                            // Size of buffer
+    unsigned bytes_decoded;                     // Number of bytes written to the buffer
+    int first_digit;                            // Hex data: first digit of a byte (-1 = not received yet)
+    bool escape;                                // Binary data: previous character was '}'
+    bool error;                                 // Bad data found
+} reply_decoder_t;
+
+typedef enum
+{
+    FILL_CMD_UNKNOWN,                           // Not checked yet (checked at the first use)
+    FILL_CMD_AVAILABLE,                         // The fill command has changed the memory
+    FILL_CMD_NOT_AVAILABLE                      // Not supported or disabled with -fill_cmd=none
+} fill_cmd_state_t;
+
+
+class GdbSession
+{
+public:
+    GdbSession(void);
+    ~GdbSession(void);
+
+    void set_target(const char* ip_address, unsigned start_address);
+    int  connect_to_server(unsigned short gdb_port);
+    void cleanup(void);
+    int  read_memory(unsigned char* buffer, unsigned int address, unsigned int length);
+    int  write_memory(const unsigned char* buffer, unsigned address, unsigned length);
+    int  fill_memory(unsigned address, unsigned pattern, unsigned length);
+    void detach(void);
+    int  execute_command(const char* command);
+    void flush_socket(void);
+    void handle_unexpected_messages(void);
+    unsigned read_packet_size(void);
+    unsigned read_packet_limit(void);
+    void set_read_packet_size(unsigned size);
+    unsigned server_id(void);
+
+private:
+    // The session owns the socket and buffers - copying is not allowed
+    GdbSession(const GdbSession&);
+    GdbSession& operator=(const GdbSession&);
+
+    void allocate_buffers(void);
+    int  gdb_get_message(size_t timeout);
+    int  read_memory_packet(unsigned char* buffer, unsigned int address, unsigned int length,
+        unsigned* bytes_received);
+    int  send_read_memory_request(unsigned int address, unsigned int length);
+    int  receive_read_memory_reply(unsigned char* buffer, unsigned int length, unsigned* bytes_received);
+    int  decode_reply_data(const char* data, unsigned data_length, unsigned char* buffer, unsigned length,
+        unsigned char* checksum);
+    unsigned char decode_reply_literals(reply_decoder_t* decoder, const char* chars, unsigned count);
+    void decode_reply_char(reply_decoder_t* decoder, unsigned char c);
+    unsigned read_reply_size(unsigned length);
+    void check_binary_read_support(void);
+    int  read_memory_lock_step(unsigned char* buffer, unsigned int address, unsigned int length);
+    int  read_memory_pipelined(unsigned char* buffer, unsigned int address, unsigned int length);
+    int  gdb_recv(char* buffer, unsigned length, long timeout);
+    int  wait_for_socket(bool wait_for_send, long timeout);
+    void request_quick_ack(void);
+    int  write_memory_packet(const unsigned char* buffer, unsigned address, unsigned length);
+    int  fill_with_monitor_command(unsigned address, unsigned pattern, unsigned length);
+    unsigned binary_write_length(const unsigned char* buffer, unsigned length);
+    void check_binary_write_support(void);
+    int  gdb_send_command(const char* command);
+    void gdb_send_ack(void);
+    void gdb_check_ack(void);
+    void calculate_max_message_sizes(void);
+    void calculate_pipeline_depth(void);
+    void print_O_type_message(void);
+    int  gdb_send(const char* msg, int length);
+    bool gdb_error_reported(void);
+    int  parse_capability_data(const char* recvbuf);
+    int  gdb_connect_socket(unsigned short gdb_port);
+    int  gdb_check_server_capabilities(void);
+    int  gdb_request_no_ack_mode(void);
+
+    char* message_buffer;                       // Buffer for TCP message receive
+    unsigned message_buffer_size;               // Size of the message_buffer [bytes]
+    char* send_buffer;                          // Buffer for the memory write messages
+    unsigned send_buffer_size;                  // Size of the send_buffer [bytes]
+
+    const char* server_ip_address;              // GDB server IP address
+    unsigned rtedbg_address;                    // Address of the g_rtedbg structure (used for test accesses)
+    SOCKET gdb_socket;
+    bool socket_library_started;                // Winsock started (WSAStartup) for this session
+    unsigned record_connection;                 // Connection number in the session recording (0 = not recorded)
+    unsigned data_received;                     // Number of bytes received in the buffer
+    unsigned packet_length;                     // Length of the last message in the message_buffer
+    unsigned data_pending;                      // Number of bytes received after the last message
+                                                // (start of the next message(s) in the pipelined mode)
+    char pending_data_first_char;               // Character overwritten by the message terminator
+    unsigned pipeline_depth;                    // Max. number of read requests in flight
+    bool binary_read_enabled;                   // true - memory is read with the binary 'x' packets
+    bool binary_write_enabled;                  // true - memory is written with the binary 'X' packets
+    fill_cmd_state_t fill_command_state;        // Monitor fill command status
+    unsigned rle_packets;                       // Number of run-length encoded replies (debug statistics)
+    unsigned rle_chars_saved;                   // Number of characters saved by the run-length encoding
+    bool ack_mode_enabled;                      // If true, send message acknowledgments
+    unsigned max_memo_read_packet_size;         // Maximum read_memory_packet() size
+    unsigned read_packet_size_limit;            // Largest read_memory_packet() size possible for the server
+    unsigned server_capabilities_hash;          // Hash of the qSupported reply (identifies the server type)
+    unsigned max_memo_write_packet_size;        // Maximum write_memory_packet() size
+    unsigned max_gdb_send_message_size;         // Maximum size of message that can be sent to the GDB server
+    unsigned max_gdb_recv_message_size;         // Maximum size of message that can be received from the GDB server
+};
+
+#endif  // _GDB_SESSION_H
+
+/*==== End of file ====*/
@@ -0,0 +1,486 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    gdb_tuning.cpp
+ * @brief   Memory read packet size tuning (-autotune). The same block of the g_rtedbg
+ *          structure is read with a ladder of packet sizes. The latency per packet is
+ *          fitted with the model latency = a + b * size (a = overhead per packet,
+ *          b = time per byte) and the packet size with the highest measured transfer
+ *          rate is selected. Debug probes and GDB servers behave very differently -
+ *          some are slower with large packets than the model predicts. A packet size
+ *          larger than the test block is therefore used only if the model matches all
+ *          measurements and predicts a higher transfer rate for it.
+ *          The result is saved to the tuning file for each GDB server (IP address,
+ *          port and server type) and used at the next connection without measurement.
+ * @author  B. Premzel
+ */
+
+#include "pch.h"
+#include <stdlib.h>
+#include <cstddef>
+#include <cstring>
+#include "RTEgetData.h"
+#include "cmd_line.h"
+#include "rtedbg.h"
+#include "logger.h"
+#include "platform_compat.h"
+#include "gdb_lib.h"
+#include "gdb_pool.h"
+#include "gdb_tuning.h"
+
+
+typedef struct
+{
+    char server[64];            // GDB server IP address and port ("ip:port")
+    unsigned id;                // Hash of the server capabilities (server type and version)
+    unsigned packet_size;       // Selected read packet size [bytes]
+} tuning_entry_t;
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static tuning_entry_t tuning_entries[MAX_TUNING_ENTRIES];
+static unsigned number_of_entries = 0;
+
+
+/*---------------- Local functions ---------------*/
+static unsigned measure_packet_sizes(void);
+static unsigned test_block_length(void);
+static bool fit_latency_model(const double* sizes, const double* latencies, unsigned count,
+    double* a, double* b);
+static unsigned extrapolate_packet_size(const double* sizes, const double* rates, unsigned count,
+    unsigned measured_size, double a, double b);
+static void load_tuning_file(const char* file_name);
+static void save_tuning_file(const char* file_name);
+static tuning_entry_t* find_tuning_entry(const char* server);
+
+
+/***
+ * @brief Set the memory read packet size for the connected GDB server. The size saved
+ *        in the tuning file is used if the server is found in it and a new measurement
+ *        is not requested. Otherwise the packet sizes are measured and the result is
+ *        saved to the tuning file. The additional connections (-connections=K) are
+ *        closed and reopened with the new packet size at the next read.
+ *
+ * @param measure  true - measure even if the server is in the tuning file
+ *
+ * @return RTE_OK    - packet size set
+ *         RTE_ERROR - measurement not possible (packet size not changed)
+ */
+
+int gdb_tune_packet_size(bool measure)
+{
+    const char* file_name = (parameters.tuning_file != NULL) ? parameters.tuning_file : DEFAULT_TUNING_FILE;
+    char server[sizeof(tuning_entries[0].server)];
+    sprintf_s(server, sizeof(server), "%s:%u", parameters.ip_address, parameters.gdb_port);
+    unsigned id = gdb_get_server_id();
+
+    load_tuning_file(file_name);
+    tuning_entry_t* entry = find_tuning_entry(server);
+
+    if (!measure && (entry != NULL) && (entry->id == id))
+    {
+        gdb_set_read_packet_size(entry->packet_size);
+        log_data("\nRead packet size: %llu bytes (from the tuning file)", (long long)gdb_get_read_packet_size());
+        return RTE_OK;
+    }
+
+    gdb_pool_close();
+    unsigned packet_size = measure_packet_sizes();
+
+    if (packet_size == 0)
+    {
+        return RTE_ERROR;
+    }
+
+    gdb_set_read_packet_size(packet_size);
+
+    if (logging_to_file())
+    {
+        printf("\nRead packet size tuned to %u bytes.", gdb_get_read_packet_size());
+    }
+
+    if (entry == NULL)
+    {
+        if (number_of_entries >= MAX_TUNING_ENTRIES)
+        {
+            // Replace the oldest entry
+            memmove(&tuning_entries[0], &tuning_entries[1], (MAX_TUNING_ENTRIES - 1U) * sizeof(tuning_entry_t));
+            number_of_entries--;
+        }
+
+        entry = &tuning_entries[number_of_entries++];
+        memcpy(entry->server, server, sizeof(server));
+    }
+
+    entry->id = id;                     // The server type may have changed
+    entry->packet_size = packet_size;
+    save_tuning_file(file_name);
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Read the test block with each packet size of the ladder (doubled from
+ *        TUNING_MIN_PACKET_SIZE up to the max. size possible) and find the size with
+ *        the highest transfer rate. The smallest size with a transfer rate within
+ *        TUNING_TOLERANCE % of the best one is selected.
+ *
+ * @return Selected packet size [bytes] or 0 if the measurement failed
+ */
+
+static unsigned measure_packet_sizes(void)
+{
+    unsigned length = test_block_length();
+
+    if (length == 0)
+    {
+        return 0;
+    }
+
+    unsigned char* buffer = (unsigned char*)malloc(length);
+
+    if (buffer == NULL)
+    {
+        log_string("\nPacket size tuning: out of memory.", NULL);
+        return 0;
+    }
+
+    unsigned original_size = gdb_get_read_packet_size();
+    unsigned max_size = gdb_get_read_packet_limit();
+
+    if (max_size > length)
+    {
+        max_size = length;
+    }
+
+    unsigned packet_sizes[MAX_TUNING_STEPS];
+    double sizes[MAX_TUNING_STEPS];         // Average packet size [bytes]
+    double latencies[MAX_TUNING_STEPS];     // Time per packet [ms]
+    double rates[MAX_TUNING_STEPS];         // Transfer rate [kB/s]
+    unsigned steps = 0;
+    unsigned size = (max_size < TUNING_MIN_PACKET_SIZE) ? max_size : TUNING_MIN_PACKET_SIZE;
+    log_data("\nPacket size tuning - reading %llu bytes with packet sizes:", (long long)length);
+
+    while (steps < MAX_TUNING_STEPS)
+    {
+        gdb_set_read_packet_size(size);
+        size = gdb_get_read_packet_size();
+        double best_time = 0;
+
+        for (unsigned i = 0; i < TUNING_REPEAT_COUNT; i++)
+        {
+            LARGE_INTEGER start_time;
+            start_timer(&start_time);
+
+            if (gdb_read_memory(buffer, parameters.start_address, length) != RTE_OK)
+            {
+                log_string("\nPacket size tuning stopped - read failed.", NULL);
+                gdb_set_read_packet_size(original_size);
+                free(buffer);
+                return 0;
+            }
+
+            double time = time_elapsed(&start_time);
+
+            if ((i == 0) || (time < best_time))
+            {
+                best_time = time;
+            }
+        }
+
+        unsigned packets = (length + size - 1U) / size;
+        packet_sizes[steps] = size;
+        sizes[steps] = (double)length / packets;
+        latencies[steps] = best_time / packets;
+        rates[steps] = (best_time > 0) ? ((double)length / best_time) : 0;
+        log_data("\n%8llu bytes:", (long long)size);
+        log_data(" %llu kB/s", (long long)rates[steps]);
+        steps++;
+
+        if (size >= max_size)
+        {
+            break;
+        }
+
+        size = ((2U * size) < max_size) ? (2U * size) : max_size;
+    }
+
+    free(buffer);
+    double a = 0;   // Latency model: overhead per packet [ms]
+    double b = 0;   // Time per byte [ms]
+    bool model_valid = fit_latency_model(sizes, latencies, steps, &a, &b);
+
+    double best_rate = 0;
+
+    for (unsigned i = 0; i < steps; i++)
+    {
+        if (rates[i] > best_rate)
+        {
+            best_rate = rates[i];
+        }
+    }
+
+    unsigned selected = 0;
+
+    while ((selected < (steps - 1U)) && (rates[selected] < (best_rate * TUNING_TOLERANCE / 100.0)))
+    {
+        selected++;
+    }
+
+    log_data("\nSelected read packet size: %llu bytes", (long long)packet_sizes[selected]);
+    log_data(" (%llu kB/s)", (long long)rates[selected]);
+
+    // The largest size was limited by the test block and was the fastest - a larger size
+    // is used only if the latency model predicts a higher transfer rate for it.
+    if ((selected == (steps - 1U)) && (max_size == length) && model_valid)
+    {
+        return extrapolate_packet_size(sizes, rates, steps, packet_sizes[selected], a, b);
+    }
+
+    return packet_sizes[selected];
+}
+
+
+/***
+ * @brief Check the packet size limit of the GDB server (larger than the test block)
+ *        with the latency model. The limit is used if the model matches the measured
+ *        transfer rates within TUNING_MODEL_ERROR % and predicts a rate for the limit
+ *        that is more than the TUNING_TOLERANCE margin higher than the measured one.
+ *
+ * @param sizes          Average packet sizes measured [bytes]
+ * @param rates          Transfer rates measured [kB/s]
+ * @param count          Number of measurements
+ * @param measured_size  Largest packet size measured (the fastest one) [bytes]
+ * @param a              Latency model: overhead per packet [ms]
+ * @param b              Latency model: time per byte [ms]
+ *
+ * @return Packet size to be used [bytes]
+ */
+
+static unsigned extrapolate_packet_size(const double* sizes, const double* rates, unsigned count,
+    unsigned measured_size, double a, double b)
+{
+    unsigned limit = gdb_get_read_packet_limit();
+
+    if ((limit <= measured_size) || (a <= 0) || (b <= 0))
+    {
+        return measured_size;
+    }
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        double model_rate = sizes[i] / (a + b * sizes[i]);
+
+        if ((model_rate < rates[i] * (100.0 - TUNING_MODEL_ERROR) / 100.0)
+            || (model_rate > rates[i] * (100.0 + TUNING_MODEL_ERROR) / 100.0))
+        {
+            log_data("\nLatency model does not match the measurement at %llu bytes"
+                " - larger packet sizes not used.", (long long)sizes[i]);
+            return measured_size;
+        }
+    }
+
+    double measured_rate = rates[count - 1U];
+    double predicted_rate = (double)limit / (a + b * limit);
+    log_data("\nPredicted transfer rate for %llu bytes", (long long)limit);
+    log_data(": %llu kB/s", (long long)predicted_rate);
+
+    if (predicted_rate * TUNING_TOLERANCE / 100.0 <= measured_rate)
+    {
+        return measured_size;   // Not worth the risk of an untested packet size
+    }
+
+    log_data("\nSelected read packet size: %llu bytes (extrapolated)", (long long)limit);
+    return limit;
+}
+
+
+/***
+ * @brief Determine the size of the block read during the tuning from the g_rtedbg
+ *        structure header. Only the memory of the g_rtedbg structure is read.
+ *
+ * @return Block length [bytes] or 0 if the header is not correct
+ */
+
+static unsigned test_block_length(void)
+{
+    rtedbg_header_t rtedbg_header;      // Name used by the rtedbg.h macros
+
+    if (gdb_read_memory((unsigned char*)&rtedbg_header, parameters.start_address, sizeof(rtedbg_header)) != RTE_OK)
+    {
+        log_string("\nPacket size tuning not possible - cannot read the g_rtedbg structure header.", NULL);
+        return 0;
+    }
+
+    if ((rtedbg_header.buffer_size > (MAX_BUFFER_SIZE / 4U))
+        || ((rtedbg_header.buffer_size * 4U + sizeof(rtedbg_header_t)) < MIN_BUFFER_SIZE)
+        || (sizeof(rtedbg_header_t) != RTE_HEADER_SIZE))
+    {
+        log_string("\nPacket size tuning not possible - incorrect g_rtedbg structure header.", NULL);
+        return 0;
+    }
+
+    unsigned length = rtedbg_header.buffer_size * 4U + sizeof(rtedbg_header_t);
+    return (length > TUNING_MAX_BLOCK_SIZE) ? TUNING_MAX_BLOCK_SIZE : length;
+}
+
+
+/***
+ * @brief Fit the packet latency with the model latency = a + b * size (least squares)
+ *        and log the result. The overhead per packet (a) and the transfer rate for
+ *        very large packets (1 / b) characterize the GDB server and debug probe.
+ *
+ * @param sizes      Packet sizes [bytes]
+ * @param latencies  Time per packet [ms]
+ * @param count      Number of measurements
+ * @param a          Overhead per packet [ms]
+ * @param b          Time per byte [ms]
+ *
+ * @return true if the model has been fitted (at least two different sizes measured)
+ */
+
+static bool fit_latency_model(const double* sizes, const double* latencies, unsigned count,
+    double* a, double* b)
+{
+    if (count < 2U)
+    {
+        return false;
+    }
+
+    double sum_x = 0;
+    double sum_y = 0;
+    double sum_xx = 0;
+    double sum_xy = 0;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        sum_x += sizes[i];
+        sum_y += latencies[i];
+        sum_xx += sizes[i] * sizes[i];
+        sum_xy += sizes[i] * latencies[i];
+    }
+
+    double divisor = count * sum_xx - sum_x * sum_x;
+
+    if (divisor <= 0)
+    {
+        return false;
+    }
+
+    *b = (count * sum_xy - sum_x * sum_y) / divisor;
+    *a = (sum_y - *b * sum_x) / count;
+
+    log_data("\nLatency model: %llu us per packet", (long long)((*a > 0) ? (*a * 1000.0) : 0));
+    log_data(" + %llu ns per byte", (long long)((*b > 0) ? (*b * 1000000.0) : 0));
+
+    if (*b > 0)
+    {
+        log_data(" (max. %llu kB/s)", (long long)(1.0 / *b));
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Load the packet size tuning file. Each line contains the server hash,
+ *        the packet size and the server IP address with port.
+ *        A missing file is not an error.
+ *
+ * @param file_name  Tuning file name
+ */
+
+static void load_tuning_file(const char* file_name)
+{
+    number_of_entries = 0;
+    FILE* file;
+
+    if (fopen_s(&file, file_name, "r") != 0)
+    {
+        return;
+    }
+
+    char line[256];
+
+    while ((number_of_entries < MAX_TUNING_ENTRIES) && (fgets(line, sizeof(line), file) != NULL))
+    {
+        tuning_entry_t* entry = &tuning_entries[number_of_entries];
+        int offset = 0;
+
+        if ((line[0] == '#')
+            || (sscanf_s(line, "%x %u %n", &entry->id, &entry->packet_size, &offset) != 2)
+            || (offset == 0))
+        {
+            continue;
+        }
+
+        size_t length = strcspn(&line[offset], " \t\r\n");
+
+        if ((length == 0) || (length >= sizeof(entry->server)))
+        {
+            continue;
+        }
+
+        memcpy(entry->server, &line[offset], length);
+        entry->server[length] = '\0';
+        number_of_entries++;
+    }
+
+    (void)fclose(file);
+}
+
+
+/***
+ * @brief Save the packet size tuning results to the tuning file.
+ *
+ * @param file_name  Tuning file name
+ */
+
+static void save_tuning_file(const char* file_name)
+{
+    FILE* file;
+
+    if (fopen_s(&file, file_name, "w") != 0)
+    {
+        log_string("\nCannot write the packet size tuning file \"%s\".", file_name);
+        return;
+    }
+
+    fprintf(file, "# RTEgetData read packet size tuning: server_hash packet_size ip_address:port\n");
+
+    for (unsigned i = 0; i < number_of_entries; i++)
+    {
+        fprintf(file, "%08X %u %s\n",
+            tuning_entries[i].id, tuning_entries[i].packet_size, tuning_entries[i].server);
+    }
+
+    (void)fclose(file);
+}
+
+
+/***
+ * @brief Find the tuning file entry of the GDB server.
+ *
+ * @param server  GDB server IP address and port
+ *
+ * @return Pointer to the entry or NULL if not found
+ */
+
+static tuning_entry_t* find_tuning_entry(const char* server)
+{
+    for (unsigned i = 0; i < number_of_entries; i++)
+    {
+        if (strcmp(tuning_entries[i].server, server) == 0)
+        {
+            return &tuning_entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*==== End of file ====*/
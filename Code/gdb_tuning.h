@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    gdb_tuning.h
+ * @author  B. Premzel
+ * @brief   Memory read packet size tuning for the connected GDB server (-autotune).
+ */
+
+#ifndef _GDB_TUNING_H
+#define _GDB_TUNING_H
+
+int gdb_tune_packet_size(bool measure);
+
+#endif  // _GDB_TUNING_H
+
+/*==== End of file ====*/
@@ -0,0 +1,617 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    hex_codec.cpp
+ * @brief   Conversion of binary data to hex characters and back.
+ * @author  B. Premzel
+ *
+ * The memory read ('m') and write ('M') packets of the GDB protocol transfer
+ * data as hex characters. A table driven implementation is always available.
+ * The vectorized implementations (SSE2, AVX2 or NEON) are used if the compiler
+ * and CPU support them. AVX2 support is checked at run time.
+ *
+ * All implementations calculate the sum of the hex characters (GDB packet
+ * checksum) in the same pass.
+ */
+
+#include "pch.h"
+#include <string.h>
+#include <mutex>
+#include "hex_codec.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define HEX_CODEC_SSE2
+    #define HEX_CODEC_AVX2
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define TARGET_AVX2
+    #else
+        #define TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+    #define HEX_CODEC_NEON
+    #include <arm_neon.h>
+#endif
+
+#define HEX_INVALID     0x80U       // Flag in the hex_value[] table for characters that are not hex digits
+#define MAX_HEX_CODECS     4
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static unsigned char hex_value[256];            // Value of hex digit or HEX_INVALID
+static char hex_pair[256][2];                   // Hex characters for all byte values
+static unsigned char hex_pair_sum[256];         // Sum of both hex characters for all byte values
+static hex_codec_t hex_codecs[MAX_HEX_CODECS];  // Implementations supported by the CPU
+static unsigned number_of_codecs = 0;
+static const hex_codec_t* active_codec = NULL;  // Fastest implementation
+static std::once_flag init_flag;                // The tables are prepared only once (any thread can call init)
+
+
+/*---------------- Local functions ---------------*/
+static unsigned char encode_scalar(const unsigned char* src, unsigned length, char* dst);
+static bool decode_scalar(const char* src, unsigned length, unsigned char* dst, unsigned char* checksum);
+#ifdef HEX_CODEC_SSE2
+static unsigned char encode_sse2(const unsigned char* src, unsigned length, char* dst);
+static bool decode_sse2(const char* src, unsigned length, unsigned char* dst, unsigned char* checksum);
+#endif
+#ifdef HEX_CODEC_AVX2
+static bool cpu_supports_avx2(void);
+static unsigned char encode_avx2(const unsigned char* src, unsigned length, char* dst);
+static bool decode_avx2(const char* src, unsigned length, unsigned char* dst, unsigned char* checksum);
+#endif
+#ifdef HEX_CODEC_NEON
+static unsigned char encode_neon(const unsigned char* src, unsigned length, char* dst);
+static bool decode_neon(const char* src, unsigned length, unsigned char* dst, unsigned char* checksum);
+#endif
+static void init_tables(void);
+static void add_codec(const char* name, hex_encode_fn_t encode, hex_decode_fn_t decode);
+
+
+/***
+ * @brief Prepare the conversion tables and select the fastest implementation
+ *        supported by the CPU. Can be called more than once and from several threads
+ *        at the same time (e.g. the -targets worker threads) - the tables are prepared
+ *        only once and other threads wait until they are ready.
+ */
+
+void hex_codec_init(void)
+{
+    std::call_once(init_flag, init_tables);
+}
+
+
+/***
+ * @brief Prepare the conversion tables and the list of implementations (called once).
+ */
+
+static void init_tables(void)
+{
+    static const char hex_digits[] = "0123456789ABCDEF";
+
+    for (unsigned i = 0; i < 256U; i++)
+    {
+        hex_value[i] = HEX_INVALID;
+        hex_pair[i][0] = hex_digits[i >> 4];
+        hex_pair[i][1] = hex_digits[i & 0x0FU];
+        hex_pair_sum[i] = (unsigned char)(hex_pair[i][0] + hex_pair[i][1]);
+    }
+
+    for (unsigned i = 0; i < 10U; i++)
+    {
+        hex_value['0' + i] = (unsigned char)i;
+    }
+
+    for (unsigned i = 0; i < 6U; i++)
+    {
+        hex_value['A' + i] = (unsigned char)(10U + i);
+        hex_value['a' + i] = (unsigned char)(10U + i);
+    }
+
+    add_codec("scalar", encode_scalar, decode_scalar);
+#ifdef HEX_CODEC_SSE2
+    add_codec("SSE2", encode_sse2, decode_sse2);
+#endif
+#ifdef HEX_CODEC_AVX2
+    if (cpu_supports_avx2())
+    {
+        add_codec("AVX2", encode_avx2, decode_avx2);
+    }
+#endif
+#ifdef HEX_CODEC_NEON
+    add_codec("NEON", encode_neon, decode_neon);
+#endif
+
+    active_codec = &hex_codecs[number_of_codecs - 1U];
+}
+
+
+/***
+ * @brief Add an implementation to the list of supported implementations.
+ *        The implementations must be added from the slowest to the fastest one.
+ *
+ * @param name    Implementation name
+ * @param encode  Encode function
+ * @param decode  Decode function
+ */
+
+static void add_codec(const char* name, hex_encode_fn_t encode, hex_decode_fn_t decode)
+{
+    if (number_of_codecs < MAX_HEX_CODECS)
+    {
+        hex_codecs[number_of_codecs].name = name;
+        hex_codecs[number_of_codecs].encode = encode;
+        hex_codecs[number_of_codecs].decode = decode;
+        number_of_codecs++;
+    }
+}
+
+
+/***
+ * @brief Get an implementation supported by the CPU (used by the benchmark).
+ *
+ * @param index  Implementation index (0 = scalar)
+ *
+ * @return Pointer to the implementation or NULL if there is no implementation with this index
+ */
+
+const hex_codec_t* hex_codec_get(unsigned index)
+{
+    hex_codec_init();
+
+    if (index >= number_of_codecs)
+    {
+        return NULL;
+    }
+
+    return &hex_codecs[index];
+}
+
+
+/***
+ * @brief Name of the implementation used by hex_encode() and hex_decode().
+ *
+ * @return Implementation name
+ */
+
+const char* hex_codec_name(void)
+{
+    hex_codec_init();
+    return active_codec->name;
+}
+
+
+/***
+ * @brief Convert binary data to upper case hex characters.
+ *
+ * @param src     Binary data
+ * @param length  Number of bytes to convert
+ * @param dst     Buffer for 2 * length characters (no string terminator is added)
+ *
+ * @return Sum of the hex characters (modulo 256)
+ */
+
+unsigned char hex_encode(const unsigned char* src, unsigned length, char* dst)
+{
+    hex_codec_init();
+    return active_codec->encode(src, length, dst);
+}
+
+
+/***
+ * @brief Convert hex characters to binary data.
+ *
+ * @param src       Hex characters (upper or lower case)
+ * @param length    Number of bytes to write to 'dst' (2 * length characters are converted)
+ * @param dst       Buffer for the binary data
+ * @param checksum  Sum of all 2 * length characters (modulo 256)
+ *
+ * @return true if all characters are hex digits
+ */
+
+bool hex_decode(const char* src, unsigned length, unsigned char* dst, unsigned char* checksum)
+{
+    hex_codec_init();
+    return active_codec->decode(src, length, dst, checksum);
+}
+
+
+/***
+ * @brief Table driven conversion of binary data to hex characters.
+ */
+
+static unsigned char encode_scalar(const unsigned char* src, unsigned length, char* dst)
+{
+    unsigned sum = 0;
+
+    for (unsigned i = 0; i < length; i++)
+    {
+        const unsigned char data = src[i];
+        dst[0] = hex_pair[data][0];
+        dst[1] = hex_pair[data][1];
+        dst += 2;
+        sum += hex_pair_sum[data];
+    }
+
+    return (unsigned char)sum;
+}
+
+
+/***
+ * @brief Table driven conversion of hex characters to binary data.
+ */
+
+static bool decode_scalar(const char* src, unsigned length, unsigned char* dst, unsigned char* checksum)
+{
+    unsigned sum = 0;
+    unsigned invalid = 0;
+
+    for (unsigned i = 0; i < length; i++)
+    {
+        const unsigned char first = (unsigned char)src[0];
+        const unsigned char second = (unsigned char)src[1];
+        const unsigned high = hex_value[first];
+        const unsigned low = hex_value[second];
+        src += 2;
+
+        sum += (unsigned)first + second;
+        invalid |= high | low;
+        dst[i] = (unsigned char)((high << 4) | (low & 0x0FU));
+    }
+
+    *checksum = (unsigned char)sum;
+    return (invalid & HEX_INVALID) == 0;
+}
+
+
+#ifdef HEX_CODEC_SSE2
+
+/***
+ * @brief Convert 16 nibbles (values 0 - 15) to upper case hex characters.
+ */
+
+static inline __m128i sse2_hex_chars(__m128i nibbles)
+{
+    const __m128i letter_offset = _mm_and_si128(
+        _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('A' - '0' - 10));
+
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letter_offset);
+}
+
+
+/***
+ * @brief Convert 16 hex characters to their values. Bytes of 'invalid' are set
+ *        to 0xFF for characters that are not hex digits.
+ */
+
+static inline __m128i sse2_hex_values(__m128i chars, __m128i* invalid)
+{
+    const __m128i lower_case = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    const __m128i is_digit = _mm_and_si128(
+        _mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    const __m128i is_letter = _mm_and_si128(
+        _mm_cmpgt_epi8(lower_case, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower_case, _mm_set1_epi8('f' + 1)));
+    const __m128i is_hex = _mm_or_si128(is_digit, is_letter);
+
+    *invalid = _mm_or_si128(*invalid, _mm_cmpeq_epi8(is_hex, _mm_setzero_si128()));
+
+    return _mm_or_si128(
+        _mm_and_si128(is_digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+        _mm_and_si128(is_letter, _mm_sub_epi8(lower_case, _mm_set1_epi8('a' - 10))));
+}
+
+
+/***
+ * @brief Combine pairs of hex values (high nibble first) to 16 bit values 0 - 255.
+ */
+
+static inline __m128i sse2_combine_nibbles(__m128i values)
+{
+    const __m128i high = _mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00FF)), 4);
+    return _mm_or_si128(high, _mm_srli_epi16(values, 8));
+}
+
+
+/***
+ * @brief Sum of the two 64-bit lanes of the _mm_sad_epu8() results.
+ */
+
+static inline unsigned sse2_sum(__m128i sums)
+{
+    return (unsigned)_mm_cvtsi128_si32(sums) + (unsigned)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+}
+
+
+/***
+ * @brief SSE2 conversion of binary data to hex characters (16 bytes per step).
+ */
+
+static unsigned char encode_sse2(const unsigned char* src, unsigned length, char* dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i low_nibble = _mm_set1_epi8(0x0F);
+    __m128i sums = zero;
+    unsigned i = 0;
+
+    for (; (i + 16U) <= length; i += 16U)
+    {
+        const __m128i data = _mm_loadu_si128((const __m128i*)&src[i]);
+        const __m128i high = sse2_hex_chars(_mm_and_si128(_mm_srli_epi16(data, 4), low_nibble));
+        const __m128i low = sse2_hex_chars(_mm_and_si128(data, low_nibble));
+        const __m128i first = _mm_unpacklo_epi8(high, low);
+        const __m128i second = _mm_unpackhi_epi8(high, low);
+
+        _mm_storeu_si128((__m128i*)&dst[2U * i], first);
+        _mm_storeu_si128((__m128i*)&dst[2U * i + 16U], second);
+        sums = _mm_add_epi32(sums, _mm_add_epi32(_mm_sad_epu8(first, zero), _mm_sad_epu8(second, zero)));
+    }
+
+    unsigned sum = sse2_sum(sums);
+    return (unsigned char)(sum + encode_scalar(&src[i], length - i, &dst[2U * i]));
+}
+
+
+/***
+ * @brief SSE2 conversion of hex characters to binary data (16 bytes per step).
+ */
+
+static bool decode_sse2(const char* src, unsigned length, unsigned char* dst, unsigned char* checksum)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sums = zero;
+    __m128i invalid = zero;
+    unsigned i = 0;
+
+    for (; (i + 16U) <= length; i += 16U)
+    {
+        const __m128i first = _mm_loadu_si128((const __m128i*)&src[2U * i]);
+        const __m128i second = _mm_loadu_si128((const __m128i*)&src[2U * i + 16U]);
+        const __m128i data = _mm_packus_epi16(
+            sse2_combine_nibbles(sse2_hex_values(first, &invalid)),
+            sse2_combine_nibbles(sse2_hex_values(second, &invalid)));
+
+        _mm_storeu_si128((__m128i*)&dst[i], data);
+        sums = _mm_add_epi32(sums, _mm_add_epi32(_mm_sad_epu8(first, zero), _mm_sad_epu8(second, zero)));
+    }
+
+    unsigned char rest_sum;
+    bool rest_ok = decode_scalar(&src[2U * i], length - i, &dst[i], &rest_sum);
+    *checksum = (unsigned char)(sse2_sum(sums) + rest_sum);
+
+    return rest_ok && (_mm_movemask_epi8(invalid) == 0);
+}
+
+#endif  // HEX_CODEC_SSE2
+
+
+#ifdef HEX_CODEC_AVX2
+
+/***
+ * @brief Check if the CPU and operating system support the AVX2 instructions.
+ *
+ * @return true if AVX2 is supported
+ */
+
+static bool cpu_supports_avx2(void)
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    __cpuid(info, 1);
+
+    // OSXSAVE and AVX - the OS must save the YMM registers
+    if (((info[2] & (1 << 27)) == 0) || ((info[2] & (1 << 28)) == 0))
+    {
+        return false;
+    }
+
+    if ((_xgetbv(0) & 0x06U) != 0x06U)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+
+TARGET_AVX2 static inline __m256i avx2_hex_chars(__m256i nibbles)
+{
+    const __m256i letter_offset = _mm256_and_si256(
+        _mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9)), _mm256_set1_epi8('A' - '0' - 10));
+
+    return _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')), letter_offset);
+}
+
+
+TARGET_AVX2 static inline __m256i avx2_hex_values(__m256i chars, __m256i* invalid)
+{
+    const __m256i lower_case = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+    const __m256i is_digit = _mm256_andnot_si256(
+        _mm256_cmpgt_epi8(chars, _mm256_set1_epi8('9')), _mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)));
+    const __m256i is_letter = _mm256_andnot_si256(
+        _mm256_cmpgt_epi8(lower_case, _mm256_set1_epi8('f')), _mm256_cmpgt_epi8(lower_case, _mm256_set1_epi8('a' - 1)));
+    const __m256i is_hex = _mm256_or_si256(is_digit, is_letter);
+
+    *invalid = _mm256_or_si256(*invalid, _mm256_cmpeq_epi8(is_hex, _mm256_setzero_si256()));
+
+    return _mm256_or_si256(
+        _mm256_and_si256(is_digit, _mm256_sub_epi8(chars, _mm256_set1_epi8('0'))),
+        _mm256_and_si256(is_letter, _mm256_sub_epi8(lower_case, _mm256_set1_epi8('a' - 10))));
+}
+
+
+TARGET_AVX2 static inline __m256i avx2_combine_nibbles(__m256i values)
+{
+    const __m256i high = _mm256_slli_epi16(_mm256_and_si256(values, _mm256_set1_epi16(0x00FF)), 4);
+    return _mm256_or_si256(high, _mm256_srli_epi16(values, 8));
+}
+
+
+TARGET_AVX2 static inline unsigned avx2_sum(__m256i sums)
+{
+    const __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    return (unsigned)_mm_cvtsi128_si32(sum128) + (unsigned)_mm_cvtsi128_si32(_mm_srli_si128(sum128, 8));
+}
+
+
+/***
+ * @brief AVX2 conversion of binary data to hex characters (32 bytes per step).
+ */
+
+TARGET_AVX2 static unsigned char encode_avx2(const unsigned char* src, unsigned length, char* dst)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+    __m256i sums = zero;
+    unsigned i = 0;
+
+    for (; (i + 32U) <= length; i += 32U)
+    {
+        const __m256i data = _mm256_loadu_si256((const __m256i*)&src[i]);
+        const __m256i high = avx2_hex_chars(_mm256_and_si256(_mm256_srli_epi16(data, 4), low_nibble));
+        const __m256i low = avx2_hex_chars(_mm256_and_si256(data, low_nibble));
+
+        // Unpack works within the 128-bit lanes - put the results back in order
+        const __m256i interleaved_low = _mm256_unpacklo_epi8(high, low);    // Bytes 0-7, 16-23
+        const __m256i interleaved_high = _mm256_unpackhi_epi8(high, low);   // Bytes 8-15, 24-31
+        const __m256i first = _mm256_permute2x128_si256(interleaved_low, interleaved_high, 0x20);
+        const __m256i second = _mm256_permute2x128_si256(interleaved_low, interleaved_high, 0x31);
+
+        _mm256_storeu_si256((__m256i*)&dst[2U * i], first);
+        _mm256_storeu_si256((__m256i*)&dst[2U * i + 32U], second);
+        sums = _mm256_add_epi32(sums, _mm256_add_epi32(_mm256_sad_epu8(first, zero), _mm256_sad_epu8(second, zero)));
+    }
+
+    unsigned sum = avx2_sum(sums);
+    return (unsigned char)(sum + encode_sse2(&src[i], length - i, &dst[2U * i]));
+}
+
+
+/***
+ * @brief AVX2 conversion of hex characters to binary data (32 bytes per step).
+ */
+
+TARGET_AVX2 static bool decode_avx2(const char* src, unsigned length, unsigned char* dst, unsigned char* checksum)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sums = zero;
+    __m256i invalid = zero;
+    unsigned i = 0;
+
+    for (; (i + 32U) <= length; i += 32U)
+    {
+        const __m256i first = _mm256_loadu_si256((const __m256i*)&src[2U * i]);
+        const __m256i second = _mm256_loadu_si256((const __m256i*)&src[2U * i + 32U]);
+        const __m256i packed = _mm256_packus_epi16(
+            avx2_combine_nibbles(avx2_hex_values(first, &invalid)),
+            avx2_combine_nibbles(avx2_hex_values(second, &invalid)));
+
+        // Pack works within the 128-bit lanes - put the 64-bit blocks back in order
+        _mm256_storeu_si256((__m256i*)&dst[i], _mm256_permute4x64_epi64(packed, 0xD8));
+        sums = _mm256_add_epi32(sums, _mm256_add_epi32(_mm256_sad_epu8(first, zero), _mm256_sad_epu8(second, zero)));
+    }
+
+    unsigned char rest_sum;
+    bool rest_ok = decode_sse2(&src[2U * i], length - i, &dst[i], &rest_sum);
+    *checksum = (unsigned char)(avx2_sum(sums) + rest_sum);
+
+    return rest_ok && (_mm256_movemask_epi8(invalid) == 0);
+}
+
+#endif  // HEX_CODEC_AVX2
+
+
+#ifdef HEX_CODEC_NEON
+
+static inline uint8x16_t neon_hex_chars(uint8x16_t nibbles)
+{
+    const uint8x16_t letter_offset = vandq_u8(vcgtq_u8(nibbles, vdupq_n_u8(9)), vdupq_n_u8('A' - '0' - 10));
+    return vaddq_u8(vaddq_u8(nibbles, vdupq_n_u8('0')), letter_offset);
+}
+
+
+static inline uint8x16_t neon_hex_values(uint8x16_t chars, uint8x16_t* invalid)
+{
+    const uint8x16_t digit = vsubq_u8(chars, vdupq_n_u8('0'));
+    const uint8x16_t letter = vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    const uint8x16_t is_digit = vcltq_u8(digit, vdupq_n_u8(10));
+    const uint8x16_t is_letter = vcltq_u8(letter, vdupq_n_u8(6));
+
+    *invalid = vorrq_u8(*invalid, vmvnq_u8(vorrq_u8(is_digit, is_letter)));
+
+    return vorrq_u8(vandq_u8(is_digit, digit), vandq_u8(is_letter, vaddq_u8(letter, vdupq_n_u8(10))));
+}
+
+
+/***
+ * @brief NEON conversion of binary data to hex characters (16 bytes per step).
+ */
+
+static unsigned char encode_neon(const unsigned char* src, unsigned length, char* dst)
+{
+    uint32x4_t sums = vdupq_n_u32(0);
+    unsigned i = 0;
+
+    for (; (i + 16U) <= length; i += 16U)
+    {
+        const uint8x16_t data = vld1q_u8(&src[i]);
+        uint8x16x2_t chars;
+        chars.val[0] = neon_hex_chars(vshrq_n_u8(data, 4));
+        chars.val[1] = neon_hex_chars(vandq_u8(data, vdupq_n_u8(0x0F)));
+
+        vst2q_u8((uint8_t*)&dst[2U * i], chars);    // Interleave the high and low nibble characters
+        sums = vpadalq_u16(sums, vaddq_u16(vpaddlq_u8(chars.val[0]), vpaddlq_u8(chars.val[1])));
+    }
+
+    unsigned sum = vaddvq_u32(sums);
+    return (unsigned char)(sum + encode_scalar(&src[i], length - i, &dst[2U * i]));
+}
+
+
+/***
+ * @brief NEON conversion of hex characters to binary data (16 bytes per step).
+ */
+
+static bool decode_neon(const char* src, unsigned length, unsigned char* dst, unsigned char* checksum)
+{
+    uint32x4_t sums = vdupq_n_u32(0);
+    uint8x16_t invalid = vdupq_n_u8(0);
+    unsigned i = 0;
+
+    for (; (i + 16U) <= length; i += 16U)
+    {
+        const uint8x16x2_t chars = vld2q_u8((const uint8_t*)&src[2U * i]);    // High and low nibble characters
+        const uint8x16_t high = neon_hex_values(chars.val[0], &invalid);
+        const uint8x16_t low = neon_hex_values(chars.val[1], &invalid);
+
+        vst1q_u8(&dst[i], vorrq_u8(vshlq_n_u8(high, 4), low));
+        sums = vpadalq_u16(sums, vaddq_u16(vpaddlq_u8(chars.val[0]), vpaddlq_u8(chars.val[1])));
+    }
+
+    unsigned char rest_sum;
+    bool rest_ok = decode_scalar(&src[2U * i], length - i, &dst[i], &rest_sum);
+    *checksum = (unsigned char)(vaddvq_u32(sums) + rest_sum);
+
+    return rest_ok && (vmaxvq_u8(invalid) == 0);
+}
+
+#endif  // HEX_CODEC_NEON
+
+/*==== End of file ====*/
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    hex_codec.h
+ * @author  B. Premzel
+ * @brief   Conversion of binary data to hex characters and back for the GDB
+ *          memory read and write packets. The packet checksum is calculated
+ *          in the same pass.
+ */
+
+#ifndef _HEX_CODEC_H
+#define _HEX_CODEC_H
+
+/* Convert 'length' bytes to 2 * 'length' upper case hex characters.
+ * Returns the sum (modulo 256) of the hex characters. */
+typedef unsigned char (*hex_encode_fn_t)(const unsigned char* src, unsigned length, char* dst);
+
+/* Convert 2 * 'length' hex characters to 'length' bytes. The sum (modulo 256) of
+ * all characters is always calculated - also if the data is not valid.
+ * Returns false if a character is not a hex digit. */
+typedef bool (*hex_decode_fn_t)(const char* src, unsigned length, unsigned char* dst, unsigned char* checksum);
+
+typedef struct
+{
+    const char* name;               // Implementation name (scalar, SSE2, AVX2, NEON)
+    hex_encode_fn_t encode;
+    hex_decode_fn_t decode;
+} hex_codec_t;
+
+void hex_codec_init(void);
+const hex_codec_t* hex_codec_get(unsigned index);
+const char* hex_codec_name(void);
+unsigned char hex_encode(const unsigned char* src, unsigned length, char* dst);
+bool hex_decode(const char* src, unsigned length, unsigned char* dst, unsigned char* checksum);
+
+#endif  // _HEX_CODEC_H
+
+/*==== End of file ====*/
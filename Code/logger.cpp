@@ -8,10 +8,29 @@
  * @file    logger.cpp
  * @brief   Time measurement and data logging to a file or to the console.
  * @author  B. Premzel
+ *
+ * Messages logged to a file are not formatted and written by the calling thread. The log
+ * functions copy the format string pointer, the values and the text into a circular buffer
+ * (lock-free - any thread can log) and the log writer thread formats and writes them to the
+ * file every LOG_WRITE_INTERVAL ms. Logging therefore does not slow down the data transfer.
+ * Errors are written immediately. The buffer is also written at the program exit, before
+ * the files are closed (log_flush()) and if the program is terminated with Ctrl-C (SIGINT)
+ * or SIGTERM - the signal handler only sets a flag and the log writer thread writes the
+ * messages and terminates the program.
+ * Messages logged to the console are written immediately (together with other console output).
  */
 
 
 #include "pch.h"
+#include <stdint.h>
+#include <string.h>
+#include <cstddef>
+#include <signal.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <system_error>
+#include <thread>
 #include "logger.h"
 #include "gdb_defs.h"
 #include "gdb_lib.h"
@@ -20,11 +39,78 @@
     #include <share.h>
 #endif
 
+#define LOG_BUFFER_SIZE      (4U * 1024U * 1024U)   // Circular buffer size [bytes] (power of 2)
+#define LOG_MAX_RECORD_SIZE  (LOG_BUFFER_SIZE / 4U) // Longer messages are truncated
+#define LOG_WRITE_INTERVAL   20                     // Time between two log file writes [ms]
+#define LOG_RECORD_ALIGN     8U
+
+
+typedef enum
+{
+    LOG_LEVEL_ERROR,                        // Written to the log file immediately
+    LOG_LEVEL_INFO,                         // Information about the operation
+    LOG_LEVEL_DEBUG                         // Communication log (-debug)
+} log_level_t;
+
+typedef enum
+{
+    LOG_RECORD_PADDING,                     // Unused space at the end of the circular buffer
+    LOG_RECORD_DATA,                        // log_data()
+    LOG_RECORD_STRING,                      // log_string()
+    LOG_RECORD_TIMING,                      // log_timing()
+    LOG_RECORD_SOCKET_ERROR,                // log_wsock_error()
+    LOG_RECORD_COMM_TEXT,                   // log_communication_text()
+    LOG_RECORD_COMM_HEX                     // log_communication_hex()
+} log_record_type_t;
+
+// Circular buffer record header - followed by text1 and text2 (zero terminated copies)
+typedef struct
+{
+    uint32_t size;                          // Record size incl. header (0 = not written completely yet)
+                                            // Accessed with commit_word() only
+    uint8_t type;                           // log_record_type_t
+    uint8_t reserved[3];
+    const char* format;                     // Format string (string literal)
+    long long value;                        // Value, socket error code or 1 if log_string() has a string parameter
+    double time;                            // Time [ms]
+    uint32_t text1_length;                  // Number of bytes in the first text (without the terminator)
+    uint32_t text2_length;                  // Number of bytes in the second text (without the terminator)
+} log_record_t;
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Unexpected atomic variable size");
+static_assert((sizeof(log_record_t) % LOG_RECORD_ALIGN) == 0, "Record header size must be aligned");
+
 
 /*---------------- GLOBAL VARIABLES ------------------*/
-static FILE * log_output = stdout;      // File to which the messages will be logged (default = console)
+static std::atomic<FILE*> log_output(stdout); // File to which the messages will be logged (default = console)
+                                        // Changed only with the log_writer_mutex locked
 static bool logging_enabled = true;     // false - do not log any information
 static LARGE_INTEGER Frequency;         // Frequency of the performance counter
+static LARGE_INTEGER log_start_time;    // Time reference for the communication log
+static bool log_timer_started = false;
+
+alignas(LOG_RECORD_ALIGN) static unsigned char log_buffer[LOG_BUFFER_SIZE];
+static std::atomic<uint64_t> write_position(0);     // Space reserved by the log functions up to here
+static std::atomic<uint64_t> read_position(0);      // Records written to the file up to here
+static std::mutex log_writer_mutex;     // Only one thread formats and writes the records
+static std::thread log_writer;
+static std::atomic<bool> log_writer_running(false);
+static std::atomic<bool> log_writer_stop(false);
+static std::atomic<int> termination_signal(0);   // SIGINT or SIGTERM received (0 = none), lock-free
+
+
+/*---------------- Local functions ---------------*/
+static void start_log_writer(void);
+static void stop_log_writer(void);
+static void log_writer_thread(void);
+static void termination_signal_handler(int signal_number);
+static void add_record(log_level_t level, log_record_type_t type, const char* format, long long value,
+    double time, const char* text1, size_t text1_length, const char* text2, size_t text2_length);
+static unsigned char* reserve_record(uint32_t size);
+static std::atomic<uint32_t>* commit_word(unsigned char* record);
+static void write_log_records(void);
+static void write_record(FILE* output, const log_record_t* record);
+static const char* socket_error_description(int sock_err);
 
 
 /***
@@ -68,25 +154,128 @@ bool logging_to_file(void)
 
 void create_log_file(const char * file_name)
 {
-    if (file_name == NULL)
-    {
-        log_output = stdout;
-    }
-    else
+    FILE* file = stdout;
+
+    if (file_name != NULL)
     {
         // Open the file for reading and writing so that it can be read while it
         // is being written in case it is being opened by a log viewer software.
 #ifdef _WIN32
-        log_output = _fsopen(file_name, "w+", _SH_DENYNO);
+        file = _fsopen(file_name, "w+", _SH_DENYNO);
 #else
-        log_output = fopen(file_name, "w+");
+        file = fopen(file_name, "w+");
 #endif
 
-        if (log_output == NULL)
+        if (file == NULL)
         {
-            log_output = stdout;
+            file = stdout;
         }
     }
+
+    {
+        // Messages logged before are written to the previous output
+        std::lock_guard<std::mutex> lock(log_writer_mutex);
+        write_log_records();
+        log_output = file;
+    }
+
+    if (file != stdout)
+    {
+        start_log_writer();
+    }
+}
+
+
+/***
+ * @brief Write all messages from the circular buffer to the log file.
+ *        Must be called before the log file is closed (e.g. with _fcloseall()).
+ */
+
+void log_flush(void)
+{
+    std::lock_guard<std::mutex> lock(log_writer_mutex);
+    write_log_records();
+}
+
+
+/***
+ * @brief Start the log writer thread (once) and register the exit and signal handlers that
+ *        write the remaining messages to the file.
+ *        Without the log writer thread the messages are written by the log functions.
+ */
+
+static void start_log_writer(void)
+{
+    if (log_writer_running)
+    {
+        return;
+    }
+
+    try
+    {
+        log_writer = std::thread(log_writer_thread);
+    }
+    catch (const std::system_error&)
+    {
+        return;
+    }
+
+    log_writer_running = true;
+    (void)atexit(stop_log_writer);
+
+    (void)signal(SIGINT, termination_signal_handler);
+    (void)signal(SIGTERM, termination_signal_handler);
+}
+
+
+/***
+ * @brief Stop the log writer thread and write the remaining messages (called at the program exit).
+ */
+
+static void stop_log_writer(void)
+{
+    log_writer_stop = true;
+
+    if (log_writer.joinable())
+    {
+        log_writer.join();
+    }
+
+    log_writer_running = false;
+    log_flush();
+}
+
+
+/***
+ * @brief Log writer thread - write the messages from the circular buffer to the log file periodically.
+ */
+
+static void log_writer_thread(void)
+{
+    while (!log_writer_stop)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(LOG_WRITE_INTERVAL));
+        log_flush();
+        int signal_number = termination_signal;
+
+        if (signal_number != 0)
+        {
+            // Terminate the program as the default signal handler would
+            (void)signal(signal_number, SIG_DFL);
+            (void)raise(signal_number);
+        }
+    }
+}
+
+
+/***
+ * @brief SIGINT (Ctrl-C) and SIGTERM handler. Only the signal number is saved (async-signal-safe).
+ *        The log writer thread writes the remaining messages and terminates the program.
+ */
+
+static void termination_signal_handler(int signal_number)
+{
+    termination_signal = signal_number;
 }
 
 
@@ -110,6 +299,33 @@ void start_timer(LARGE_INTEGER * timer)
 }
 
 
+/***
+ * @brief Set the time reference for the communication log time stamps
+ *        (e.g. time of connection to the GDB server).
+ */
+
+void start_log_timer(void)
+{
+    start_timer(&log_start_time);
+    log_timer_started = true;
+}
+
+
+/***
+ * @brief Time elapsed since the start of the communication log [ms].
+ */
+
+static double log_time(void)
+{
+    if (!log_timer_started)
+    {
+        start_log_timer();
+    }
+
+    return time_elapsed(&log_start_time);
+}
+
+
 /***
  * @brief Log a value with a text message
  * 
@@ -121,12 +337,7 @@ void log_data(const char * text, long long int data)
 {
     if (logging_enabled | parameters.debug_mode)
     {
-        fprintf(log_output, text, data);
-
-        if (logging_to_file())
-        {
-            fflush(log_output);
-        }
+        add_record(LOG_LEVEL_INFO, LOG_RECORD_DATA, text, data, 0, NULL, 0, NULL, 0);
     }
 }
 
@@ -142,19 +353,8 @@ void log_string(const char * text, const char * string)
 {
     if (logging_enabled | parameters.debug_mode)
     {
-        if (string != NULL)
-        {
-            fprintf(log_output, text, string);
-        }
-        else
-        {
-            fprintf(log_output, "%s", text);
-        }
-
-        if (logging_to_file())
-        {
-            fflush(log_output);
-        }
+        add_record(LOG_LEVEL_INFO, LOG_RECORD_STRING, NULL, (string != NULL) ? 1 : 0, 0,
+            text, strlen(text), string, (string != NULL) ? strlen(string) : 0);
     }
 }
 
@@ -185,12 +385,7 @@ void log_timing(const char * text, LARGE_INTEGER * start_timer)
         double time_elapsed = (double)elapsed.QuadPart * 1e3 / (double)Frequency.QuadPart;
         
         // Log the elapsed time with the provided text message
-        fprintf(log_output, text, time_elapsed);
-
-        if (logging_to_file())
-        {
-            fflush(log_output);
-        }
+        add_record(LOG_LEVEL_INFO, LOG_RECORD_TIMING, text, 0, time_elapsed, NULL, 0, NULL, 0);
     }
 }
 
@@ -211,97 +406,85 @@ void log_wsock_error(const char * text)
     // Get the last socket error
 #ifdef _WIN32
     int sock_err = WSAGetLastError();
-    fprintf(log_output, "%s - Winsock error %d", text, sock_err);
 #else
     int sock_err = errno;
-    fprintf(log_output, "%s - Socket error %d", text, sock_err);
 #endif
 
-    // Log specific error messages based on the error code
+    add_record(LOG_LEVEL_ERROR, LOG_RECORD_SOCKET_ERROR, NULL, sock_err, 0, text, strlen(text), NULL, 0);
+}
+
+
+/***
+ * @brief Description of the socket error code
+ *
+ * @param sock_err  Winsock or socket error code
+ *
+ * @return Text to be added to the error message (empty if not known)
+ */
+
+static const char* socket_error_description(int sock_err)
+{
 #ifdef _WIN32
     switch (sock_err)
     {
     case WSAETIMEDOUT:
-        fprintf(log_output, " - (time-out). ");
-        break;
+        return " - (time-out). ";
 
     case WSAECONNRESET:
-        fprintf(log_output, " - (an existing connection was forcibly closed). ");
-        break;
+        return " - (an existing connection was forcibly closed). ";
 
     case WSAECONNABORTED:
-        fprintf(log_output, " - (an established connection was aborted). ");
-        break;
+        return " - (an established connection was aborted). ";
 
     case WSAECONNREFUSED:
-        fprintf(log_output, " - (connection refused - i.e. no service at this port). ");
-        break;
+        return " - (connection refused - i.e. no service at this port). ";
 
     case WSAEADDRINUSE:
-        fprintf(log_output, " - (only one usage of each socket address (protocol/network address/port) is normally permitted).");
-        break;
+        return " - (only one usage of each socket address (protocol/network address/port) is normally permitted).";
 
     case WSAENETUNREACH:
-        fprintf(log_output, " - (a socket operation was attempted to an unreachable network). ");
-        break;
+        return " - (a socket operation was attempted to an unreachable network). ";
 
     case WSAEISCONN:
-        fprintf(log_output, " - (a connect request was made on an already connected socket). ");
-        break;
+        return " - (a connect request was made on an already connected socket). ";
 
     case WSAEHOSTDOWN:
-        fprintf(log_output, " - (a socket operation failed because the destination host was down). ");
-        break;
+        return " - (a socket operation failed because the destination host was down). ";
 
     default:
-        break;
+        return "";
     }
 #else
     switch (sock_err)
     {
     case ETIMEDOUT:
-        fprintf(log_output, " - (time-out). ");
-        break;
+        return " - (time-out). ";
 
     case ECONNRESET:
-        fprintf(log_output, " - (connection reset by peer). ");
-        break;
+        return " - (connection reset by peer). ";
 
     case ECONNABORTED:
-        fprintf(log_output, " - (software caused connection abort). ");
-        break;
+        return " - (software caused connection abort). ";
 
     case ECONNREFUSED:
-        fprintf(log_output, " - (connection refused). ");
-        break;
+        return " - (connection refused). ";
 
     case EADDRINUSE:
-        fprintf(log_output, " - (address already in use). ");
-        break;
+        return " - (address already in use). ";
 
     case ENETUNREACH:
-        fprintf(log_output, " - (network is unreachable). ");
-        break;
+        return " - (network is unreachable). ";
 
     case EISCONN:
-        fprintf(log_output, " - (transport endpoint is already connected). ");
-        break;
+        return " - (transport endpoint is already connected). ";
 
     case EHOSTDOWN:
-        fprintf(log_output, " - (host is down). ");
-        break;
+        return " - (host is down). ";
 
     default:
-        break;
+        return "";
     }
 #endif
-
-    fprintf(log_output, "\n");
-
-    if (logging_to_file())
-    {
-        fflush(log_output);
-    }
 }
 
 
@@ -343,15 +526,10 @@ double time_elapsed(LARGE_INTEGER * start_timer)
 
 void log_communication_text(const char* direction, const char* msg, int length)
 {
-    if (parameters.debug_mode)
+    if (parameters.debug_mode && (length >= 0))
     {
-        fprintf(log_output, "\n%6.3f ms [%s: %.*s]\n",
-            (double)(clock_ms() - app_start_time) / CLOCKS_PER_SEC * 1000, direction, length, msg);
-
-        if (logging_to_file())
-        {
-            fflush(log_output);
-        }
+        add_record(LOG_LEVEL_DEBUG, LOG_RECORD_COMM_TEXT, NULL, 0, log_time(),
+            direction, strlen(direction), msg, (size_t)length);
     }
 }
 
@@ -366,22 +544,10 @@ void log_communication_text(const char* direction, const char* msg, int length)
 
 void log_communication_hex(const char* direction, const char* msg, int length)
 {
-    if (parameters.debug_mode)
+    if (parameters.debug_mode && (length >= 0))
     {
-        fprintf(log_output, "\n%6.3f ms [%s (hex): ",
-            (double)(clock_ms() - app_start_time) / CLOCKS_PER_SEC * 1000, direction);
-
-        for (int i = 0; i < length; i++)
-        {
-            fprintf(log_output, "%02X ", 0xFF & (unsigned)msg[i]);
-        }
-
-        fprintf(log_output, "]\n");
-
-        if (logging_to_file())
-        {
-            fflush(log_output);
-        }
+        add_record(LOG_LEVEL_DEBUG, LOG_RECORD_COMM_HEX, NULL, 0, log_time(),
+            direction, strlen(direction), msg, (size_t)length);
     }
 }
 
@@ -400,9 +566,14 @@ void disable_enable_logging_to_file(void)
 
     if (logging_to_file())
     {
-        fflush(log_output);
-        fclose(log_output);
-        log_output = stdout;
+        {
+            std::lock_guard<std::mutex> lock(log_writer_mutex);
+            write_log_records();
+            FILE* file = log_output;
+            log_output = stdout;
+            fclose(file);
+        }
+
         printf("\nLogging to file disabled.\n");
     }
     else
@@ -413,4 +584,239 @@ void disable_enable_logging_to_file(void)
 }
 
 
+/***
+ * @brief Copy the message data to the circular buffer. The message is formatted and written
+ *        later by the log writer thread. It is written immediately if logging to the console,
+ *        in case of errors or if the log writer thread is not running.
+ *
+ * @param level         Message severity
+ * @param type          Record type (log function)
+ * @param format        Format string - must be a string literal (used after the function returns)
+ * @param value         Value to be logged
+ * @param time          Time value to be logged [ms]
+ * @param text1         First text to be copied (NULL if not used)
+ * @param text1_length  Length of the first text
+ * @param text2         Second text to be copied (NULL if not used)
+ * @param text2_length  Length of the second text
+ */
+
+static void add_record(log_level_t level, log_record_type_t type, const char* format, long long value,
+    double time, const char* text1, size_t text1_length, const char* text2, size_t text2_length)
+{
+    // Truncate very long messages (the second text is the message data)
+    const size_t max_text_length = LOG_MAX_RECORD_SIZE - sizeof(log_record_t) - 2U * LOG_RECORD_ALIGN;
+
+    if (text1_length > max_text_length)
+    {
+        text1_length = max_text_length;
+    }
+
+    if (text2_length > (max_text_length - text1_length))
+    {
+        text2_length = max_text_length - text1_length;
+    }
+
+    uint32_t size = (uint32_t)(sizeof(log_record_t) + text1_length + text2_length + 2U);
+    size = (size + LOG_RECORD_ALIGN - 1U) & ~(LOG_RECORD_ALIGN - 1U);
+    unsigned char* data = reserve_record(size);
+
+    log_record_t* record = (log_record_t*)data;
+    record->type = (uint8_t)type;
+    memset(record->reserved, 0, sizeof(record->reserved));
+    record->format = format;
+    record->value = value;
+    record->time = time;
+    record->text1_length = (uint32_t)text1_length;
+    record->text2_length = (uint32_t)text2_length;
+
+    char* text = (char*)(data + sizeof(log_record_t));
+
+    if (text1_length != 0)
+    {
+        memcpy(text, text1, text1_length);
+    }
+
+    text[text1_length] = '\0';
+    text += text1_length + 1U;
+
+    if (text2_length != 0)
+    {
+        memcpy(text, text2, text2_length);
+    }
+
+    text[text2_length] = '\0';
+    commit_word(data)->store(size, std::memory_order_release);
+
+    if (!logging_to_file() || (level == LOG_LEVEL_ERROR) || !log_writer_running)
+    {
+        log_flush();
+    }
+}
+
+
+/***
+ * @brief Reserve space for a record in the circular buffer. A padding record is added
+ *        if the record does not fit before the end of the buffer. If the buffer is full,
+ *        the function waits until the records are written to the file.
+ *
+ * @param size  Record size [bytes] (multiple of LOG_RECORD_ALIGN)
+ *
+ * @return Pointer to the reserved space
+ */
+
+static unsigned char* reserve_record(uint32_t size)
+{
+    uint64_t position = write_position.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        uint32_t offset = (uint32_t)(position & (LOG_BUFFER_SIZE - 1U));
+        uint32_t padding = ((offset + size) > LOG_BUFFER_SIZE) ? (LOG_BUFFER_SIZE - offset) : 0;
+
+        if ((position + padding + size - read_position.load(std::memory_order_acquire)) > LOG_BUFFER_SIZE)
+        {
+            // Buffer full - write the records (or wait for the log writer thread)
+            if (log_writer_mutex.try_lock())
+            {
+                write_log_records();
+                log_writer_mutex.unlock();
+            }
+
+            std::this_thread::yield();
+            position = write_position.load(std::memory_order_relaxed);
+            continue;
+        }
+
+        if (write_position.compare_exchange_weak(position, position + padding + size,
+            std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            if (padding != 0)
+            {
+                log_buffer[offset + offsetof(log_record_t, type)] = (unsigned char)LOG_RECORD_PADDING;
+                commit_word(&log_buffer[offset])->store(padding, std::memory_order_release);
+            }
+
+            return &log_buffer[(position + padding) & (LOG_BUFFER_SIZE - 1U)];
+        }
+    }
+}
+
+
+/***
+ * @brief Record size word - set when the record has been written completely.
+ */
+
+static std::atomic<uint32_t>* commit_word(unsigned char* record)
+{
+    return reinterpret_cast<std::atomic<uint32_t>*>(record);
+}
+
+
+/***
+ * @brief Write the completely written records from the circular buffer to the log file.
+ *        The log_writer_mutex must be locked by the caller.
+ */
+
+static void write_log_records(void)
+{
+    FILE* output = log_output;
+    bool written = false;
+
+    for (;;)
+    {
+        uint64_t position = read_position.load(std::memory_order_relaxed);
+
+        if (position == write_position.load(std::memory_order_acquire))
+        {
+            break;
+        }
+
+        unsigned char* data = &log_buffer[position & (LOG_BUFFER_SIZE - 1U)];
+        uint32_t size = commit_word(data)->load(std::memory_order_acquire);
+
+        if (size == 0)
+        {
+            break;      // Not written completely yet
+        }
+
+        const log_record_t* record = (const log_record_t*)data;
+
+        if (record->type != LOG_RECORD_PADDING)
+        {
+            write_record(output, record);
+            written = true;
+        }
+
+        // The size words of the next records must be zero (not written yet)
+        memset(data, 0, size);
+        read_position.store(position + size, std::memory_order_release);
+    }
+
+    if (written && (output != stdout))
+    {
+        fflush(output);
+    }
+}
+
+
+/***
+ * @brief Format and write one record to the log file or console.
+ */
+
+static void write_record(FILE* output, const log_record_t* record)
+{
+    const char* text1 = (const char*)record + sizeof(log_record_t);
+    const char* text2 = text1 + record->text1_length + 1U;
+
+    switch (record->type)
+    {
+        case LOG_RECORD_DATA:
+            fprintf(output, record->format, record->value);
+            break;
+
+        case LOG_RECORD_STRING:
+            if (record->value != 0)
+            {
+                fprintf(output, text1, text2);
+            }
+            else
+            {
+                fprintf(output, "%s", text1);
+            }
+            break;
+
+        case LOG_RECORD_TIMING:
+            fprintf(output, record->format, record->time);
+            break;
+
+        case LOG_RECORD_SOCKET_ERROR:
+#ifdef _WIN32
+            fprintf(output, "%s - Winsock error %d", text1, (int)record->value);
+#else
+            fprintf(output, "%s - Socket error %d", text1, (int)record->value);
+#endif
+            fprintf(output, "%s\n", socket_error_description((int)record->value));
+            break;
+
+        case LOG_RECORD_COMM_TEXT:
+            fprintf(output, "\n%9.3f ms [%s: %.*s]\n", record->time, text1, (int)record->text2_length, text2);
+            break;
+
+        case LOG_RECORD_COMM_HEX:
+            fprintf(output, "\n%9.3f ms [%s (hex): ", record->time, text1);
+
+            for (uint32_t i = 0; i < record->text2_length; i++)
+            {
+                fprintf(output, "%02X ", 0xFF & (unsigned)text2[i]);
+            }
+
+            fprintf(output, "]\n");
+            break;
+
+        default:
+            break;
+    }
+}
+
+
 /*==== End of file ====*/
@@ -26,7 +26,9 @@
 
 void enable_logging(bool on_off);
 void create_log_file(const char* file_name);
+void log_flush(void);
 void start_timer(LARGE_INTEGER * start_timer);
+void start_log_timer(void);
 void log_data(const char * text, long long int data);
 void log_string(const char * text, const char * string);
 void log_timing(const char * text, LARGE_INTEGER * start);
@@ -0,0 +1,818 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    multi_target.cpp
+ * @brief   Data transfer from several embedded systems in one process (-targets=file_name).
+ *          Each target (GDB server port, g_rtedbg address and output file) is serviced by its
+ *          own worker thread with its own GDB server connection (GdbSession object). The
+ *          worker threads wait for a transfer request and the main thread waits for the
+ *          transfers to finish - the host CPU load does not increase with the number of
+ *          targets. The embedded system status is not polled between the transfers.
+ * @author  B. Premzel
+ */
+
+#include "pch.h"
+#include <stdlib.h>
+#include <cstddef>
+#include <cstring>
+#include <cctype>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <system_error>
+#include "RTEgetData.h"
+#include "cmd_line.h"
+#include "rtedbg.h"
+#include "logger.h"
+#include "platform_compat.h"
+#include "gdb_session.h"
+#include "data_transfer.h"
+#include "multi_target.h"
+
+
+typedef struct
+{
+    std::thread thread;
+    bool started;               // Worker thread running
+    const char* ip_address;     // GDB server IP address
+    unsigned short gdb_port;    // GDB server port number
+    unsigned start_address;     // Address of the g_rtedbg structure
+    const char* output_file;    // Binary file for the g_rtedbg structure
+    bool transfer_request;      // Transfer requested by the main thread
+    bool exit_request;          // Close the connection and stop the thread
+    int result;                 // Result of the last transfer (RTE_OK / RTE_ERROR)
+    const char* status;         // Result description
+    unsigned size;              // Size of the last g_rtedbg structure transferred [bytes]
+    double transfer_time;       // Duration of the last transfer [ms]
+    unsigned transfers;         // Number of successful transfers
+    unsigned errors;            // Number of failed transfers
+} target_t;
+
+typedef struct
+{
+    GdbSession* session;        // GDB server connection of the target
+    target_t* target;
+    unsigned* structure;        // Host copy of the g_rtedbg structure
+    unsigned capacity;          // Size of the allocated buffer [bytes]
+    unsigned size;              // Size of the structure read [bytes]
+} target_connection_t;
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static target_t targets[MAX_TARGETS];
+static unsigned number_of_targets = 0;
+static unsigned transfers_pending = 0;          // Number of targets with unfinished transfer
+static std::mutex targets_mutex;                // Protects the target status variables
+static std::condition_variable targets_event;   // Signalled when a target status changes
+
+
+/*---------------- Local functions ---------------*/
+static int  load_target_list(const char* file_name);
+static char* next_token(char** text);
+static char* copy_string(const char* text);
+static void free_target_list(void);
+static void start_target_threads(void);
+static void stop_target_threads(void);
+static int  transfer_from_all_targets(void);
+static void print_target_status(double round_time);
+static int  multi_target_commands(void);
+static void target_thread_function(target_t* target);
+static int  transfer_target_data(target_connection_t* connection);
+static int  read_target_structure(void* connection, const rtedbg_header_t* header, uint32_t old_filter);
+static int  read_session_memory(void* connection, unsigned char* buffer, unsigned address, unsigned length);
+static int  write_session_memory(void* connection, const unsigned char* buffer, unsigned address, unsigned length);
+static int  fill_session_memory(void* connection, unsigned address, unsigned pattern, unsigned length);
+static int  write_target_file(const char* file_name, const unsigned* data, unsigned size);
+
+
+/***
+ * @brief Transfer the g_rtedbg structures from all targets defined in the -targets=file_name
+ *        file. A single transfer is done for all targets or the transfers are started with
+ *        the 'Space' key if the -p argument is used.
+ *
+ * @return RTE_OK    - data transferred from all targets
+ *         RTE_ERROR - target list not loaded or transfer from at least one target failed
+ */
+
+int multi_target_collection(void)
+{
+    if (load_target_list(parameters.targets_file) != RTE_OK)
+    {
+        free_target_list();
+        return RTE_ERROR;
+    }
+
+    // The console shows only the target status lines. The messages of different
+    // targets may be interleaved in the log file (-log=file_name).
+    bool console_logging = !logging_to_file();
+
+    if (console_logging)
+    {
+        enable_logging(false);
+    }
+
+    start_target_threads();
+    int rez;
+
+    if (parameters.persistent_connection)
+    {
+        rez = multi_target_commands();
+    }
+    else
+    {
+        rez = transfer_from_all_targets();
+    }
+
+    stop_target_threads();
+    enable_logging(true);
+    free_target_list();
+    return rez;
+}
+
+
+/***
+ * @brief Load the list of targets. Each line defines one target:
+ *        [ip_address:]port  g_rtedbg_address  output_file
+ *        Empty lines and lines starting with '#' are ignored.
+ *
+ * @param file_name  Target list file name
+ *
+ * @return RTE_OK    - list loaded
+ *         RTE_ERROR - file not found or bad file contents
+ */
+
+static int load_target_list(const char* file_name)
+{
+    FILE* file;
+
+    if (fopen_s(&file, file_name, "r") != 0)
+    {
+        printf("\nCannot open the target list file \"%s\".", file_name);
+        return RTE_ERROR;
+    }
+
+    char line[MAX_TARGET_LINE_LEN];
+    unsigned line_number = 0;
+    int rez = RTE_OK;
+
+    while ((rez == RTE_OK) && (fgets(line, sizeof(line), file) != NULL))
+    {
+        line_number++;
+        char* text = line;
+        char* port = next_token(&text);
+
+        if ((port == NULL) || (port[0] == '#'))
+        {
+            continue;
+        }
+
+        char* address = next_token(&text);
+        char* output_file = next_token(&text);
+        char* separator = strrchr(port, ':');
+        target_t* target = &targets[number_of_targets];
+        unsigned port_number = 0;
+        unsigned start_address = 0;
+        rez = RTE_ERROR;
+
+        if (number_of_targets >= MAX_TARGETS)
+        {
+            printf("\nMore than %u targets defined in \"%s\".", MAX_TARGETS, file_name);
+            break;
+        }
+
+        if (separator != NULL)
+        {
+            *separator = '\0';
+        }
+
+        if ((address == NULL) || (output_file == NULL) || (next_token(&text) != NULL)
+            || (sscanf_s((separator != NULL) ? separator + 1 : port, "%u", &port_number) != 1)
+            || (port_number == 0) || (port_number > 65535U)
+            || (sscanf_s(address, "%x", &start_address) != 1) || ((start_address & 3U) != 0))
+        {
+            printf("\nBad target definition in line %u of \"%s\"."
+                "\nExpected: [ip_address:]port  g_rtedbg_address  output_file", line_number, file_name);
+            break;
+        }
+
+        target->ip_address = (separator != NULL) ? copy_string(port) : parameters.ip_address;
+        target->output_file = copy_string(output_file);
+        target->gdb_port = (unsigned short)port_number;
+        target->start_address = start_address;
+        number_of_targets++;
+
+        if ((target->ip_address == NULL) || (target->output_file == NULL))
+        {
+            printf("\nOut of memory.");
+            break;
+        }
+
+        rez = RTE_OK;
+    }
+
+    (void)fclose(file);
+
+    if ((rez == RTE_OK) && (number_of_targets == 0))
+    {
+        printf("\nNo targets defined in \"%s\".", file_name);
+        rez = RTE_ERROR;
+    }
+
+    return rez;
+}
+
+
+/***
+ * @brief Find the next space separated or quoted token in the text and terminate it.
+ *
+ * @param text  Pointer to the text - moved after the token
+ *
+ * @return Pointer to the token or NULL if there are no more tokens
+ */
+
+static char* next_token(char** text)
+{
+    char* p = *text;
+
+    while ((*p != '\0') && isspace((unsigned char)*p))
+    {
+        p++;
+    }
+
+    if (*p == '\0')
+    {
+        *text = p;
+        return NULL;
+    }
+
+    char* token = p;
+
+    if (*p == '"')
+    {
+        token = ++p;
+
+        while ((*p != '\0') && (*p != '"') && (*p != '\n') && (*p != '\r'))
+        {
+            p++;
+        }
+    }
+    else
+    {
+        while ((*p != '\0') && !isspace((unsigned char)*p))
+        {
+            p++;
+        }
+    }
+
+    if (*p != '\0')
+    {
+        *p++ = '\0';
+    }
+
+    *text = p;
+    return token;
+}
+
+
+/***
+ * @brief Copy the string to newly allocated memory.
+ *
+ * @param text  String to copy
+ *
+ * @return Pointer to the copy or NULL if out of memory
+ */
+
+static char* copy_string(const char* text)
+{
+    size_t length = strlen(text) + 1U;
+    char* copy = (char*)malloc(length);
+
+    if (copy != NULL)
+    {
+        memcpy(copy, text, length);
+    }
+
+    return copy;
+}
+
+
+/***
+ * @brief Release the memory allocated for the target list.
+ */
+
+static void free_target_list(void)
+{
+    for (unsigned i = 0; i < number_of_targets; i++)
+    {
+        if (targets[i].ip_address != parameters.ip_address)
+        {
+            free((void*)targets[i].ip_address);
+        }
+
+        free((void*)targets[i].output_file);
+    }
+
+    number_of_targets = 0;
+}
+
+
+/***
+ * @brief Start a worker thread for each target. The connections to the GDB servers
+ *        are opened at the first transfer.
+ */
+
+static void start_target_threads(void)
+{
+    for (unsigned i = 0; i < number_of_targets; i++)
+    {
+        target_t* target = &targets[i];
+        target->started = false;
+        target->transfer_request = false;
+        target->exit_request = false;
+        target->result = RTE_ERROR;
+        target->status = "Not transferred yet";
+        target->size = 0;
+        target->transfer_time = 0;
+        target->transfers = 0;
+        target->errors = 0;
+
+        try
+        {
+            target->thread = std::thread(target_thread_function, target);
+            target->started = true;
+        }
+        catch (const std::system_error&)
+        {
+            target->status = "Could not start the thread";
+        }
+    }
+}
+
+
+/***
+ * @brief Close the connections and stop the worker threads.
+ */
+
+static void stop_target_threads(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(targets_mutex);
+
+        for (unsigned i = 0; i < number_of_targets; i++)
+        {
+            targets[i].exit_request = true;
+        }
+    }
+
+    targets_event.notify_all();
+
+    for (unsigned i = 0; i < number_of_targets; i++)
+    {
+        if (targets[i].thread.joinable())
+        {
+            targets[i].thread.join();
+        }
+    }
+}
+
+
+/***
+ * @brief Transfer the data from all targets simultaneously and display the results.
+ *
+ * @return RTE_OK    - data transferred from all targets
+ *         RTE_ERROR - transfer from at least one target failed
+ */
+
+static int transfer_from_all_targets(void)
+{
+    printf("\nReading from %u targets... ", number_of_targets);
+    LARGE_INTEGER start_time;
+    start_timer(&start_time);
+
+    std::unique_lock<std::mutex> lock(targets_mutex);
+
+    for (unsigned i = 0; i < number_of_targets; i++)
+    {
+        if (targets[i].started)
+        {
+            targets[i].transfer_request = true;
+            transfers_pending++;
+        }
+    }
+
+    lock.unlock();
+    targets_event.notify_all();
+
+    lock.lock();
+    targets_event.wait(lock, [] { return transfers_pending == 0; });
+    lock.unlock();
+
+    print_target_status(time_elapsed(&start_time));
+    int rez = RTE_OK;
+
+    for (unsigned i = 0; i < number_of_targets; i++)
+    {
+        if (targets[i].result != RTE_OK)
+        {
+            rez = RTE_ERROR;
+        }
+    }
+
+    return rez;
+}
+
+
+/***
+ * @brief Print the status line of each target and the aggregate transfer rate.
+ *
+ * @param round_time  Time needed to transfer the data from all targets [ms]
+ */
+
+static void print_target_status(double round_time)
+{
+    unsigned long long total_size = 0;
+    unsigned successful = 0;
+
+    printf("\n\n  # Target                 Address     Size [B]  Time [ms]  Rate [kB/s]  Transfers  Errors  Status");
+
+    for (unsigned i = 0; i < number_of_targets; i++)
+    {
+        const target_t* target = &targets[i];
+        char name[64];
+        sprintf_s(name, sizeof(name), "%s:%u", target->ip_address, target->gdb_port);
+        printf("\n%3u %-22s 0x%08X", i + 1U, name, target->start_address);
+
+        if (target->result == RTE_OK)
+        {
+            double rate = (target->transfer_time > 0) ? (target->size / target->transfer_time) : 0;
+            printf(" %9u %10.1f %12.0f", target->size, target->transfer_time, rate);
+            total_size += target->size;
+            successful++;
+        }
+        else
+        {
+            printf(" %9s %10s %12s", "-", "-", "-");
+        }
+
+        printf(" %10u %7u  %s", target->transfers, target->errors, target->status);
+    }
+
+    printf("\nTotal: %u of %u targets OK, %llu bytes in %.0f ms",
+        successful, number_of_targets, total_size, round_time);
+
+    if (round_time > 0)
+    {
+        printf(" (%.0f kB/s)", (double)total_size / round_time);
+    }
+
+    printf("\n");
+}
+
+
+/***
+ * @brief Execute the commands entered with the keyboard (-p argument). The keyboard
+ *        is checked every KEYBOARD_POLL_INTERVAL ms - the targets are not accessed
+ *        between the transfers.
+ *
+ * @return RTE_OK - program exit requested
+ */
+
+static int multi_target_commands(void)
+{
+    printf("\nPress 'Space' to transfer the data from all targets, '?' for help.\n");
+
+    for (;;)
+    {
+        if (!kbhit())
+        {
+            sleep_ms(KEYBOARD_POLL_INTERVAL);
+            continue;
+        }
+
+        int key = getch();
+
+        if ((key == 0xE0) || (key == 0))    // Function key?
+        {
+            (void)getch();
+            key = '\xFF';                   // Unknown command
+        }
+
+        switch (toupper(key))
+        {
+        case '?':
+            printf(
+                "\n\nAvailable commands:"
+                "\n   'Space' - Transfer the data from all targets."
+                "\n   'L' - Enable / disable logging to the log file."
+                "\n   '?' - View an overview of available commands."
+                "\n   'Esc' - Exit."
+                "\n----------------------------------------------------------------------"
+                "\n"
+            );
+            break;
+
+        case 'L':
+            disable_enable_logging_to_file();
+            break;
+
+        case ' ':
+            (void)transfer_from_all_targets();
+            break;
+
+        case '\x1B':
+            printf("\n\nPress the 'Y' button to exit the program.");
+
+            if (toupper(getch()) == 'Y')
+            {
+                return RTE_OK;
+            }
+            break;
+
+        default:
+            printf("\nUnknown command - Press the '?' key for a list of available commands.");
+            break;
+        }
+    }
+}
+
+
+/***
+ * @brief Transfer the data from one target when requested by the main thread.
+ *        The connection is opened at the first transfer and opened again at the
+ *        next transfer if a transfer fails (e.g. the GDB server has been restarted).
+ *
+ * @param target  Target definition and status
+ */
+
+static void target_thread_function(target_t* target)
+{
+    GdbSession session;
+    session.set_target(target->ip_address, target->start_address);
+    bool connected = false;
+    target_connection_t connection;
+    connection.session = &session;
+    connection.target = target;
+    connection.structure = NULL;
+    connection.capacity = 0;
+    connection.size = 0;
+    std::unique_lock<std::mutex> lock(targets_mutex);
+
+    for (;;)
+    {
+        targets_event.wait(lock, [target] { return target->transfer_request || target->exit_request; });
+
+        if (target->exit_request)
+        {
+            break;
+        }
+
+        lock.unlock();
+        LARGE_INTEGER start_time;
+        start_timer(&start_time);
+        int rez = RTE_ERROR;
+
+        if (!connected)
+        {
+            // connect_to_server() closes the socket itself if the connection fails
+            connected = (session.connect_to_server(target->gdb_port) == RTE_OK);
+            target->status = "Could not connect to the GDB server";
+        }
+
+        if (connected)
+        {
+            rez = transfer_target_data(&connection);
+
+            if (rez != RTE_OK)
+            {
+                session.cleanup();
+                connected = false;
+            }
+        }
+
+        lock.lock();
+        target->result = rez;
+
+        if (rez == RTE_OK)
+        {
+            target->transfer_time = time_elapsed(&start_time);
+            target->transfers++;
+        }
+        else
+        {
+            target->errors++;
+        }
+
+        target->transfer_request = false;
+        transfers_pending--;
+        targets_event.notify_all();
+    }
+
+    lock.unlock();
+
+    if (connected)
+    {
+        session.detach();
+        session.cleanup();
+    }
+
+    free(connection.structure);
+}
+
+
+/***
+ * @brief Transfer the g_rtedbg structure from the target to its output file. The data
+ *        logging is paused during the transfer and the circular buffer is cleared
+ *        afterwards if required - the same sequence as for a single target. The file is
+ *        written after the message filter has been restored.
+ *        The target status is set to the result description.
+ *
+ * @param connection  GDB server connection, target definition and host copy of the structure
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - data not transferred
+ */
+
+static int transfer_target_data(target_connection_t* connection)
+{
+    target_t* target = connection->target;
+    transfer_target_t transfer;
+    transfer.connection = connection;
+    transfer.start_address = target->start_address;
+    transfer.read_memory = read_session_memory;
+    transfer.write_memory = write_session_memory;
+    transfer.fill_memory = fill_session_memory;
+    transfer.read_structure = read_target_structure;
+
+    // The circular buffer must not be cleared if the data cannot be saved - check that the
+    // output file can be created (without changing it) before the target is accessed.
+    FILE* file;
+
+    if (fopen_s(&file, target->output_file, "ab") != 0)
+    {
+        log_string("\nCould not create file \"%s\"", target->output_file);
+        target->status = "Could not create the output file";
+        return RTE_ERROR;
+    }
+
+    (void)fclose(file);
+
+    rtedbg_header_t header;
+    uint32_t old_filter;
+    target->status = "Communication error";
+    transfer_result_t result = transfer_rtedbg_structure(&transfer, &header, &old_filter);
+
+    if (result == TRANSFER_LOGGING_ENABLED)
+    {
+        target->status = "Logging enabled by the firmware during the transfer";
+    }
+
+    if ((result != TRANSFER_OK) && (result != TRANSFER_BUFFER_NOT_RESET))
+    {
+        return RTE_ERROR;       // Status set by read_target_structure() or above
+    }
+
+    if (write_target_file(target->output_file, connection->structure, connection->size) != RTE_OK)
+    {
+        target->status = ((result == TRANSFER_OK) && parameters.clear_buffer)
+            ? "Could not write the output file - circular buffer already cleared, data lost"
+            : "Could not write the output file";
+        return RTE_ERROR;
+    }
+
+    if (result == TRANSFER_BUFFER_NOT_RESET)
+    {
+        target->status = "Circular buffer not cleared";
+        return RTE_ERROR;
+    }
+
+    target->size = connection->size;
+    target->status = "OK";
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Check the g_rtedbg header and read the structure to the host copy (called by
+ *        transfer_rtedbg_structure() while the data logging is paused).
+ *
+ * @param connection  Target connection (target_connection_t)
+ * @param header      g_rtedbg header
+ * @param old_filter  Message filter value before the data logging was paused
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - incorrect header, out of memory or data not received
+ */
+
+static int read_target_structure(void* connection, const rtedbg_header_t* header, uint32_t old_filter)
+{
+    target_connection_t* target_connection = (target_connection_t*)connection;
+    target_t* target = target_connection->target;
+    const rtedbg_header_t& rtedbg_header = *header;     // Name used by the rtedbg.h macros
+
+    if ((rtedbg_header.buffer_size > (MAX_BUFFER_SIZE / 4U))
+        || ((rtedbg_header.buffer_size * 4U + sizeof(rtedbg_header_t)) < MIN_BUFFER_SIZE)
+        || (sizeof(rtedbg_header_t) != RTE_HEADER_SIZE)
+        || (RTE_CFG_RESERVED_BITS != 0)
+        || (RTE_CFG_RESERVED2 != 0))
+    {
+        target->status = "Incorrect g_rtedbg header (address?)";
+        return RTE_ERROR;
+    }
+
+    unsigned size = rtedbg_header.buffer_size * 4U + sizeof(rtedbg_header_t);
+
+    if (size > target_connection->capacity)
+    {
+        free(target_connection->structure);
+        target_connection->structure = (unsigned*)malloc(size);
+        target_connection->capacity = (target_connection->structure != NULL) ? size : 0;
+
+        if (target_connection->structure == NULL)
+        {
+            target->status = "Out of memory";
+            return RTE_ERROR;
+        }
+    }
+
+    if (parameters.delay > 0)
+    {
+        sleep_ms(parameters.delay);
+            // Wait for low priority tasks to finish writing to the circular buffer
+    }
+
+    if (target_connection->session->read_memory((unsigned char*)target_connection->structure,
+        target->start_address, size) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    target_connection->structure[1] = old_filter;   // Filter value before the data logging was paused
+    target_connection->size = size;
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Memory access functions of the target GDB server session for transfer_rtedbg_structure().
+ */
+
+static int read_session_memory(void* connection, unsigned char* buffer, unsigned address, unsigned length)
+{
+    return ((target_connection_t*)connection)->session->read_memory(buffer, address, length);
+}
+
+
+static int write_session_memory(void* connection, const unsigned char* buffer, unsigned address, unsigned length)
+{
+    return ((target_connection_t*)connection)->session->write_memory(buffer, address, length);
+}
+
+
+static int fill_session_memory(void* connection, unsigned address, unsigned pattern, unsigned length)
+{
+    return ((target_connection_t*)connection)->session->fill_memory(address, pattern, length);
+}
+
+
+/***
+ * @brief Write the g_rtedbg structure to the target output file.
+ *
+ * @param file_name  Output file name
+ * @param data       g_rtedbg structure image
+ * @param size       Size of the structure [bytes]
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - file operation failed
+ */
+
+static int write_target_file(const char* file_name, const unsigned* data, unsigned size)
+{
+    FILE* file;
+
+    if (fopen_s(&file, file_name, "wb") != 0)
+    {
+        log_string("\nCould not create file \"%s\"", file_name);
+        return RTE_ERROR;
+    }
+
+    size_t written = fwrite(data, 1U, size, file);
+
+    if (fclose(file) != 0)
+    {
+        written = 0;
+    }
+
+    if (written != size)
+    {
+        log_string("\nCould not write to the file: %s.", file_name);
+        return RTE_ERROR;
+    }
+
+    return RTE_OK;
+}
+
+/*==== End of file ====*/
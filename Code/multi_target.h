@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    multi_target.h
+ * @author  B. Premzel
+ * @brief   Data transfer from several embedded systems (GDB servers) in one
+ *          process (-targets=file_name).
+ */
+
+#ifndef _MULTI_TARGET_H
+#define _MULTI_TARGET_H
+
+int multi_target_collection(void);
+
+#endif  // _MULTI_TARGET_H
+
+/*==== End of file ====*/
@@ -48,6 +48,16 @@ typedef enum
                             // Returns: ACK
     RTECOM_WRITE8,          // Write 8-bit data to the specified address
                             // Returns: ACK
+    RTECOM_FILL_RTEDBG,     // Fill 32-bit words of the g_rtedbg structure with a pattern
+                            // Address = index of the first 32-bit word, data = number of words
+                            // Returns ACK if the words are within g_rtedbg, NACK otherwise.
+                            // After the ACK the host sends the 32-bit pattern and the embedded
+                            // system returns ACK when the words have been filled.
+    RTECOM_WRITE_RTEDBG_BLOCK,  // Write a block of 32-bit words to the g_rtedbg structure
+                            // Address = index of the first 32-bit word, data = number of words
+                            // (max. RTECOM_MAX_WRITE_BLOCK_WORDS)
+                            // Returns ACK/NACK as RTECOM_FILL_RTEDBG. After the ACK the host
+                            // sends the data and the embedded system returns ACK when written.
     RTECOM_LAST_COMMAND
 } rte_com_command_t;
 
@@ -61,6 +71,9 @@ typedef enum
 // Host always sends 10 bytes: command (8b), checksum (8b), address (32b), data (32b)
 #define RTECOM_SEND_PACKET_LEN  10U
 
+// Maximum number of words written with one RTECOM_WRITE_RTEDBG_BLOCK command
+#define RTECOM_MAX_WRITE_BLOCK_WORDS  64U
+
 // Maximum length of data block received from embedded system
 #define MAX_COM_RECEIVE_MSG_SIZE  65520
 
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    session_record.cpp
+ * @brief   Binary recording of the data sent to and received from the GDB server with
+ *          the monotonic nanosecond timestamps (-record=file_name). The recording is much
+ *          faster than the -debug text logging, so it does not change the timing of the
+ *          data transfer noticeably.
+ * @author  B. Premzel
+ */
+
+#include "pch.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <mutex>
+#include "RTEgetData.h"
+#include "logger.h"
+#include "platform_compat.h"
+#include "session_record.h"
+
+#define RECORD_FILE_BUFFER_SIZE  (1024U * 1024U)    // Write buffer size - the file is written in large blocks
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static FILE* record_file = NULL;
+static std::mutex record_mutex;
+static std::chrono::steady_clock::time_point record_start_time;
+static unsigned last_connection = 0;                // Number of the last connection recorded
+
+
+/*---------------- Local functions ---------------*/
+static void write_record(unsigned connection, session_event_t event, const char* data, unsigned length);
+
+
+/***
+ * @brief Create the session recording file and write the file header.
+ *
+ * @param file_name  Recording file name
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - file could not be created or written
+ */
+
+int session_record_open(const char* file_name)
+{
+    errno_t err = fopen_s(&record_file, file_name, "wb");
+
+    if ((err != 0) || (record_file == NULL))
+    {
+        char error_text[256];
+        (void)strerror_s(error_text, sizeof(error_text), errno);
+        printf("\nCannot create the recording file \"%s\" - %s.\n", file_name, error_text);
+        record_file = NULL;
+        return RTE_ERROR;
+    }
+
+    (void)setvbuf(record_file, NULL, _IOFBF, RECORD_FILE_BUFFER_SIZE);
+
+    session_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SESSION_FILE_MAGIC, sizeof(header.magic));
+    header.version = SESSION_FILE_VERSION;
+    header.header_size = (uint32_t)sizeof(header);
+    header.start_time = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record_start_time = std::chrono::steady_clock::now();
+
+    if (fwrite(&header, sizeof(header), 1, record_file) != 1)
+    {
+        printf("\nCannot write to the recording file \"%s\".\n", file_name);
+        (void)fclose(record_file);
+        record_file = NULL;
+        return RTE_ERROR;
+    }
+
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Write the remaining buffered records to the file and close it.
+ */
+
+void session_record_close(void)
+{
+    std::lock_guard<std::mutex> lock(record_mutex);
+
+    if (record_file == NULL)
+    {
+        return;
+    }
+
+    if (fclose(record_file) != 0)
+    {
+        log_string("\nError writing the recording file.", NULL);
+    }
+
+    record_file = NULL;
+}
+
+
+/***
+ * @brief Record a new connection to the GDB server.
+ *
+ * @return Connection number to be used with session_record_event(),
+ *         0 - recording is not active
+ */
+
+unsigned session_record_connect(void)
+{
+    std::lock_guard<std::mutex> lock(record_mutex);
+
+    if (record_file == NULL)
+    {
+        return 0;
+    }
+
+    unsigned connection = ++last_connection;
+    write_record(connection, SESSION_CONNECTED, NULL, 0);
+    return connection;
+}
+
+
+/***
+ * @brief Record the data sent to or received from the GDB server or closing of the connection.
+ *
+ * @param connection  Connection number (returned by session_record_connect())
+ * @param event       Event type
+ * @param data        Data sent or received (NULL if there is no data)
+ * @param length      Number of data bytes
+ */
+
+void session_record_event(unsigned connection, session_event_t event, const char* data, unsigned length)
+{
+    if (connection == 0)
+    {
+        return;     // Recording not active for this connection
+    }
+
+    std::lock_guard<std::mutex> lock(record_mutex);
+
+    if (record_file != NULL)
+    {
+        write_record(connection, event, data, length);
+    }
+}
+
+
+/***
+ * @brief Write the record header and data to the recording file (buffered).
+ *        The recording is stopped in case of a file write error.
+ *        The record_mutex must be locked by the caller.
+ *
+ * @param connection  Connection number
+ * @param event       Event type
+ * @param data        Record data (NULL if there is no data)
+ * @param length      Number of data bytes
+ */
+
+static void write_record(unsigned connection, session_event_t event, const char* data, unsigned length)
+{
+    session_record_t record;
+    record.time = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - record_start_time).count();
+    record.length = (data == NULL) ? 0 : (uint32_t)length;
+    record.connection = (uint16_t)connection;
+    record.event = (uint8_t)event;
+    record.reserved = 0;
+
+    if ((fwrite(&record, sizeof(record), 1, record_file) != 1)
+        || ((record.length != 0) && (fwrite(data, record.length, 1, record_file) != 1)))
+    {
+        log_string("\nError writing the recording file - recording stopped.", NULL);
+        (void)fclose(record_file);
+        record_file = NULL;
+    }
+}
+
+/*==== End of file ====*/
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    session_record.h
+ * @author  B. Premzel
+ * @brief   Binary recording of the GDB server communication (-record=file_name).
+ *          The recording can be replayed with the Tools/rsp_replay server.
+ *
+ * File format (all values little endian):
+ *   - file header (session_file_header_t),
+ *   - event records: record header (session_record_t) followed by 'length' bytes of
+ *     data for the SESSION_SENT and SESSION_RECEIVED events.
+ *
+ * The data of every send() and recv() call is recorded as it was transferred over the
+ * socket, so a message can be split into several records or one record can contain
+ * several messages. Events of different connections (e.g. -connections=N) are
+ * interleaved in the order in which they happened.
+ */
+
+#ifndef _SESSION_RECORD_H
+#define _SESSION_RECORD_H
+
+#include <stdint.h>
+
+#define SESSION_FILE_MAGIC      "RTErecrd"      // File header identification (8 characters)
+#define SESSION_FILE_VERSION    1U
+
+typedef enum
+{
+    SESSION_SENT = 0,                           // Data sent to the GDB server
+    SESSION_RECEIVED = 1,                       // Data received from the GDB server
+    SESSION_CONNECTED = 2,                      // Connection established (no data)
+    SESSION_CLOSED = 3                          // Connection closed (no data)
+} session_event_t;
+
+typedef struct
+{
+    char magic[8];                  // SESSION_FILE_MAGIC
+    uint32_t version;               // SESSION_FILE_VERSION
+    uint32_t header_size;           // Size of this header
+    uint64_t start_time;            // Host time of the recording start [ms since 1.1.1970 UTC]
+} session_file_header_t;
+
+typedef struct
+{
+    uint64_t time;                  // Monotonic time since the recording start [ns]
+    uint32_t length;                // Number of data bytes following the record header
+    uint16_t connection;            // Connection number (1, 2, ... in the order of connecting)
+    uint8_t  event;                 // session_event_t
+    uint8_t  reserved;
+} session_record_t;
+
+int  session_record_open(const char* file_name);
+void session_record_close(void);
+unsigned session_record_connect(void);
+void session_record_event(unsigned connection, session_event_t event, const char* data, unsigned length);
+
+#endif  // _SESSION_RECORD_H
+
+/*==== End of file ====*/
@@ -0,0 +1,739 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    snapshot_file.cpp
+ * @brief   Container file with multiple snapshots of the g_rtedbg structure
+ *          (-container=file_name) and extraction of a single snapshot to a binary
+ *          data file that can be decoded as usual (-extract=N).
+ * @author  B. Premzel
+ */
+
+#include "pch.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <time.h>
+#include "RTEgetData.h"
+#include "logger.h"
+#include "platform_compat.h"
+#include "snapshot_file.h"
+#include "file_writer.h"
+#ifdef _WIN32
+    #include <io.h>
+    #define file_seek(file, offset)  _fseeki64(file, (long long)(offset), SEEK_SET)
+    #define file_seek_end(file)      _fseeki64(file, 0, SEEK_END)
+    #define file_tell(file)          (uint64_t)_ftelli64(file)
+#else
+    #include <unistd.h>
+    #define file_seek(file, offset)  fseeko(file, (off_t)(offset), SEEK_SET)
+    #define file_seek_end(file)      fseeko(file, 0, SEEK_END)
+    #define file_tell(file)          (uint64_t)ftello(file)
+#endif
+
+
+// Index of the snapshots in a container file
+typedef struct
+{
+    snapshot_index_entry_t* entries;            // Index table (allocated, unused entries are zero)
+    uint32_t count;                             // Number of snapshots
+    uint32_t allocated;                         // Number of entries allocated
+    uint64_t end_of_records;                    // Position after the last record or index block (trailer position)
+    uint64_t file_size;
+    uint64_t block_offset;                      // Position of the current index block
+    uint32_t block_capacity;                    // Number of entries in the current index block (0 - none)
+} snapshot_index_t;
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static FILE* container_file;                    // Container file open for appending (NULL - not open)
+static snapshot_index_t container_index;        // Index of the open container file
+
+
+/*---------------- Local functions ---------------*/
+static int  open_for_append(const char* file_name);
+static FILE* open_container(const char* file_name, const char* mode);
+static int  read_index(FILE* file, snapshot_index_t* index);
+static bool read_index_table(FILE* file, snapshot_index_t* index);
+static int  rebuild_index(FILE* file, snapshot_index_t* index);
+static int  reserve_entries(snapshot_index_t* index, uint32_t count);
+static int  add_index_entry(snapshot_index_t* index, uint64_t offset, uint64_t timestamp);
+static int  write_index_block(FILE* file, snapshot_index_t* index);
+static int  write_last_entry(FILE* file, snapshot_index_t* index);
+static bool truncate_file(FILE* file, uint64_t size);
+static void format_time(uint64_t timestamp, char* text, size_t size);
+
+
+/***
+ * @brief Append a snapshot of the g_rtedbg structure to the container file.
+ *        The file is created if it does not exist. It stays open with the index in
+ *        memory until snapshot_file_close() - only the new record, its index entry
+ *        and the trailer are written.
+ *
+ * @param file_name  Container file name
+ * @param data       g_rtedbg structure image (header with the filter value to be saved)
+ * @param size       Size of the structure [bytes]
+ * @param timestamp  Host time of the transfer [ms since 1.1.1970 UTC]
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - file could not be created, read or written
+ */
+
+int snapshot_file_append(const char* file_name, const uint32_t* data, unsigned size, uint64_t timestamp)
+{
+    snapshot_index_t* index = &container_index;
+    int rez = (container_file != NULL) ? RTE_OK : open_for_append(file_name);
+
+    // A new index block is written before the record if the current one is full
+    if ((rez == RTE_OK) && (index->count >= index->block_capacity))
+    {
+        rez = write_index_block(container_file, index);
+    }
+
+    snapshot_record_t record;
+    record.magic = SNAPSHOT_RECORD_MAGIC;
+    record.data_size = size;
+    record.timestamp = timestamp;
+    record.last_index = data[0];
+    record.filter = data[1];
+    record.rte_cfg = data[2];
+    record.buffer_size = data[5];
+
+    // The new record overwrites the trailer
+    uint64_t offset = index->end_of_records;
+
+    if ((rez == RTE_OK)
+        && ((file_seek(container_file, offset) != 0)
+            || (fwrite(&record, 1U, sizeof(record), container_file) != sizeof(record))
+            || (fwrite(data, 1U, size, container_file) != size)))
+    {
+        rez = RTE_ERROR;
+    }
+
+    if (rez == RTE_OK)
+    {
+        index->end_of_records = offset + sizeof(record) + size;
+        rez = add_index_entry(index, offset, record.timestamp);
+    }
+
+    if (rez == RTE_OK)
+    {
+        rez = write_last_entry(container_file, index);
+    }
+
+    if (rez != RTE_OK)
+    {
+        file_writer_message(true, "\nCould not write the snapshot to the container file \"%s\".", file_name);
+        snapshot_file_close();      // The index is loaded again at the next append
+    }
+    else
+    {
+        file_writer_message(true, "\nSnapshot %u added to the container file.", index->count);
+    }
+
+    return rez;
+}
+
+
+/***
+ * @brief Close the container file opened by snapshot_file_append() and release the index.
+ */
+
+void snapshot_file_close(void)
+{
+    if (container_file != NULL)
+    {
+        (void)fclose(container_file);
+        container_file = NULL;
+    }
+
+    free(container_index.entries);
+    memset(&container_index, 0, sizeof(container_index));
+}
+
+
+/***
+ * @brief Current host time in ms since 1.1.1970 (UTC) - the snapshot timestamp.
+ */
+
+uint64_t snapshot_file_time(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+
+/***
+ * @brief Write a snapshot from the container file to a binary data file.
+ *
+ * @param file_name    Container file name
+ * @param number       Snapshot number (1 = first)
+ * @param output_file  Name of the binary data file
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - snapshot not found or file error
+ */
+
+int snapshot_file_extract(const char* file_name, unsigned number, const char* output_file)
+{
+    snapshot_index_t index = { NULL, 0, 0, 0, 0, 0, 0 };
+    FILE* file = open_container(file_name, "rb");
+
+    if ((file == NULL) || (read_index(file, &index) != RTE_OK))
+    {
+        if (file != NULL)
+        {
+            (void)fclose(file);
+        }
+
+        return RTE_ERROR;
+    }
+
+    int rez = RTE_ERROR;
+    snapshot_record_t record;
+    unsigned char* data = NULL;
+
+    if ((number == 0) || (number > index.count))
+    {
+        log_data("\nThe container file contains %llu snapshot(s).", (long long)index.count);
+    }
+    else if ((file_seek(file, index.entries[number - 1U].offset) != 0)
+        || (fread(&record, 1U, sizeof(record), file) != sizeof(record))
+        || (record.magic != SNAPSHOT_RECORD_MAGIC)
+        || (record.data_size > MAX_BUFFER_SIZE))
+    {
+        log_data("\nSnapshot %llu in the container file is damaged.", (long long)number);
+    }
+    else
+    {
+        data = (unsigned char*)malloc(record.data_size);
+
+        if ((data == NULL) || (fread(data, 1U, record.data_size, file) != record.data_size))
+        {
+            log_data("\nCould not read snapshot %llu.", (long long)number);
+        }
+        else
+        {
+            FILE* out_file;
+
+            if (fopen_s(&out_file, output_file, "wb") != 0)
+            {
+                log_string("\nCould not create file \"%s\"", output_file);
+            }
+            else
+            {
+                if (fwrite(data, 1U, record.data_size, out_file) == record.data_size)
+                {
+                    char time_text[32];
+                    format_time(record.timestamp, time_text, sizeof(time_text));
+                    log_data("\nSnapshot %llu", (long long)number);
+                    log_string(" (%s)", time_text);
+                    log_string(" written to \"%s\".\n", output_file);
+                    rez = RTE_OK;
+                }
+                else
+                {
+                    log_string("\nCould not write to the file: %s.", output_file);
+                }
+
+                (void)fclose(out_file);
+            }
+        }
+    }
+
+    free(data);
+    free(index.entries);
+    (void)fclose(file);
+    return rez;
+}
+
+
+/***
+ * @brief Print the list of snapshots in the container file.
+ *
+ * @param file_name  Container file name
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - file could not be read
+ */
+
+int snapshot_file_list(const char* file_name)
+{
+    snapshot_index_t index = { NULL, 0, 0, 0, 0, 0, 0 };
+    FILE* file = open_container(file_name, "rb");
+
+    if ((file == NULL) || (read_index(file, &index) != RTE_OK))
+    {
+        if (file != NULL)
+        {
+            (void)fclose(file);
+        }
+
+        return RTE_ERROR;
+    }
+
+    printf("\nSnapshots in \"%s\":", file_name);
+    printf("\n    N  Time                      Index      Filter  Config word     Size");
+
+    for (uint32_t i = 0; i < index.count; i++)
+    {
+        snapshot_record_t record;
+
+        if ((file_seek(file, index.entries[i].offset) != 0)
+            || (fread(&record, 1U, sizeof(record), file) != sizeof(record)))
+        {
+            printf("\n%5u  - cannot read the record", i + 1U);
+            continue;
+        }
+
+        char time_text[32];
+        format_time(record.timestamp, time_text, sizeof(time_text));
+        printf("\n%5u  %-24s %6u  0x%08X   0x%08X %8u",
+            i + 1U, time_text, record.last_index, record.filter, record.rte_cfg, record.data_size);
+    }
+
+    printf("\n");
+    free(index.entries);
+    (void)fclose(file);
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Open the container file for appending and load its index (container_file and
+ *        container_index). The file is created if it does not exist.
+ *
+ * @param file_name  Container file name
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - file could not be created or read
+ */
+
+static int open_for_append(const char* file_name)
+{
+    snapshot_index_t index = { NULL, 0, 0, 0, 0, 0, 0 };
+    FILE* file = open_container(file_name, "r+b");
+    int rez;
+
+    if (file != NULL)
+    {
+        rez = read_index(file, &index);
+    }
+    else
+    {
+        // Create a new container file
+        file = open_container(file_name, "w+b");
+
+        if (file == NULL)
+        {
+            return RTE_ERROR;
+        }
+
+        snapshot_file_header_t header;
+        memcpy(header.magic, SNAPSHOT_FILE_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_FILE_VERSION;
+        header.header_size = sizeof(header);
+        index.end_of_records = sizeof(header);
+        index.file_size = sizeof(header);
+        rez = (fwrite(&header, 1U, sizeof(header), file) == sizeof(header)) ? RTE_OK : RTE_ERROR;
+    }
+
+    if (rez != RTE_OK)
+    {
+        free(index.entries);
+        (void)fclose(file);
+        return RTE_ERROR;
+    }
+
+    container_file = file;
+    container_index = index;
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Open the container file and check the file header if the file is not new.
+ *
+ * @param file_name  Container file name
+ * @param mode       File open mode
+ *
+ * @return File pointer or NULL if the file cannot be opened or is not a container file
+ */
+
+static FILE* open_container(const char* file_name, const char* mode)
+{
+    FILE* file;
+
+    if (fopen_s(&file, file_name, mode) != 0)
+    {
+        if ((errno != ENOENT) || (mode[0] != 'r') || (mode[1] != '+'))
+        {
+            file_writer_message(true, "\nCould not open the container file \"%s\".", file_name);
+        }
+
+        return NULL;
+    }
+
+    if (mode[0] == 'w')
+    {
+        return file;
+    }
+
+    snapshot_file_header_t header;
+
+    if ((fread(&header, 1U, sizeof(header), file) != sizeof(header))
+        || (memcmp(header.magic, SNAPSHOT_FILE_MAGIC, sizeof(header.magic)) != 0)
+        || (header.version != SNAPSHOT_FILE_VERSION)
+        || (header.header_size != sizeof(header)))
+    {
+        file_writer_message(true, "\n\"%s\" is not a snapshot container file.", file_name);
+        (void)fclose(file);
+        return NULL;
+    }
+
+    return file;
+}
+
+
+/***
+ * @brief Load the index table. It is rebuilt if the trailer or index table are not valid.
+ *
+ * @param file   Container file
+ * @param index  Index structure to fill in
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - file could not be read or out of memory
+ */
+
+static int read_index(FILE* file, snapshot_index_t* index)
+{
+    if (file_seek_end(file) != 0)
+    {
+        return RTE_ERROR;
+    }
+
+    index->file_size = file_tell(file);
+
+    if (read_index_table(file, index))
+    {
+        return RTE_OK;
+    }
+
+    file_writer_message(true, "\nContainer file index damaged - rebuilding it.");
+    return rebuild_index(file, index);
+}
+
+
+/***
+ * @brief Read the trailer at the end of the file and the index block it points to.
+ *
+ * @param file   Container file
+ * @param index  Index structure to fill in
+ *
+ * @return true  - index loaded
+ *         false - trailer or index block not valid
+ */
+
+static bool read_index_table(FILE* file, snapshot_index_t* index)
+{
+    snapshot_trailer_t trailer;
+    snapshot_index_block_t block;
+
+    if ((index->file_size < (sizeof(snapshot_file_header_t) + sizeof(trailer)))
+        || (file_seek(file, index->file_size - sizeof(trailer)) != 0)
+        || (fread(&trailer, 1U, sizeof(trailer), file) != sizeof(trailer))
+        || (trailer.magic != SNAPSHOT_INDEX_MAGIC)
+        || (trailer.index_offset < sizeof(snapshot_file_header_t))
+        || (file_seek(file, trailer.index_offset) != 0)
+        || (fread(&block, 1U, sizeof(block), file) != sizeof(block))
+        || (block.magic != SNAPSHOT_BLOCK_MAGIC)
+        || (trailer.entry_count > block.capacity)
+        || ((trailer.index_offset + sizeof(block) + (uint64_t)block.capacity * sizeof(snapshot_index_entry_t)
+            + sizeof(trailer)) > index->file_size))
+    {
+        return false;
+    }
+
+    index->count = 0;
+    index->end_of_records = index->file_size - sizeof(trailer);
+    index->block_offset = trailer.index_offset;
+    index->block_capacity = block.capacity;
+
+    if ((reserve_entries(index, block.capacity) != RTE_OK)
+        || (fread(index->entries, sizeof(snapshot_index_entry_t), trailer.entry_count, file)
+            != trailer.entry_count))
+    {
+        free(index->entries);
+        index->entries = NULL;
+        index->allocated = 0;
+        return false;
+    }
+
+    index->count = trailer.entry_count;
+    return true;
+}
+
+
+/***
+ * @brief Rebuild the index table by scanning the snapshot records and index blocks from
+ *        the start of the file. Data after the last complete record is ignored (overwritten
+ *        by the next record or removed). A new index block is written at the next append.
+ *
+ * @param file   Container file
+ * @param index  Index structure to fill in
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - out of memory
+ */
+
+static int rebuild_index(FILE* file, snapshot_index_t* index)
+{
+    uint64_t offset = sizeof(snapshot_file_header_t);
+    index->count = 0;
+    index->block_offset = 0;
+    index->block_capacity = 0;
+
+    for (;;)
+    {
+        snapshot_record_t record;
+
+        if ((file_seek(file, offset) != 0)
+            || (fread(&record, 1U, sizeof(record), file) != sizeof(record)))
+        {
+            break;
+        }
+
+        if (record.magic == SNAPSHOT_BLOCK_MAGIC)
+        {
+            // Skip the index block - it is rebuilt from the records
+            snapshot_index_block_t block;
+            memcpy(&block, &record, sizeof(block));
+            uint64_t block_size = sizeof(block) + (uint64_t)block.capacity * sizeof(snapshot_index_entry_t);
+
+            if ((offset + block_size) > index->file_size)
+            {
+                break;
+            }
+
+            offset += block_size;
+            continue;
+        }
+
+        if ((record.magic != SNAPSHOT_RECORD_MAGIC)
+            || (record.data_size > MAX_BUFFER_SIZE)
+            || ((offset + sizeof(record) + record.data_size) > index->file_size))
+        {
+            break;
+        }
+
+        if (add_index_entry(index, offset, record.timestamp) != RTE_OK)
+        {
+            return RTE_ERROR;
+        }
+
+        offset += sizeof(record) + record.data_size;
+    }
+
+    index->end_of_records = offset;
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Allocate the index entries. The entries added are set to zero.
+ *
+ * @param index  Index structure
+ * @param count  Number of entries needed
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - out of memory
+ */
+
+static int reserve_entries(snapshot_index_t* index, uint32_t count)
+{
+    if (count <= index->allocated)
+    {
+        return RTE_OK;
+    }
+
+    uint32_t allocated = (count > (2U * index->allocated)) ? count : (2U * index->allocated);
+    snapshot_index_entry_t* entries = (snapshot_index_entry_t*)realloc(
+        index->entries, allocated * sizeof(snapshot_index_entry_t));
+
+    if (entries == NULL)
+    {
+        file_writer_message(true, "\nCould not allocate memory buffer.");
+        return RTE_ERROR;
+    }
+
+    memset(&entries[index->allocated], 0, (allocated - index->allocated) * sizeof(snapshot_index_entry_t));
+    index->entries = entries;
+    index->allocated = allocated;
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Add an entry to the index table.
+ *
+ * @param index      Index structure
+ * @param offset     Position of the record in the file
+ * @param timestamp  Host time of the transfer
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - out of memory
+ */
+
+static int add_index_entry(snapshot_index_t* index, uint64_t offset, uint64_t timestamp)
+{
+    if (reserve_entries(index, index->count + 1U) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    index->entries[index->count].offset = offset;
+    index->entries[index->count].timestamp = timestamp;
+    index->count++;
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Write a new index block with all entries after the last record. Its capacity
+ *        is twice the capacity of the current block (SNAPSHOT_INDEX_CAPACITY for the first
+ *        one), so the index is copied only when the number of snapshots is doubled.
+ *
+ * @param file   Container file
+ * @param index  Index structure
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - data not written or out of memory
+ */
+
+static int write_index_block(FILE* file, snapshot_index_t* index)
+{
+    uint32_t capacity = (index->block_capacity == 0) ? SNAPSHOT_INDEX_CAPACITY : (2U * index->block_capacity);
+
+    while (capacity <= index->count)
+    {
+        capacity *= 2U;         // The rebuilt index may be larger
+    }
+
+    if (reserve_entries(index, capacity) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    snapshot_index_block_t block;
+    block.magic = SNAPSHOT_BLOCK_MAGIC;
+    block.capacity = capacity;
+
+    if ((file_seek(file, index->end_of_records) != 0)
+        || (fwrite(&block, 1U, sizeof(block), file) != sizeof(block))
+        || (fwrite(index->entries, sizeof(snapshot_index_entry_t), capacity, file) != capacity))
+    {
+        return RTE_ERROR;
+    }
+
+    index->block_offset = index->end_of_records;
+    index->block_capacity = capacity;
+    index->end_of_records += sizeof(block) + (uint64_t)capacity * sizeof(snapshot_index_entry_t);
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Write the last index entry to the current index block and the trailer after
+ *        the last record.
+ *
+ * @param file   Container file
+ * @param index  Index structure
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - data not written
+ */
+
+static int write_last_entry(FILE* file, snapshot_index_t* index)
+{
+    uint32_t last = index->count - 1U;
+    snapshot_trailer_t trailer;
+    trailer.index_offset = index->block_offset;
+    trailer.entry_count = index->count;
+    trailer.magic = SNAPSHOT_INDEX_MAGIC;
+
+    if ((file_seek(file, index->block_offset + sizeof(snapshot_index_block_t)
+            + (uint64_t)last * sizeof(snapshot_index_entry_t)) != 0)
+        || (fwrite(&index->entries[last], sizeof(snapshot_index_entry_t), 1U, file) != 1U)
+        || (file_seek(file, index->end_of_records) != 0)
+        || (fwrite(&trailer, 1U, sizeof(trailer), file) != sizeof(trailer))
+        || (fflush(file) != 0))
+    {
+        return RTE_ERROR;
+    }
+
+    // Remove the data after the trailer (only if the index has been rebuilt)
+    uint64_t end_of_file = file_tell(file);
+
+    if ((end_of_file < index->file_size) && !truncate_file(file, end_of_file))
+    {
+        return RTE_ERROR;
+    }
+
+    index->file_size = end_of_file;
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Set the file size.
+ *
+ * @param file  File pointer
+ * @param size  New file size
+ *
+ * @return true if successful
+ */
+
+static bool truncate_file(FILE* file, uint64_t size)
+{
+#ifdef _WIN32
+    return _chsize_s(_fileno(file), (long long)size) == 0;
+#else
+    return ftruncate(fileno(file), (off_t)size) == 0;
+#endif
+}
+
+
+/***
+ * @brief Format the time stamp as local date and time.
+ *
+ * @param timestamp  Time [ms since 1.1.1970 UTC]
+ * @param text       Buffer for the text
+ * @param size       Buffer size
+ */
+
+static void format_time(uint64_t timestamp, char* text, size_t size)
+{
+    time_t seconds = (time_t)(timestamp / 1000U);
+    struct tm local_time;
+#ifdef _WIN32
+    bool ok = localtime_s(&local_time, &seconds) == 0;
+#else
+    bool ok = localtime_r(&seconds, &local_time) != NULL;
+#endif
+
+    if (!ok || (strftime(text, size, "%Y-%m-%d %H:%M:%S", &local_time) == 0))
+    {
+        text[0] = '\0';
+        return;
+    }
+
+    size_t length = strlen(text);
+    sprintf_s(&text[length], size - length, ".%03u", (unsigned)(timestamp % 1000U));
+}
+
+/*==== End of file ====*/
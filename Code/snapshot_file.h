@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    snapshot_file.h
+ * @author  B. Premzel
+ * @brief   Container file with multiple snapshots of the g_rtedbg structure.
+ *
+ * File format (all values little endian):
+ *   - file header (snapshot_file_header_t),
+ *   - snapshot records: record header (snapshot_record_t) followed by the g_rtedbg
+ *     structure image (the same contents as the legacy binary data file) and index
+ *     blocks: block header (snapshot_index_block_t) followed by 'capacity' index
+ *     entries (snapshot_index_entry_t, unused entries are zero),
+ *   - trailer (snapshot_trailer_t) with the position of the current index block.
+ *
+ * The container file stays open and the index is kept in memory while snapshots are
+ * appended. A new snapshot is written over the trailer, its entry is written to the
+ * free space of the current index block and the trailer is written after the record.
+ * A new index block with twice the capacity is written after the last record when the
+ * current one is full (the old block is not used anymore). Records written before are
+ * not changed. If the index is damaged (e.g. the program was terminated while writing),
+ * it is rebuilt by scanning the records and index blocks.
+ */
+
+#ifndef _SNAPSHOT_FILE_H
+#define _SNAPSHOT_FILE_H
+
+#include <stdint.h>
+
+#define SNAPSHOT_FILE_MAGIC     "RTEsnaps"      // File header identification (8 characters)
+#define SNAPSHOT_FILE_VERSION   1U
+#define SNAPSHOT_RECORD_MAGIC   0x50414E53U     // "SNAP"
+#define SNAPSHOT_INDEX_MAGIC    0x58444E49U     // "INDX"
+#define SNAPSHOT_BLOCK_MAGIC    0x4B4C4249U     // "IBLK"
+#define SNAPSHOT_INDEX_CAPACITY 64U             // Number of entries in the first index block
+
+typedef struct
+{
+    char magic[8];                  // SNAPSHOT_FILE_MAGIC
+    uint32_t version;               // SNAPSHOT_FILE_VERSION
+    uint32_t header_size;           // Size of this header
+} snapshot_file_header_t;
+
+typedef struct
+{
+    uint32_t magic;                 // SNAPSHOT_RECORD_MAGIC
+    uint32_t data_size;             // Size of the g_rtedbg structure image [bytes]
+    uint64_t timestamp;             // Host time of the transfer [ms since 1.1.1970 UTC]
+    uint32_t last_index;            // Circular buffer index
+    uint32_t filter;                // Message filter value (as written to the binary file)
+    uint32_t rte_cfg;               // Configuration word
+    uint32_t buffer_size;           // Circular buffer size [words]
+} snapshot_record_t;
+
+typedef struct
+{
+    uint64_t offset;                // Position of the record header in the file
+    uint64_t timestamp;             // Host time of the transfer (copy from the record)
+} snapshot_index_entry_t;
+
+typedef struct
+{
+    uint32_t magic;                 // SNAPSHOT_BLOCK_MAGIC
+    uint32_t capacity;              // Number of index entries following the block header
+} snapshot_index_block_t;
+
+typedef struct
+{
+    uint64_t index_offset;          // Position of the current index block in the file
+    uint32_t entry_count;           // Number of snapshots
+    uint32_t magic;                 // SNAPSHOT_INDEX_MAGIC
+} snapshot_trailer_t;
+
+int snapshot_file_append(const char* file_name, const uint32_t* data, unsigned size, uint64_t timestamp);
+void snapshot_file_close(void);
+uint64_t snapshot_file_time(void);
+int snapshot_file_extract(const char* file_name, unsigned number, const char* output_file);
+int snapshot_file_list(const char* file_name);
+
+#endif  // _SNAPSHOT_FILE_H
+
+/*==== End of file ====*/
@@ -0,0 +1,528 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    stream.cpp
+ * @brief   Continuous transfer of the logged data while the embedded system is running
+ *          (-stream mode). The header is read periodically and the part of the circular
+ *          buffer written since the previous read is appended to the stream file.
+ * @author  B. Premzel
+ *
+ * The data logging is not stopped during streaming. The last words before the buffer
+ * index are transferred with the next read (a message may not be complete yet). Overruns
+ * (the embedded system has overwritten data before it was transferred) are detected with
+ * a second index read after each data transfer and with the data rate estimate. They are
+ * recorded in the stream file as gap records. The poll interval is adapted to the data
+ * rate so that about a quarter of the circular buffer is transferred at each read.
+ * Overruns cannot be detected if the index is read less often than once per buffer
+ * fill time (the transfer is slower than the data logging).
+ */
+
+#include "pch.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <cstring>
+#include <cerrno>
+#include "bridge.h"
+#include "cmd_line.h"
+#include "rtedbg.h"
+#include "RTEgetData.h"
+#include "logger.h"
+#include "platform_compat.h"
+#include "stream.h"
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+extern rtedbg_header_t rtedbg_header;           // Header of the g_rtedbg structure (RTEgetData.cpp)
+
+static FILE* stream_file;                       // File to which the data is appended
+static uint32_t* stream_buffer;                 // Buffer for the data read from the circular buffer
+static uint32_t buffer_size;                    // Circular buffer size [words]
+static uint32_t read_index;                     // Index of the first word not transferred yet
+static uint32_t holdback;                       // Number of words before the index left for the next read
+static clock_t last_poll_time;                  // Time of the last index read
+static double data_rate;                        // Estimated data rate [words/ms]
+static unsigned poll_interval;                  // Current poll interval [ms]
+static unsigned long long words_streamed;       // Number of words written to the stream file
+static unsigned long long words_lost;           // Estimated number of words lost due to overruns
+static unsigned overruns;                       // Number of gaps in the stream
+
+
+/*---------------- Local functions ---------------*/
+static int  stream_start(void);
+static void stream_stop(clock_t start_time);
+static int  stream_poll(bool final_read);
+static int  read_buffer_index(uint32_t* index);
+static int  read_circular_buffer(uint32_t start, uint32_t length);
+static int  write_record(uint32_t tag, uint32_t count, const uint32_t* data);
+static void record_gap(unsigned long long lost_words);
+static void update_poll_interval(uint32_t new_words, clock_t elapsed);
+static void display_stream_state(clock_t start_time);
+
+
+/***
+ * @brief Transfer the logged data continuously until a key is pressed.
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - streaming could not be started or was stopped because of errors
+ */
+
+int stream_data(void)
+{
+    if (stream_start() != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    printf("\nStreaming data to \"%s\" - press any key to stop.\n", parameters.bin_file_name);
+
+    clock_t start_time = clock_ms();
+    clock_t status_time = start_time;
+    unsigned errors = 0;
+    int rez = RTE_OK;
+
+    while (!kbhit())
+    {
+        clock_t elapsed = clock_ms() - last_poll_time;
+
+        if (elapsed < (clock_t)poll_interval)
+        {
+            sleep_ms((unsigned)(poll_interval - elapsed));
+        }
+
+        if (!parameters.debug_mode)
+        {
+            enable_logging(false);
+        }
+
+        rez = stream_poll(false);
+        enable_logging(true);
+
+        if (rez != RTE_OK)
+        {
+            port_display_errors("\nStreaming data read error: ");
+
+            if (++errors >= STREAM_MAX_ERRORS)
+            {
+                log_string("\nStreaming stopped after repeated errors.", NULL);
+                break;
+            }
+        }
+        else
+        {
+            errors = 0;
+        }
+
+        if ((clock_ms() - status_time) >= STREAM_STATUS_INTERVAL)
+        {
+            status_time = clock_ms();
+            display_stream_state(start_time);
+        }
+    }
+
+    if (rez == RTE_OK)
+    {
+        (void)getch();
+        rez = stream_poll(true);     // Transfer the remaining data
+    }
+
+    stream_stop(start_time);
+    return rez;
+}
+
+
+/***
+ * @brief Read the header, create the stream file and allocate the data buffer.
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - header not received, bad header, file or memory error
+ */
+
+static int stream_start(void)
+{
+    int rez = port_read_memory(
+        (unsigned char *)&rtedbg_header, parameters.start_address, sizeof(rtedbg_header));
+
+    if (rez != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    buffer_size = rtedbg_header.buffer_size;
+    unsigned size = buffer_size * 4U + sizeof(rtedbg_header_t);
+
+    if ((size < MIN_BUFFER_SIZE) || (size > MAX_BUFFER_SIZE)
+        || (sizeof(rtedbg_header_t) != RTE_HEADER_SIZE) || (rtedbg_header.last_index > buffer_size))
+    {
+        log_string("\nError in the g_rtedbg structure header - streaming not possible.", NULL);
+        return RTE_ERROR;
+    }
+
+    if (rtedbg_header.filter == 0)
+    {
+        log_string("\nThe message filter is zero - no data is logged at the moment.", NULL);
+    }
+
+    if (RTE_SINGLE_SHOT_WAS_ACTIVE && RTE_SINGLE_SHOT_LOGGING_ENABLED)
+    {
+        log_string("\nSingle shot logging is active - the logging stops when the buffer is full.", NULL);
+    }
+
+    stream_buffer = (uint32_t *)malloc(buffer_size * 4U);
+
+    if (stream_buffer == NULL)
+    {
+        log_string("\nCould not allocate memory buffer.", NULL);
+        return RTE_ERROR;
+    }
+
+    errno_t err = fopen_s(&stream_file, parameters.bin_file_name, "wb");
+
+    if ((err != 0) || (stream_file == NULL))
+    {
+        log_string("\nCould not create file \"%s\"", parameters.bin_file_name);
+        free(stream_buffer);
+        stream_buffer = NULL;
+        return RTE_ERROR;
+    }
+
+    if (fwrite(&rtedbg_header, 1U, sizeof(rtedbg_header), stream_file) != sizeof(rtedbg_header))
+    {
+        log_string("\nCould not write to the file: %s.", parameters.bin_file_name);
+        stream_stop(clock_ms());
+        return RTE_ERROR;
+    }
+
+    // The longest message may not be complete yet - it is transferred with the next read
+    holdback = RTE_MAX_MSG_BLOCKS * 5U;
+
+    if (holdback > (buffer_size / 4U))
+    {
+        holdback = buffer_size / 4U;
+    }
+
+    read_index = rtedbg_header.last_index % buffer_size;
+    last_poll_time = clock_ms();
+    poll_interval = STREAM_MIN_POLL_INTERVAL;
+    data_rate = 0;
+    words_streamed = 0;
+    words_lost = 0;
+    overruns = 0;
+
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Close the stream file, release the buffer and report the statistics.
+ *
+ * @param start_time  Time the streaming was started [ms]
+ */
+
+static void stream_stop(clock_t start_time)
+{
+    if (stream_file != NULL)
+    {
+        (void)fclose(stream_file);
+        stream_file = NULL;
+    }
+
+    free(stream_buffer);
+    stream_buffer = NULL;
+
+    clock_t duration = clock_ms() - start_time;
+    log_data("\nStreaming time: %llu ms", (long long)duration);
+    log_data(", data: %llu bytes", (long long)(words_streamed * 4U));
+
+    if (duration > 0)
+    {
+        log_data(", %llu B/s", (long long)(words_streamed * 4000U / (unsigned long long)duration));
+    }
+
+    log_data(", overruns: %llu", (long long)overruns);
+    log_data(", lost words (estimate): %llu\n", (long long)words_lost);
+}
+
+
+/***
+ * @brief Read the buffer index and transfer the new data to the stream file.
+ *
+ * @param final_read  true - transfer all data up to the index (streaming finished)
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - data not received or not written to the file
+ */
+
+static int stream_poll(bool final_read)
+{
+    uint32_t index;
+
+    if (read_buffer_index(&index) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    clock_t now = clock_ms();
+    clock_t elapsed = now - last_poll_time;
+    last_poll_time = now;
+
+    uint32_t new_words = (index + buffer_size - read_index) % buffer_size;
+    unsigned long long lost_words = 0;
+
+    // Has the embedded system written more than the complete buffer since the last read?
+    // The index shows only the number of words written modulo the buffer size.
+    double expected_words = data_rate * (double)elapsed;
+    unsigned long long laps =
+        (unsigned long long)((expected_words - (double)new_words) / (double)buffer_size + 0.5);
+
+    if ((expected_words > (double)new_words) && (laps > 0))
+    {
+        // Transfer the newest part of the buffer only - the oldest data is being overwritten
+        uint32_t words = buffer_size - holdback - buffer_size / 8U;
+        lost_words = new_words + laps * buffer_size - words;
+        read_index = (index + buffer_size - words) % buffer_size;
+        new_words = words;
+    }
+
+    update_poll_interval(new_words, elapsed);
+
+    uint32_t length = final_read ? new_words : 0;
+
+    if (new_words > holdback)
+    {
+        length = new_words - (final_read ? 0 : holdback);
+    }
+
+    if (length == 0)
+    {
+        return RTE_OK;
+    }
+
+    if (read_circular_buffer(read_index, length) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    // Check if the embedded system has overwritten the start of the data during the transfer
+    uint32_t index_after;
+
+    if (read_buffer_index(&index_after) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    uint32_t advance = (index_after + buffer_size - index) % buffer_size;
+    uint32_t free_words = buffer_size - new_words;     // Words the embedded system may write safely
+    uint32_t overwritten = 0;
+
+    if ((data_rate * (double)(clock_ms() - now)) > (double)(advance + buffer_size / 2U))
+    {
+        overwritten = length;   // The index has probably wrapped around during the transfer
+    }
+    else if (advance > free_words)
+    {
+        overwritten = advance - free_words + holdback;  // Also the message that was being written
+
+        if (overwritten > length)
+        {
+            overwritten = length;
+        }
+    }
+
+    if ((lost_words > 0) || (overwritten > 0))
+    {
+        record_gap(lost_words + overwritten);
+    }
+
+    read_index = (read_index + length) % buffer_size;
+
+    if ((overwritten < length)
+        && (write_record(STREAM_DATA_TAG, length - overwritten, &stream_buffer[overwritten]) != RTE_OK))
+    {
+        return RTE_ERROR;
+    }
+
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Read the circular buffer index (last_index) from the embedded system.
+ *
+ * @param index  Pointer to the variable for the index
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - data not received or index not valid
+ */
+
+static int read_buffer_index(uint32_t* index)
+{
+    if (port_read_memory((unsigned char *)index, parameters.start_address, 4U) != RTE_OK)
+    {
+        return RTE_ERROR;
+    }
+
+    if (*index > buffer_size)
+    {
+        last_error = ERR_BAD_RESPONSE;
+        log_data("\nBad circular buffer index: %llu", (long long)*index);
+        return RTE_ERROR;
+    }
+
+    *index %= buffer_size;
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Read a part of the circular buffer to the stream buffer.
+ *        The data is read in two parts if the buffer wraps around.
+ *
+ * @param start   Index of the first word
+ * @param length  Number of words to read
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - data not received
+ */
+
+static int read_circular_buffer(uint32_t start, uint32_t length)
+{
+    uint32_t words_read = 0;
+
+    while (words_read < length)
+    {
+        uint32_t words = length - words_read;
+
+        if ((start + words) > buffer_size)
+        {
+            words = buffer_size - start;    // Read up to the end of the buffer first
+        }
+
+        int rez = port_read_memory(
+            (unsigned char *)&stream_buffer[words_read],
+            parameters.start_address + sizeof(rtedbg_header_t) + start * 4U,
+            words * 4U);
+
+        if (rez != RTE_OK)
+        {
+            return RTE_ERROR;
+        }
+
+        words_read += words;
+        start = 0;
+    }
+
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Append a record to the stream file.
+ *
+ * @param tag    Record type (STREAM_DATA_TAG, STREAM_GAP_TAG)
+ * @param count  Number of data words or number of lost words
+ * @param data   Data words (NULL for records without data)
+ *
+ * @return RTE_OK    - no error
+ *         RTE_ERROR - data not written
+ */
+
+static int write_record(uint32_t tag, uint32_t count, const uint32_t* data)
+{
+    uint32_t record_header[2] = { tag, count };
+    bool ok = fwrite(record_header, 1U, sizeof(record_header), stream_file) == sizeof(record_header);
+
+    if (ok && (data != NULL))
+    {
+        ok = fwrite(data, 4U, count, stream_file) == count;
+        words_streamed += count;
+    }
+
+    if (!ok || (fflush(stream_file) != 0))
+    {
+        log_string("\nCould not write to the file: %s.", parameters.bin_file_name);
+        return RTE_ERROR;
+    }
+
+    return RTE_OK;
+}
+
+
+/***
+ * @brief Record an overrun (gap) in the stream file.
+ *
+ * @param lost_words  Estimated number of words lost
+ */
+
+static void record_gap(unsigned long long lost_words)
+{
+    overruns++;
+    words_lost += lost_words;
+    uint32_t count = (lost_words > UINT32_MAX) ? UINT32_MAX : (uint32_t)lost_words;
+    (void)write_record(STREAM_GAP_TAG, count, NULL);
+}
+
+
+/***
+ * @brief Update the data rate estimate and the poll interval. The interval is chosen so
+ *        that about a quarter of the circular buffer is filled between two reads.
+ *
+ * @param new_words  Number of words written since the last read
+ * @param elapsed    Time since the last read [ms]
+ */
+
+static void update_poll_interval(uint32_t new_words, clock_t elapsed)
+{
+    if (elapsed <= 0)
+    {
+        return;
+    }
+
+    data_rate = 0.7 * data_rate + 0.3 * (double)new_words / (double)elapsed;
+    double interval = (double)STREAM_MAX_POLL_INTERVAL;
+
+    if (data_rate > 0)
+    {
+        interval = (double)(buffer_size / 4U) / data_rate;
+    }
+
+    if (interval < STREAM_MIN_POLL_INTERVAL)
+    {
+        interval = STREAM_MIN_POLL_INTERVAL;
+    }
+
+    if (interval > STREAM_MAX_POLL_INTERVAL)
+    {
+        interval = STREAM_MAX_POLL_INTERVAL;
+    }
+
+    // Increase the interval gradually - the index shows the number of words written only
+    // modulo the buffer size, so the data rate is underestimated if the interval is too long
+    if (interval > (double)(2U * poll_interval))
+    {
+        interval = (double)(2U * poll_interval);
+    }
+
+    poll_interval = (unsigned)interval;
+}
+
+
+/***
+ * @brief Display the amount of data transferred, throughput and number of overruns.
+ *
+ * @param start_time  Time the streaming was started [ms]
+ */
+
+static void display_stream_state(clock_t start_time)
+{
+    clock_t duration = clock_ms() - start_time;
+    unsigned long long rate = (duration > 0) ? (words_streamed * 4U / (unsigned long long)duration) : 0;
+
+    printf("\rStreamed: %llu kB, %llu kB/s, poll interval: %u ms, overruns: %u, lost words: %llu     ",
+        words_streamed * 4U / 1024U, rate, poll_interval, overruns, words_lost);
+}
+
+/*==== End of file ====*/
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    stream.h
+ * @author  B. Premzel
+ * @brief   Continuous transfer of the logged data while the embedded system is running.
+ *
+ * Stream file format (all values are little endian 32-bit words):
+ *   - g_rtedbg structure header (6 words) read at the start of streaming,
+ *   - records: STREAM_DATA_TAG, number of words N, N data words from the circular buffer
+ *              STREAM_GAP_TAG, estimated number of lost words (overrun - data overwritten
+ *              by the embedded system before it could be transferred)
+ */
+
+#ifndef _STREAM_H
+#define _STREAM_H
+
+#define STREAM_DATA_TAG     0x41544144U     // "DATA"
+#define STREAM_GAP_TAG      0x20504147U     // "GAP "
+
+int stream_data(void);
+
+#endif  // _STREAM_H
+
+/*==== End of file ====*/
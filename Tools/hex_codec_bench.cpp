@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    hex_codec_bench.cpp
+ * @brief   Microbenchmark for the hex codec implementations (scalar, SSE2, AVX2, NEON).
+ * @author  B. Premzel
+ *
+ * Usage: hex_codec_bench [block_size] [repeat_count]
+ *
+ * Every implementation supported by the CPU is first checked against the scalar one.
+ * Encode and decode speeds are then printed in bytes (binary data) per CPU cycle and MB/s.
+ * The time stamp counter is used on x86 CPUs. Nanoseconds are shown instead of
+ * cycles on other CPUs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "hex_codec.h"
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+    #define HAVE_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define HAVE_RDTSC
+#endif
+
+#define DEFAULT_BLOCK_SIZE   8188U      // Typical memory read packet size
+#define DEFAULT_REPEAT_COUNT 20000U
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static volatile unsigned sink;          // Prevents the compiler from removing the benchmarked code
+
+
+/***
+ * @brief Current value of the CPU cycle counter (or time in ns).
+ */
+
+static unsigned long long cycle_count(void)
+{
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+/***
+ * @brief Check that the implementation gives the same results as the scalar one
+ *        for a block of 'length' bytes.
+ *
+ * @return true if the results are the same
+ */
+
+static bool verify_length(const hex_codec_t* codec, const hex_codec_t* reference,
+    const unsigned char* data, unsigned length, char* hex, char* hex_reference, unsigned char* decoded)
+{
+    unsigned char sum = codec->encode(data, length, hex);
+    unsigned char sum_reference = reference->encode(data, length, hex_reference);
+
+    if ((sum != sum_reference) || (memcmp(hex, hex_reference, 2U * length) != 0))
+    {
+        printf("\n%s: encode error (length %u)", codec->name, length);
+        return false;
+    }
+
+    // Lower case must also be accepted
+    for (unsigned i = 0; i < (2U * length); i += 3U)
+    {
+        if ((hex[i] >= 'A') && (hex[i] <= 'F'))
+        {
+            hex[i] = (char)(hex[i] + ('a' - 'A'));
+        }
+    }
+
+    unsigned char decode_sum;
+    unsigned char decode_sum_reference;
+    (void)reference->decode(hex, length, decoded, &decode_sum_reference);
+    bool valid = codec->decode(hex, length, decoded, &decode_sum);
+
+    if (!valid || (decode_sum != decode_sum_reference) || (memcmp(decoded, data, length) != 0))
+    {
+        printf("\n%s: decode error (length %u)", codec->name, length);
+        return false;
+    }
+
+    // An invalid character must be detected at any position - the first and last
+    // 256 positions (all vector lanes and the scalar part) are checked in long blocks
+    static const char bad_chars[] = { 'g', 'G', '/', ':', '@', '`', ' ', (char)0xC1 };
+
+    for (unsigned position = 0; position < (2U * length); position++)
+    {
+        if ((position == 256U) && ((2U * length) > 512U))
+        {
+            position = 2U * length - 256U;
+        }
+
+        char saved = hex[position];
+        hex[position] = bad_chars[position % sizeof(bad_chars)];
+        valid = codec->decode(hex, length, decoded, &decode_sum);
+        hex[position] = saved;
+
+        if (valid)
+        {
+            printf("\n%s: invalid character not detected (length %u, position %u)",
+                codec->name, length, position);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Check that the implementation gives the same results as the scalar one.
+ *
+ * @return true if the results are the same
+ */
+
+static bool verify(const hex_codec_t* codec, const hex_codec_t* reference,
+    const unsigned char* data, unsigned size)
+{
+    char* hex = (char*)malloc(2U * size);
+    char* hex_reference = (char*)malloc(2U * size);
+    unsigned char* decoded = (unsigned char*)malloc(size);
+    bool ok = (hex != NULL) && (hex_reference != NULL) && (decoded != NULL);
+
+    // All short blocks (vector and scalar parts) and the full block
+    for (unsigned length = 0; ok && (length <= size) && (length <= 100U); length++)
+    {
+        ok = verify_length(codec, reference, data, length, hex, hex_reference, decoded);
+    }
+
+    if (ok)
+    {
+        ok = verify_length(codec, reference, data, size, hex, hex_reference, decoded);
+    }
+
+    free(hex);
+    free(hex_reference);
+    free(decoded);
+    return ok;
+}
+
+
+/***
+ * @brief Measure the encode and decode speed of an implementation.
+ */
+
+static void benchmark(const hex_codec_t* codec, const unsigned char* data, unsigned size, unsigned repeat_count)
+{
+    char* hex = (char*)malloc(2U * size);
+    unsigned char* decoded = (unsigned char*)malloc(size);
+
+    if ((hex == NULL) || (decoded == NULL))
+    {
+        printf("\nMemory allocation failed\n");
+        exit(1);
+    }
+
+    unsigned sum = 0;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    unsigned long long start = cycle_count();
+
+    for (unsigned i = 0; i < repeat_count; i++)
+    {
+        sum += codec->encode(data, size, hex);
+    }
+
+    unsigned long long encode_cycles = cycle_count() - start;
+    double encode_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    start_time = std::chrono::steady_clock::now();
+    start = cycle_count();
+
+    for (unsigned i = 0; i < repeat_count; i++)
+    {
+        unsigned char checksum;
+        sum += codec->decode(hex, size, decoded, &checksum) ? checksum : 0U;
+    }
+
+    unsigned long long decode_cycles = cycle_count() - start;
+    double decode_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    sink = sum;
+
+    double bytes = (double)size * repeat_count;
+    printf("\n%-8s %10.3f %10.0f %10.3f %10.0f", codec->name,
+        bytes / (double)encode_cycles, bytes / encode_time / 1e6,
+        bytes / (double)decode_cycles, bytes / decode_time / 1e6);
+
+    free(hex);
+    free(decoded);
+}
+
+
+int main(int argc, char* argv[])
+{
+    unsigned size = DEFAULT_BLOCK_SIZE;
+    unsigned repeat_count = DEFAULT_REPEAT_COUNT;
+
+    if (argc > 1)
+    {
+        size = (unsigned)strtoul(argv[1], NULL, 0);
+    }
+
+    if (argc > 2)
+    {
+        repeat_count = (unsigned)strtoul(argv[2], NULL, 0);
+    }
+
+    if ((size == 0) || (repeat_count == 0))
+    {
+        printf("Usage: hex_codec_bench [block_size] [repeat_count]\n");
+        return 1;
+    }
+
+    unsigned char* data = (unsigned char*)malloc(size);
+
+    if (data == NULL)
+    {
+        printf("Memory allocation failed\n");
+        return 1;
+    }
+
+    unsigned seed = 12345U;
+
+    for (unsigned i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245U + 12345U;
+        data[i] = (unsigned char)(seed >> 16);
+    }
+
+    hex_codec_init();
+    const hex_codec_t* reference = hex_codec_get(0);
+    bool all_ok = true;
+
+    printf("Block size: %u bytes, repeat count: %u, used by RTEgetData: %s\n",
+        size, repeat_count, hex_codec_name());
+#ifdef HAVE_RDTSC
+    printf("\n         --------- encode --------  --------- decode --------");
+    printf("\nCodec    bytes/cycle       MB/s bytes/cycle       MB/s");
+#else
+    printf("\n         ---------- encode --------  ---------- decode --------");
+    printf("\nCodec      bytes/ns       MB/s   bytes/ns       MB/s");
+#endif
+
+    for (unsigned i = 0; hex_codec_get(i) != NULL; i++)
+    {
+        const hex_codec_t* codec = hex_codec_get(i);
+
+        if (!verify(codec, reference, data, size))
+        {
+            all_ok = false;
+            continue;
+        }
+
+        benchmark(codec, data, size, repeat_count);
+    }
+
+    printf("\n");
+    free(data);
+
+    return all_ok ? 0 : 1;
+}
+
+/*==== End of file ====*/
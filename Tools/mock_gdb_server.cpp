@@ -0,0 +1,783 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    mock_gdb_server.cpp
+ * @brief   GDB RSP server that simulates an embedded system with the g_rtedbg data logging
+ *          structure. Used to measure and test the RTEgetData data transfer without a debug probe.
+ * @author  B. Premzel
+ *
+ * Usage: mock_gdb_server [options]
+ *   -port=N          TCP port (default 2331), 0 - any free port (printed at the start)
+ *   -profile=name    GDB server profile: ideal, jlink, stlink, openocd (default ideal)
+ *   -packet=0xN      Max. packet size reported in the qSupported reply
+ *   -latency=N       Time from a request to the reply [us]
+ *   -bandwidth=N     Data rate of replies [kB/s], 0 = unlimited
+ *   -binary=0|1      Support for the binary memory read and write ('x' and 'X' packets)
+ *   -fill=0|1        Support for the OpenOCD "mww" monitor command
+ *   -rle             Run-length encode the memory read replies
+ *   -verbose         Print the received packets
+ * The simulated target options (-address, -size, -rate, ...) are described in sim_target.h.
+ *
+ * The profile sets the packet size, latency, bandwidth and supported packets. The values
+ * are rough approximations of the J-Link, ST-LINK and OpenOCD GDB servers with typical
+ * debug probes. Options given after -profile override the profile values.
+ * Requests are answered in the order received. The latency of pipelined requests overlaps,
+ * but the replies share the bandwidth - as with a real debug probe.
+ *
+ * Example: mock_gdb_server -port=2331 -profile=stlink
+ *          RTEgetData 2331 0x20000000 0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "sim_target.h"
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #define SEND_FLAGS 0
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    typedef int SOCKET;
+    #define INVALID_SOCKET  (-1)
+    #define closesocket(s)  close(s)
+    #define SEND_FLAGS      MSG_NOSIGNAL
+#endif
+
+#define DEFAULT_PORT          2331U
+#define MIN_PACKET_SIZE       64U
+#define MAX_PACKET_SIZE       0x10000U
+#define RECV_BUFFER_SIZE      0x10000U
+#define MAX_RLE_REPEAT        97            // Max. repeat count ('~' - 29)
+#define MAX_VERBOSE_LENGTH    60            // Max. number of packet characters printed
+
+
+typedef struct
+{
+    const char* name;
+    unsigned packet_size;       // Max. packet size reported to the client
+    unsigned latency_us;        // Time from the request to the start of the reply [us]
+    unsigned bandwidth;         // Reply data rate [kB/s], 0 = unlimited
+    bool binary;                // 'x' and 'X' packets supported
+    bool fill;                  // "mww" monitor command supported
+} server_profile_t;
+
+typedef std::chrono::steady_clock::time_point time_point_t;
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static const server_profile_t profiles[] =
+{
+    // name       packet  latency bandwidth binary fill
+    { "ideal",   0x4000U,     0U,      0U, true,  true  },
+    { "jlink",   0x4000U,   400U,   1500U, false, false },
+    { "stlink",  0x0C00U,  1000U,    500U, false, false },
+    { "openocd", 0x3FFFU,  1200U,    350U, true,  true  },
+};
+
+static server_profile_t profile;
+static unsigned server_port = DEFAULT_PORT;
+static bool rle_replies;
+static bool verbose;
+static std::mutex print_mutex;
+
+
+/*---------------- Local functions ---------------*/
+static bool process_arguments(int argc, char* argv[]);
+static void client_thread(SOCKET client, unsigned client_number);
+static std::string process_packet(const std::string& packet, bool* no_ack, bool* detach);
+static std::string read_memory(char type, const std::string& packet);
+static std::string write_memory(char type, const std::string& packet);
+static std::string monitor_command(const std::string& packet);
+static bool parse_address_length(const char* text, unsigned* address, unsigned* length);
+static std::string run_length_encode(const std::string& data);
+static std::string hex_encode(const std::string& text);
+static std::string make_packet(const std::string& data);
+static bool send_all(SOCKET s, const char* data, size_t length);
+
+
+int main(int argc, char* argv[])
+{
+    profile = profiles[0];
+
+    if (!process_arguments(argc, argv))
+    {
+        printf("\nUsage: mock_gdb_server [-port=N] [-profile=ideal|jlink|stlink|openocd] [-packet=0xN]"
+            "\n       [-latency=us] [-bandwidth=kB/s] [-binary=0|1] [-fill=0|1] [-rle] [-verbose]"
+            "\n       [simulated target options]"
+            "\nSimulated target options:" SIM_TARGET_USAGE "\n");
+        return 1;
+    }
+
+    if (!sim_target_start())
+    {
+        return 1;
+    }
+
+#ifdef _WIN32
+    WSADATA wsa_data;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+    {
+        printf("\nWSAStartup failed.\n");
+        return 1;
+    }
+#endif
+
+    SOCKET server = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+    if (server == INVALID_SOCKET)
+    {
+        printf("\nCannot create the server socket.\n");
+        return 1;
+    }
+
+    int reuse = 1;
+    (void)setsockopt(server, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    struct sockaddr_in server_address;
+    memset(&server_address, 0, sizeof(server_address));
+    server_address.sin_family = AF_INET;
+    server_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server_address.sin_port = htons((unsigned short)server_port);
+
+    if ((bind(server, (struct sockaddr*)&server_address, sizeof(server_address)) != 0)
+        || (listen(server, 8) != 0))
+    {
+        printf("\nCannot listen on port %u.\n", server_port);
+        (void)closesocket(server);
+        return 1;
+    }
+
+    socklen_t address_length = sizeof(server_address);
+
+    if (getsockname(server, (struct sockaddr*)&server_address, &address_length) == 0)
+    {
+        server_port = ntohs(server_address.sin_port);   // Port assigned by the system for -port=0
+    }
+
+    printf("Mock GDB server (profile '%s') listening on port %u", profile.name, server_port);
+    sim_target_print_config();
+    printf("\nPacket size 0x%X, latency %u us, bandwidth ", profile.packet_size, profile.latency_us);
+
+    if (profile.bandwidth == 0)
+    {
+        printf("unlimited");
+    }
+    else
+    {
+        printf("%u kB/s", profile.bandwidth);
+    }
+
+    printf(", binary %s, fill %s%s\n", profile.binary ? "yes" : "no", profile.fill ? "yes" : "no",
+        rle_replies ? ", RLE" : "");
+    fflush(stdout);
+
+    for (unsigned client_number = 1; ; client_number++)
+    {
+        SOCKET client = accept(server, NULL, NULL);
+
+        if (client == INVALID_SOCKET)
+        {
+            continue;
+        }
+
+        int no_delay = 1;
+        (void)setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char*)&no_delay, sizeof(no_delay));
+
+        try
+        {
+            std::thread(client_thread, client, client_number).detach();
+        }
+        catch (const std::system_error&)
+        {
+            printf("\nCannot start the client thread.\n");
+            (void)closesocket(client);
+        }
+    }
+}
+
+
+/***
+ * @brief Process the command line arguments.
+ *
+ * @return true if all arguments are valid
+ */
+
+static bool process_arguments(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = strchr(arg, '=');
+        value = (value != NULL) ? value + 1 : "";
+        unsigned number = (unsigned)strtoul(value, NULL, 0);
+
+        if (strncmp(arg, "-profile=", 9) == 0)
+        {
+            bool found = false;
+
+            for (size_t p = 0; p < (sizeof(profiles) / sizeof(profiles[0])); p++)
+            {
+                if (strcmp(value, profiles[p].name) == 0)
+                {
+                    profile = profiles[p];
+                    found = true;
+                }
+            }
+
+            if (!found)
+            {
+                printf("\nUnknown profile '%s'.", value);
+                return false;
+            }
+        }
+        else if (strncmp(arg, "-port=", 6) == 0)
+        {
+            server_port = number;
+        }
+        else if (strncmp(arg, "-packet=", 8) == 0)
+        {
+            profile.packet_size = number;
+        }
+        else if (strncmp(arg, "-latency=", 9) == 0)
+        {
+            profile.latency_us = number;
+        }
+        else if (strncmp(arg, "-bandwidth=", 11) == 0)
+        {
+            profile.bandwidth = number;
+        }
+        else if (strncmp(arg, "-binary=", 8) == 0)
+        {
+            profile.binary = (number != 0);
+        }
+        else if (strncmp(arg, "-fill=", 6) == 0)
+        {
+            profile.fill = (number != 0);
+        }
+        else if (strcmp(arg, "-rle") == 0)
+        {
+            rle_replies = true;
+        }
+        else if (strcmp(arg, "-verbose") == 0)
+        {
+            verbose = true;
+        }
+        else if (!sim_target_argument(arg))
+        {
+            printf("\nUnknown argument '%s'.", arg);
+            return false;
+        }
+    }
+
+    if (server_port > 65535U)
+    {
+        printf("\nIncorrect port number.");
+        return false;
+    }
+
+    if ((profile.packet_size < MIN_PACKET_SIZE) || (profile.packet_size > MAX_PACKET_SIZE))
+    {
+        printf("\nThe packet size must be between 0x%X and 0x%X.", MIN_PACKET_SIZE, MAX_PACKET_SIZE);
+        return false;
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Serve one client connection - receive the packets, acknowledge them (until the
+ *        no-acknowledgment mode is enabled) and send the replies.
+ *        The reply is sent after the latency time, and the replies share the bandwidth.
+ */
+
+static void client_thread(SOCKET client, unsigned client_number)
+{
+    std::vector<char> recv_buffer(RECV_BUFFER_SIZE);
+    std::string received;
+    bool no_ack = false;
+    bool detach = false;
+    unsigned long long packets = 0;
+    unsigned long long bytes_sent = 0;
+    time_point_t link_free = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(print_mutex);
+        printf("\nClient %u connected.", client_number);
+        fflush(stdout);
+    }
+
+    while (!detach)
+    {
+        int length = recv(client, recv_buffer.data(), (int)recv_buffer.size(), 0);
+
+        if (length <= 0)
+        {
+            break;
+        }
+
+        received.append(recv_buffer.data(), (size_t)length);
+        time_point_t request_time = std::chrono::steady_clock::now();
+
+        for (;;)
+        {
+            // Skip the acknowledgments and break (Ctrl-C) characters
+            size_t start = received.find('$');
+            size_t end = (start == std::string::npos) ? std::string::npos : received.find('#', start);
+
+            if ((end == std::string::npos) || ((end + 3U) > received.size()))
+            {
+                if (start == std::string::npos)
+                {
+                    received.clear();
+                }
+                break;
+            }
+
+            std::string packet = received.substr(start + 1U, end - start - 1U);
+            unsigned checksum = (unsigned)strtoul(received.substr(end + 1U, 2U).c_str(), NULL, 16);
+            received.erase(0, end + 3U);
+            unsigned char sum = 0;
+
+            for (size_t i = 0; i < packet.size(); i++)
+            {
+                sum += (unsigned char)packet[i];
+            }
+
+            if (sum != checksum)
+            {
+                std::lock_guard<std::mutex> lock(print_mutex);
+                printf("\nClient %u: checksum error in packet '%.20s'", client_number, packet.c_str());
+
+                if (!no_ack)
+                {
+                    (void)send_all(client, "-", 1U);
+                }
+                continue;
+            }
+
+            if (!no_ack)
+            {
+                (void)send_all(client, "+", 1U);
+            }
+
+            if (verbose)
+            {
+                std::lock_guard<std::mutex> lock(print_mutex);
+                printf("\n%u> %.*s%s", client_number, MAX_VERBOSE_LENGTH, packet.c_str(),
+                    (packet.size() > MAX_VERBOSE_LENGTH) ? "..." : "");
+            }
+
+            std::string reply = process_packet(packet, &no_ack, &detach);
+            packets++;
+
+            // Emulate the debug probe timing
+            time_point_t send_time = request_time + std::chrono::microseconds(profile.latency_us);
+
+            if (send_time < link_free)
+            {
+                send_time = link_free;
+            }
+
+            if (profile.bandwidth != 0)
+            {
+                send_time += std::chrono::microseconds(
+                    (unsigned long long)reply.size() * 1000U / profile.bandwidth);
+            }
+
+            link_free = send_time;
+            std::this_thread::sleep_until(send_time);
+
+            if (!send_all(client, reply.data(), reply.size()))
+            {
+                detach = true;
+                break;
+            }
+
+            bytes_sent += reply.size();
+        }
+    }
+
+    (void)closesocket(client);
+    std::lock_guard<std::mutex> lock(print_mutex);
+    printf("\nClient %u disconnected - %llu packets, %llu bytes sent.", client_number, packets, bytes_sent);
+    sim_target_stats_t stats;
+    sim_target_get_stats(&stats);
+    printf("\nTarget: %llu messages (%llu words) logged, %llu discarded, logging stopped for %llu ms.",
+        stats.messages_logged, stats.words_logged, stats.messages_discarded, stats.blackout_ms);
+    fflush(stdout);
+}
+
+
+/***
+ * @brief Execute the request and prepare the reply.
+ *
+ * @param packet  Packet data (without '$' and checksum)
+ * @param no_ack  Set to true if the no-acknowledgment mode has been requested
+ * @param detach  Set to true if the client detached
+ *
+ * @return Reply packet(s) - an empty packet for unsupported requests
+ */
+
+static std::string process_packet(const std::string& packet, bool* no_ack, bool* detach)
+{
+    char text[128];
+
+    if (packet.compare(0, 10, "qSupported") == 0)
+    {
+        snprintf(text, sizeof(text), "PacketSize=%x;QStartNoAckMode+%s", profile.packet_size,
+            profile.binary ? ";binary-upload+" : "");
+        return make_packet(text);
+    }
+
+    if (packet == "QStartNoAckMode")
+    {
+        *no_ack = true;
+        return make_packet("OK");
+    }
+
+    if (packet == "?")
+    {
+        return make_packet("S05");
+    }
+
+    if ((packet == "D") || (packet == "k"))
+    {
+        *detach = true;
+        return make_packet("OK");
+    }
+
+    if (packet.compare(0, 6, "qRcmd,") == 0)
+    {
+        return monitor_command(packet);
+    }
+
+    switch (packet[0])
+    {
+        case 'm':
+        case 'x':
+            return make_packet(read_memory(packet[0], packet));
+
+        case 'M':
+        case 'X':
+            return make_packet(write_memory(packet[0], packet));
+
+        default:
+            return make_packet("");
+    }
+}
+
+
+/***
+ * @brief Memory read - 'm' (hex data) or 'x' (binary data) packet. The reply length is
+ *        limited to the packet size as with real GDB servers.
+ */
+
+static std::string read_memory(char type, const std::string& packet)
+{
+    unsigned address;
+    unsigned length;
+
+    if ((type == 'x') && !profile.binary)
+    {
+        return "";
+    }
+
+    if (!parse_address_length(&packet[1], &address, &length))
+    {
+        return "E01";
+    }
+
+    if ((type == 'm') && (length > (profile.packet_size / 2U)))
+    {
+        length = profile.packet_size / 2U;
+    }
+
+    std::vector<unsigned char> data(length + 1U);
+
+    if ((length > MAX_PACKET_SIZE) || !sim_target_read(address, data.data(), length))
+    {
+        return "E0E";
+    }
+
+    std::string reply;
+
+    if (type == 'm')
+    {
+        static const char hex_digits[] = "0123456789abcdef";
+
+        for (unsigned i = 0; i < length; i++)
+        {
+            reply += hex_digits[data[i] >> 4U];
+            reply += hex_digits[data[i] & 0x0FU];
+        }
+    }
+    else
+    {
+        reply = "b";
+
+        for (unsigned i = 0; (i < length) && (reply.size() < (profile.packet_size - 1U)); i++)
+        {
+            unsigned char c = data[i];
+
+            if ((c == '#') || (c == '$') || (c == '}') || (c == '*'))
+            {
+                reply += '}';
+                c ^= 0x20U;
+            }
+
+            reply += (char)c;
+        }
+    }
+
+    return rle_replies ? run_length_encode(reply) : reply;
+}
+
+
+/***
+ * @brief Memory write - 'M' (hex data) or 'X' (binary data) packet.
+ */
+
+static std::string write_memory(char type, const std::string& packet)
+{
+    unsigned address;
+    unsigned length;
+    size_t colon = packet.find(':');
+
+    if ((type == 'X') && !profile.binary)
+    {
+        return "";
+    }
+
+    if ((colon == std::string::npos) || !parse_address_length(&packet[1], &address, &length))
+    {
+        return "E01";
+    }
+
+    std::vector<unsigned char> data;
+
+    for (size_t i = colon + 1U; i < packet.size(); i++)
+    {
+        if (type == 'M')
+        {
+            if ((i + 1U) >= packet.size())
+            {
+                return "E01";
+            }
+
+            char hex[3] = { packet[i], packet[i + 1U], '\0' };
+            data.push_back((unsigned char)strtoul(hex, NULL, 16));
+            i++;
+        }
+        else if ((packet[i] == '}') && ((i + 1U) < packet.size()))
+        {
+            data.push_back((unsigned char)(packet[++i] ^ 0x20));
+        }
+        else
+        {
+            data.push_back((unsigned char)packet[i]);
+        }
+    }
+
+    if (data.size() != length)
+    {
+        return "E01";
+    }
+
+    data.push_back(0);      // Buffer not empty for zero length writes
+
+    if (!sim_target_write(address, data.data(), length))
+    {
+        return "E0E";
+    }
+
+    return "OK";
+}
+
+
+/***
+ * @brief Monitor command ("qRcmd,<hex encoded text>"). Only the OpenOCD "mww address value count"
+ *        command is implemented. Unknown commands are reported with an 'O' packet before "OK"
+ *        as OpenOCD does.
+ *
+ * @return Reply packet(s)
+ */
+
+static std::string monitor_command(const std::string& packet)
+{
+    std::string command;
+
+    for (size_t i = 6U; (i + 1U) < packet.size(); i += 2U)
+    {
+        char hex[3] = { packet[i], packet[i + 1U], '\0' };
+        command += (char)strtoul(hex, NULL, 16);
+    }
+
+    unsigned address;
+    unsigned value;
+    unsigned count;
+
+    if (profile.fill
+        && (sscanf(command.c_str(), "mww %x %x %u", &address, &value, &count) == 3))
+    {
+        return make_packet(sim_target_fill(address, value, count) ? "OK" : "E0E");
+    }
+
+    // Console output packet followed by the final reply
+    return make_packet(hex_encode("invalid command name \"" + command + "\"\n")) + make_packet("OK");
+}
+
+
+/***
+ * @brief Parse the "address,length" part of a memory read or write packet.
+ *
+ * @return true if both values were found
+ */
+
+static bool parse_address_length(const char* text, unsigned* address, unsigned* length)
+{
+    char* end;
+    *address = (unsigned)strtoul(text, &end, 16);
+
+    if (*end != ',')
+    {
+        return false;
+    }
+
+    *length = (unsigned)strtoul(end + 1, &end, 16);
+    return (*end == '\0') || (*end == ':');
+}
+
+
+/***
+ * @brief Run-length encode the reply data - character followed by '*' and the repeat
+ *        count + 29. Repeat counts that would give the '#' or '$' characters are not used.
+ *        Escaped characters ('}' followed by a character) are not encoded.
+ */
+
+static std::string run_length_encode(const std::string& data)
+{
+    std::string encoded;
+    size_t i = 0;
+
+    while (i < data.size())
+    {
+        char c = data[i];
+        encoded += c;
+        i++;
+
+        if (c == '}')
+        {
+            if (i < data.size())
+            {
+                encoded += data[i++];
+            }
+            continue;
+        }
+
+        int repeat = 0;
+
+        while (((i + (size_t)repeat) < data.size()) && (data[i + (size_t)repeat] == c) && (repeat < MAX_RLE_REPEAT))
+        {
+            repeat++;
+        }
+
+        while (((repeat + 29) == '#') || ((repeat + 29) == '$'))
+        {
+            repeat--;
+        }
+
+        if (repeat >= 3)
+        {
+            encoded += '*';
+            encoded += (char)(repeat + 29);
+            i += (size_t)repeat;
+        }
+    }
+
+    return encoded;
+}
+
+
+/***
+ * @brief Hex encode the text for the 'O' (console output) packet.
+ *        The result starts with 'O'.
+ */
+
+static std::string hex_encode(const std::string& text)
+{
+    std::string encoded = "O";
+    char hex[3];
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        snprintf(hex, sizeof(hex), "%02x", (unsigned char)text[i]);
+        encoded += hex;
+    }
+
+    return encoded;
+}
+
+
+/***
+ * @brief Prepare the packet - "$data#checksum".
+ */
+
+static std::string make_packet(const std::string& data)
+{
+    unsigned char sum = 0;
+
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        sum += (unsigned char)data[i];
+    }
+
+    char checksum[4];
+    snprintf(checksum, sizeof(checksum), "#%02x", sum);
+    return "$" + data + checksum;
+}
+
+
+/***
+ * @brief Send all data to the socket.
+ *
+ * @return true if the data was sent
+ */
+
+static bool send_all(SOCKET s, const char* data, size_t length)
+{
+    while (length > 0)
+    {
+        int sent = send(s, data, (int)length, SEND_FLAGS);
+
+        if (sent <= 0)
+        {
+            return false;
+        }
+
+        data += sent;
+        length -= (size_t)sent;
+    }
+
+    return true;
+}
+
+/*==== End of file ====*/
@@ -0,0 +1,678 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    rsp_replay.cpp
+ * @brief   Replay server for the GDB server communication recorded by RTEgetData
+ *          (-record=file_name). The recorded GDB server replies are sent back to a new
+ *          RTEgetData build with the original or scaled timing. Used to reproduce the
+ *          timing of a real debug probe and GDB server without the hardware and to compare
+ *          the data transfer optimizations with the same server behavior.
+ * @author  B. Premzel
+ *
+ * Usage: rsp_replay recording_file [options]
+ *   -port=N          TCP port (default 2331)
+ *   -scale=F         Time scale factor: 1 = original timing (default), 0.5 = twice as fast,
+ *                    0 = reply as soon as the request has been received
+ *   -loop            Start again with the first recorded connection after the last one
+ *   -verbose         Print the first difference between the recorded and received requests
+ *
+ * The n-th client connection gets the replies of the n-th recorded connection. The events of
+ * a connection are replayed in the recorded order. The data sent by RTEgetData before a reply
+ * must arrive first (the same number of bytes as in the recording). The reply is then sent
+ * with the recorded delay (scaled) after the later of the two preceding events - the arrival
+ * of the request data or the previous reply. Differences between the received and recorded
+ * requests are counted and reported, since the replies only make sense if the client sends
+ * the same requests - i.e. the same command line arguments have to be used.
+ *
+ * Example: RTEgetData 2331 0x20000000 0 -record=field.rec    (at the customer site)
+ *          rsp_replay field.rec -port=2331
+ *          RTEgetData 2331 0x20000000 0                        (new build)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "session_record.h"
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #define SEND_FLAGS 0
+#else
+    #include <sys/socket.h>
+    #include <sys/select.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    typedef int SOCKET;
+    #define INVALID_SOCKET  (-1)
+    #define closesocket(s)  close(s)
+    #define SEND_FLAGS      MSG_NOSIGNAL
+#endif
+
+#define DEFAULT_PORT          2331U
+#define RECV_BUFFER_SIZE      0x10000U
+#define CLIENT_TIMEOUT_MS     10000         // Max. waiting time for the recorded request data [ms]
+#define MAX_VERBOSE_LENGTH    40            // Max. number of characters printed for a difference
+
+
+typedef std::chrono::steady_clock::time_point time_point_t;
+
+typedef struct
+{
+    uint64_t time;              // Recorded time [ns]
+    uint8_t event;              // session_event_t
+    size_t offset;              // SESSION_SENT: end of the data in client_data
+                                // SESSION_RECEIVED: start of the data in server_data
+    size_t length;              // Number of data bytes
+} replay_event_t;
+
+typedef struct
+{
+    std::vector<replay_event_t> events;
+    std::string client_data;    // All data sent by RTEgetData (requests)
+    std::string server_data;    // All data received from the GDB server (replies)
+} recorded_connection_t;
+
+typedef struct
+{
+    SOCKET client;
+    const recorded_connection_t* recording;
+    size_t bytes_received;      // Number of bytes received from the client
+    std::vector<std::pair<size_t, time_point_t> > arrivals;    // End offset and arrival time of received blocks
+    size_t next_arrival;        // First arrival not checked yet (arrival_time())
+    unsigned long long differences;     // Number of bytes different from the recording
+    size_t first_difference;    // Offset of the first difference
+    std::string received_text;  // Data received at the first difference
+    bool disconnected;          // The client has closed the connection
+} replay_state_t;
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static std::vector<recorded_connection_t> connections;
+static const char* recording_file_name = NULL;
+static unsigned server_port = DEFAULT_PORT;
+static double time_scale = 1.0;
+static bool loop_replay;
+static bool verbose;
+static std::mutex print_mutex;
+
+
+/*---------------- Local functions ---------------*/
+static bool process_arguments(int argc, char* argv[]);
+static bool load_recording(const char* file_name);
+static void print_recording_summary(void);
+static void client_thread(SOCKET client, unsigned client_number, const recorded_connection_t* recording);
+static bool receive_data(replay_state_t* state, size_t needed, time_point_t deadline);
+static time_point_t arrival_time(replay_state_t* state, size_t offset);
+static void compare_data(replay_state_t* state, const char* data, size_t length);
+static bool send_all(SOCKET s, const char* data, size_t length);
+static double ms_between(time_point_t start, time_point_t end);
+static std::string printable_text(const char* data, size_t length);
+
+
+int main(int argc, char* argv[])
+{
+    if (!process_arguments(argc, argv))
+    {
+        printf("\nUsage: rsp_replay recording_file [-port=N] [-scale=F] [-loop] [-verbose]\n");
+        return 1;
+    }
+
+    if (!load_recording(recording_file_name))
+    {
+        return 1;
+    }
+
+#ifdef _WIN32
+    WSADATA wsa_data;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+    {
+        printf("\nWSAStartup failed.\n");
+        return 1;
+    }
+#endif
+
+    SOCKET server = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+    if (server == INVALID_SOCKET)
+    {
+        printf("\nCannot create the server socket.\n");
+        return 1;
+    }
+
+    int reuse = 1;
+    (void)setsockopt(server, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    struct sockaddr_in server_address;
+    memset(&server_address, 0, sizeof(server_address));
+    server_address.sin_family = AF_INET;
+    server_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server_address.sin_port = htons((unsigned short)server_port);
+
+    if ((bind(server, (struct sockaddr*)&server_address, sizeof(server_address)) != 0)
+        || (listen(server, 8) != 0))
+    {
+        printf("\nCannot listen on port %u.\n", server_port);
+        (void)closesocket(server);
+        return 1;
+    }
+
+    printf("RSP replay server listening on port %u, time scale %g%s", server_port, time_scale,
+        loop_replay ? ", loop" : "");
+    print_recording_summary();
+    fflush(stdout);
+
+    for (unsigned client_number = 1; ; client_number++)
+    {
+        SOCKET client = accept(server, NULL, NULL);
+
+        if (client == INVALID_SOCKET)
+        {
+            client_number--;
+            continue;
+        }
+
+        size_t index = client_number - 1U;
+
+        if (loop_replay)
+        {
+            index %= connections.size();
+        }
+
+        if (index >= connections.size())
+        {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            printf("\nClient %u rejected - all %u recorded connections have been replayed.",
+                client_number, (unsigned)connections.size());
+            fflush(stdout);
+            (void)closesocket(client);
+            continue;
+        }
+
+        int no_delay = 1;
+        (void)setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char*)&no_delay, sizeof(no_delay));
+
+        try
+        {
+            std::thread(client_thread, client, client_number, &connections[index]).detach();
+        }
+        catch (const std::system_error&)
+        {
+            printf("\nCannot start the client thread.\n");
+            (void)closesocket(client);
+        }
+    }
+}
+
+
+/***
+ * @brief Process the command line arguments.
+ *
+ * @return true if all arguments are valid
+ */
+
+static bool process_arguments(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+
+        if (strncmp(arg, "-port=", 6) == 0)
+        {
+            server_port = (unsigned)strtoul(&arg[6], NULL, 0);
+        }
+        else if (strncmp(arg, "-scale=", 7) == 0)
+        {
+            char* end;
+            time_scale = strtod(&arg[7], &end);
+
+            if ((*end != '\0') || !(time_scale >= 0) || (time_scale > 1000.0))
+            {
+                printf("\nThe time scale must be a number between 0 and 1000.");
+                return false;
+            }
+        }
+        else if (strcmp(arg, "-loop") == 0)
+        {
+            loop_replay = true;
+        }
+        else if (strcmp(arg, "-verbose") == 0)
+        {
+            verbose = true;
+        }
+        else if ((arg[0] != '-') && (recording_file_name == NULL))
+        {
+            recording_file_name = arg;
+        }
+        else
+        {
+            printf("\nUnknown argument '%s'.", arg);
+            return false;
+        }
+    }
+
+    if (recording_file_name == NULL)
+    {
+        printf("\nThe recording file name is missing.");
+        return false;
+    }
+
+    if ((server_port == 0) || (server_port > 65535U))
+    {
+        printf("\nIncorrect port number.");
+        return false;
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Load the recording file. The events of every recorded connection are collected
+ *        in the 'connections' vector in the order of connecting.
+ *
+ * @return true if the recording contains at least one connection
+ */
+
+static bool load_recording(const char* file_name)
+{
+    FILE* file = fopen(file_name, "rb");
+
+    if (file == NULL)
+    {
+        printf("\nCannot open the recording file '%s'.\n", file_name);
+        return false;
+    }
+
+    session_file_header_t header;
+
+    if ((fread(&header, sizeof(header), 1, file) != 1)
+        || (memcmp(header.magic, SESSION_FILE_MAGIC, sizeof(header.magic)) != 0)
+        || (header.version != SESSION_FILE_VERSION)
+        || (header.header_size < sizeof(header))
+        || (fseek(file, (long)header.header_size, SEEK_SET) != 0))
+    {
+        printf("\nThe file '%s' is not a session recording of a supported version.\n", file_name);
+        fclose(file);
+        return false;
+    }
+
+    std::map<unsigned, recorded_connection_t> recorded;
+    session_record_t record;
+    std::vector<char> data;
+    bool truncated = false;
+
+    while (fread(&record, sizeof(record), 1, file) == 1)
+    {
+        data.resize(record.length);
+
+        if ((record.length != 0) && (fread(data.data(), record.length, 1, file) != 1))
+        {
+            truncated = true;
+            break;
+        }
+
+        recorded_connection_t& connection = recorded[record.connection];
+        replay_event_t event;
+        event.time = record.time;
+        event.event = record.event;
+        event.length = record.length;
+
+        switch (record.event)
+        {
+            case SESSION_SENT:
+                connection.client_data.append(data.data(), record.length);
+                event.offset = connection.client_data.size();
+                break;
+
+            case SESSION_RECEIVED:
+                event.offset = connection.server_data.size();
+                connection.server_data.append(data.data(), record.length);
+                break;
+
+            case SESSION_CONNECTED:
+            case SESSION_CLOSED:
+                event.offset = 0;
+                break;
+
+            default:
+                continue;       // Unknown event types are skipped
+        }
+
+        connection.events.push_back(event);
+    }
+
+    fclose(file);
+
+    if (truncated)
+    {
+        printf("\nThe last record of the file is incomplete (recording interrupted) - it is ignored.");
+    }
+
+    for (std::map<unsigned, recorded_connection_t>::iterator i = recorded.begin(); i != recorded.end(); ++i)
+    {
+        if (!i->second.events.empty() && (i->second.events[0].event == SESSION_CONNECTED))
+        {
+            connections.push_back(i->second);
+        }
+    }
+
+    if (connections.empty())
+    {
+        printf("\nThe file '%s' does not contain any recorded connection.\n", file_name);
+        return false;
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Print the number of connections and the amount of data recorded for each one.
+ */
+
+static void print_recording_summary(void)
+{
+    printf("\nRecording '%s' - %u connection(s):", recording_file_name, (unsigned)connections.size());
+
+    for (size_t i = 0; i < connections.size(); i++)
+    {
+        const recorded_connection_t& connection = connections[i];
+        uint64_t duration = connection.events.back().time - connection.events.front().time;
+
+        printf("\n  %u: %u events, %llu bytes sent, %llu bytes received, %.1f ms%s", (unsigned)(i + 1U),
+            (unsigned)connection.events.size(), (unsigned long long)connection.client_data.size(),
+            (unsigned long long)connection.server_data.size(), (double)duration / 1e6,
+            (connection.events.back().event == SESSION_CLOSED) ? "" : " (not closed)");
+    }
+}
+
+
+/***
+ * @brief Replay one recorded connection. The recorded client data is awaited, and the
+ *        recorded replies are sent with the scaled delay after the preceding event.
+ */
+
+static void client_thread(SOCKET client, unsigned client_number, const recorded_connection_t* recording)
+{
+    replay_state_t state;
+    state.client = client;
+    state.recording = recording;
+    state.bytes_received = 0;
+    state.next_arrival = 0;
+    state.differences = 0;
+    state.first_difference = 0;
+    state.disconnected = false;
+
+    {
+        std::lock_guard<std::mutex> lock(print_mutex);
+        printf("\nClient %u connected.", client_number);
+        fflush(stdout);
+    }
+
+    const std::vector<replay_event_t>& events = recording->events;
+    time_point_t start_time = std::chrono::steady_clock::now();
+    uint64_t reference_time = events[0].time;       // Recorded time of the last event replayed
+    time_point_t reference = start_time;            // Replay time of the last event replayed
+    double max_delay_ms = 0;                        // Max. delay of a request compared to the recording
+    size_t replayed = 1;
+    bool ok = true;
+
+    for (; ok && (replayed < events.size()); replayed++)
+    {
+        const replay_event_t& event = events[replayed];
+        time_point_t scheduled = reference + std::chrono::nanoseconds(
+            (long long)((double)(event.time - reference_time) * time_scale));
+
+        switch (event.event)
+        {
+            case SESSION_SENT:
+                // Wait for the request data from the client
+                ok = receive_data(&state, event.offset, std::chrono::steady_clock::now());
+
+                if (ok)
+                {
+                    time_point_t arrival = arrival_time(&state, event.offset);
+
+                    if (ms_between(scheduled, arrival) > max_delay_ms)
+                    {
+                        max_delay_ms = ms_between(scheduled, arrival);
+                    }
+
+                    // A request sent earlier than in the recording (e.g. pipelined) is
+                    // processed after the previous reply - as by the GDB server
+                    if (arrival > reference)
+                    {
+                        reference = arrival;
+                    }
+                }
+                break;
+
+            case SESSION_RECEIVED:
+                // Receive the data arriving in the meantime (arrival time measurement)
+                ok = receive_data(&state, 0, scheduled)
+                    && send_all(client, &recording->server_data[event.offset], event.length);
+                reference = scheduled;
+                break;
+
+            default:        // SESSION_CLOSED
+                break;
+        }
+
+        reference_time = event.time;
+    }
+
+    (void)closesocket(client);
+    double replay_ms = ms_between(start_time, std::chrono::steady_clock::now());
+    double recorded_ms = (double)(events.back().time - events.front().time) / 1e6;
+    std::lock_guard<std::mutex> lock(print_mutex);
+
+    if (!ok)
+    {
+        replayed--;
+        printf("\nClient %u: %s after %llu of %llu request bytes (event %u of %u).", client_number,
+            state.disconnected ? "disconnected" : "request timeout",
+            (unsigned long long)state.bytes_received, (unsigned long long)recording->client_data.size(),
+            (unsigned)replayed, (unsigned)events.size());
+    }
+
+    printf("\nClient %u finished - replay %.1f ms, recording %.1f ms (scaled %.1f ms), max. request delay %.2f ms.",
+        client_number, replay_ms, recorded_ms, recorded_ms * time_scale, max_delay_ms);
+
+    if (state.differences != 0)
+    {
+        printf("\nClient %u: %llu request bytes differ from the recording (first at offset %llu)"
+            " - the replies may not match the requests.", client_number, state.differences,
+            (unsigned long long)state.first_difference);
+
+        if (verbose)
+        {
+            const std::string& recorded = recording->client_data;
+            size_t offset = std::min(state.first_difference, recorded.size());
+            printf("\n  recorded: '%s'\n  received: '%s'",
+                printable_text(&recorded.c_str()[offset], recorded.size() - offset).c_str(),
+                state.received_text.c_str());
+        }
+    }
+
+    fflush(stdout);
+}
+
+
+/***
+ * @brief Receive the data from the client until at least 'needed' bytes have been received
+ *        and the deadline has passed. The data already available is always received, so the
+ *        arrival time saved for every block is accurate.
+ *
+ * @param state     Replay state
+ * @param needed    Total number of bytes (since the connection start) to wait for
+ * @param deadline  Time until the data is received even if enough data is available
+ *
+ * @return false - the client disconnected or did not send the data in CLIENT_TIMEOUT_MS
+ */
+
+static bool receive_data(replay_state_t* state, size_t needed, time_point_t deadline)
+{
+    char buffer[RECV_BUFFER_SIZE];
+    time_point_t timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(CLIENT_TIMEOUT_MS);
+
+    for (;;)
+    {
+        time_point_t now = std::chrono::steady_clock::now();
+        time_point_t wait_until = (state->bytes_received < needed) ? timeout : deadline;
+        long long wait_us = (now < wait_until)
+            ? std::chrono::duration_cast<std::chrono::microseconds>(wait_until - now).count() : 0;
+        struct timeval tv;
+        tv.tv_sec = (long)(wait_us / 1000000);
+        tv.tv_usec = (long)(wait_us % 1000000);
+        fd_set read_set;
+        FD_ZERO(&read_set);
+        FD_SET(state->client, &read_set);
+
+        int res = select((int)state->client + 1, &read_set, NULL, NULL, &tv);
+
+        if (res < 0)
+        {
+            state->disconnected = true;
+            return false;
+        }
+
+        if (res == 0)
+        {
+            if (wait_us == 0)
+            {
+                return state->bytes_received >= needed;    // No more data available
+            }
+
+            continue;
+        }
+
+        int length = recv(state->client, buffer, (int)sizeof(buffer), 0);
+
+        if (length <= 0)
+        {
+            state->disconnected = true;
+            return false;
+        }
+
+        compare_data(state, buffer, (size_t)length);
+        state->bytes_received += (size_t)length;
+        state->arrivals.push_back(std::make_pair(state->bytes_received, std::chrono::steady_clock::now()));
+    }
+}
+
+
+/***
+ * @brief Find the time when the client data up to 'offset' arrived.
+ */
+
+static time_point_t arrival_time(replay_state_t* state, size_t offset)
+{
+    while ((state->next_arrival + 1U < state->arrivals.size())
+        && (state->arrivals[state->next_arrival].first < offset))
+    {
+        state->next_arrival++;
+    }
+
+    return state->arrivals[state->next_arrival].second;
+}
+
+
+/***
+ * @brief Compare the data received from the client with the recorded requests.
+ */
+
+static void compare_data(replay_state_t* state, const char* data, size_t length)
+{
+    const std::string& recorded = state->recording->client_data;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        size_t offset = state->bytes_received + i;
+
+        if ((offset >= recorded.size()) || (recorded[offset] != data[i]))
+        {
+            if (state->differences == 0)
+            {
+                state->first_difference = offset;
+                state->received_text = printable_text(&data[i], length - i);
+            }
+
+            state->differences++;
+        }
+    }
+}
+
+
+/***
+ * @brief Send all data to the socket.
+ *
+ * @return true if the data was sent
+ */
+
+static bool send_all(SOCKET s, const char* data, size_t length)
+{
+    while (length > 0)
+    {
+        int sent = send(s, data, (int)length, SEND_FLAGS);
+
+        if (sent <= 0)
+        {
+            return false;
+        }
+
+        data += sent;
+        length -= (size_t)sent;
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Time between two time points [ms] (negative if 'end' is before 'start').
+ */
+
+static double ms_between(time_point_t start, time_point_t end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+
+/***
+ * @brief Text for printing the data - max. MAX_VERBOSE_LENGTH characters, binary data
+ *        replaced with dots.
+ */
+
+static std::string printable_text(const char* data, size_t length)
+{
+    std::string text(data, std::min(length, (size_t)MAX_VERBOSE_LENGTH));
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        if ((text[i] < ' ') || (text[i] > '~'))
+        {
+            text[i] = '.';
+        }
+    }
+
+    return text;
+}
+
+/*==== End of file ====*/
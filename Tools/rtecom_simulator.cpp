@@ -0,0 +1,580 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    rtecom_simulator.cpp
+ * @brief   Embedded system simulator for the RTEcom serial protocol on a pseudo terminal (Linux).
+ *          Used to measure and test the serial data transfer without hardware.
+ * @author  B. Premzel
+ *
+ * Usage: rtecom_simulator [options]
+ *   -link=name       Symbolic link to the pseudo terminal (default /tmp/ttyRTE)
+ *   -baud=N          Simulated baud rate - 10 bits per character (default 0 = no pacing)
+ *   -latency=N       Command processing time before the reply [us]
+ *   -single_wire     Echo all received characters (single-wire communication)
+ *   -no_block        Block commands (RTECOM_FILL_RTEDBG, RTECOM_WRITE_RTEDBG_BLOCK) not supported
+ *   -cmd_error=N     Every Nth command is received with a line error (ignored)
+ *   -reply_error=N   The last character of every Nth RTECOM_READ_RTEDBG reply is lost
+ *   -verbose         Print the received commands
+ * The simulated target options (-address, -size, -rate, ...) are described in sim_target.h.
+ * The -address value is used by the RTECOM_READ and RTECOM_WRITExx commands.
+ *
+ * Example: rtecom_simulator -link=/tmp/ttyRTE -baud=921600 -cmd_error=50
+ *          RTEgetData $(readlink /tmp/ttyRTE)=921600 0 0
+ *
+ * The line errors are inserted deterministically, so the resynchronization cost can be
+ * measured repeatably. The simulator runs until it is stopped with Ctrl-C.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "rte_com.h"
+#include "sim_target.h"
+
+#define DEFAULT_LINK          "/tmp/ttyRTE"
+#define READ_BUFFER_SIZE      4096U
+#define BITS_PER_CHARACTER    10U           // Start bit, 8 data bits and stop bit
+#define IDLE_TIME_MS          1000          // Statistics are printed after this time without commands
+
+typedef std::chrono::steady_clock::time_point time_point_t;
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static const char* link_name = DEFAULT_LINK;
+static unsigned baud_rate;
+static unsigned latency_us;
+static bool single_wire;
+static bool block_commands = true;
+static unsigned cmd_error_interval;
+static unsigned reply_error_interval;
+static bool verbose;
+
+static int master_fd = -1;
+static const char* slave_name;              // Pseudo terminal name for RTEgetData (/dev/pts/N)
+static time_point_t line_free;               // End of the last character sent
+
+static uint8_t block_command = RTECOM_LAST_COMMAND;    // RTECOM_LAST_COMMAND - no block command active
+static uint32_t block_index;                // First word of the active block command
+static uint32_t block_words;                // Number of words of the active block command
+static unsigned long long commands_received;
+static unsigned long long read_replies;
+
+
+/*---------------- Local functions ---------------*/
+static bool process_arguments(int argc, char* argv[]);
+static bool open_pseudo_terminal(void);
+static size_t process_commands(unsigned char* data, size_t length);
+static size_t process_block_data(const unsigned char* data, size_t length);
+static void execute_command(const rtecom_send_data_t* packet);
+static bool rtedbg_words_ok(uint32_t index, uint32_t words);
+static void send_ack(void);
+static void send_nack(uint8_t command);
+static void send_data(const unsigned char* data, size_t length);
+static void print_statistics(void);
+
+
+int main(int argc, char* argv[])
+{
+    if (!process_arguments(argc, argv))
+    {
+        printf("\nUsage: rtecom_simulator [-link=name] [-baud=N] [-latency=us] [-single_wire] [-no_block]"
+            "\n       [-cmd_error=N] [-reply_error=N] [-verbose] [simulated target options]"
+            "\nSimulated target options:" SIM_TARGET_USAGE "\n");
+        return 1;
+    }
+
+    if (!sim_target_start() || !open_pseudo_terminal())
+    {
+        return 1;
+    }
+
+    printf("RTEcom simulator on %s (%s)", slave_name, link_name);
+    sim_target_print_config();
+    printf("\nBaud rate ");
+
+    if (baud_rate == 0)
+    {
+        printf("not simulated");
+    }
+    else
+    {
+        printf("%u", baud_rate);
+    }
+
+    printf("%s%s\n", single_wire ? ", single wire" : "", block_commands ? "" : ", no block commands");
+    fflush(stdout);
+
+    std::vector<unsigned char> received;
+    unsigned char read_buffer[READ_BUFFER_SIZE];
+    line_free = std::chrono::steady_clock::now();
+    bool host_active = false;
+
+    for (;;)
+    {
+        struct pollfd poll_data;
+        poll_data.fd = master_fd;
+        poll_data.events = POLLIN;
+        poll_data.revents = 0;
+
+        if (poll(&poll_data, 1, IDLE_TIME_MS) <= 0)
+        {
+            if (host_active)
+            {
+                print_statistics();
+                host_active = false;
+            }
+            continue;
+        }
+
+        ssize_t length = read(master_fd, read_buffer, sizeof(read_buffer));
+
+        if (length <= 0)
+        {
+            // No process has the terminal open
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        host_active = true;
+
+        if (single_wire)
+        {
+            send_data(read_buffer, (size_t)length);
+        }
+
+        received.insert(received.end(), read_buffer, read_buffer + length);
+        size_t processed = process_commands(received.data(), received.size());
+        received.erase(received.begin(), received.begin() + (std::ptrdiff_t)processed);
+    }
+}
+
+
+/***
+ * @brief Process the command line arguments.
+ *
+ * @return true if all arguments are valid
+ */
+
+static bool process_arguments(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = strchr(arg, '=');
+        value = (value != NULL) ? value + 1 : "";
+        unsigned number = (unsigned)strtoul(value, NULL, 0);
+
+        if (strncmp(arg, "-link=", 6) == 0)
+        {
+            link_name = value;
+        }
+        else if (strncmp(arg, "-baud=", 6) == 0)
+        {
+            baud_rate = number;
+        }
+        else if (strncmp(arg, "-latency=", 9) == 0)
+        {
+            latency_us = number;
+        }
+        else if (strcmp(arg, "-single_wire") == 0)
+        {
+            single_wire = true;
+        }
+        else if (strcmp(arg, "-no_block") == 0)
+        {
+            block_commands = false;
+        }
+        else if (strncmp(arg, "-cmd_error=", 11) == 0)
+        {
+            cmd_error_interval = number;
+        }
+        else if (strncmp(arg, "-reply_error=", 13) == 0)
+        {
+            reply_error_interval = number;
+        }
+        else if (strcmp(arg, "-verbose") == 0)
+        {
+            verbose = true;
+        }
+        else if (!sim_target_argument(arg))
+        {
+            printf("\nUnknown argument '%s'.", arg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Open the pseudo terminal and create the symbolic link to its slave side.
+ *        The slave side is kept open, so the master side remains usable when
+ *        RTEgetData closes the port.
+ *
+ * @return true if successful
+ */
+
+static bool open_pseudo_terminal(void)
+{
+    master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if ((master_fd < 0) || (grantpt(master_fd) != 0) || (unlockpt(master_fd) != 0))
+    {
+        printf("\nCannot open the pseudo terminal: %s\n", strerror(errno));
+        return false;
+    }
+
+    slave_name = ptsname(master_fd);
+    int slave_fd = (slave_name != NULL) ? open(slave_name, O_RDWR | O_NOCTTY) : -1;
+
+    if (slave_fd < 0)
+    {
+        printf("\nCannot open the pseudo terminal slave: %s\n", strerror(errno));
+        return false;
+    }
+
+    struct termios settings;
+
+    if (tcgetattr(slave_fd, &settings) == 0)
+    {
+        cfmakeraw(&settings);
+        (void)tcsetattr(slave_fd, TCSANOW, &settings);
+    }
+
+    (void)unlink(link_name);
+
+    if (symlink(slave_name, link_name) != 0)
+    {
+        printf("\nCannot create the link '%s': %s\n", link_name, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Process the received command packets and block command data.
+ *        Characters that do not start a valid packet are skipped one by one - the same as
+ *        the resynchronization in the embedded system.
+ *
+ * @return Number of characters processed
+ */
+
+static size_t process_commands(unsigned char* data, size_t length)
+{
+    size_t processed = 0;
+
+    while (processed < length)
+    {
+        if (block_command != RTECOM_LAST_COMMAND)
+        {
+            size_t used = process_block_data(&data[processed], length - processed);
+
+            if (used == 0)
+            {
+                break;      // Wait for the rest of the data
+            }
+
+            processed += used;
+            continue;
+        }
+
+        if ((length - processed) < RTECOM_SEND_PACKET_LEN)
+        {
+            break;
+        }
+
+        // Host sends: command, checksum, address, data (see rte_com.h)
+        rtecom_send_data_t packet;
+        unsigned char* p = &data[processed];
+        packet.command = p[0];
+        packet.checksum = p[1];
+        memcpy(&packet.address, &p[2], 4U);
+        memcpy(&packet.data, &p[6], 4U);
+
+        uint8_t checksum = RTECOM_CHECKSUM;
+
+        for (unsigned i = 2; i < RTECOM_SEND_PACKET_LEN; i++)
+        {
+            checksum ^= p[i];
+        }
+
+        if ((checksum != packet.checksum) || (packet.command >= RTECOM_LAST_COMMAND))
+        {
+            processed++;
+            continue;
+        }
+
+        processed += RTECOM_SEND_PACKET_LEN;
+        commands_received++;
+
+        if ((cmd_error_interval != 0) && ((commands_received % cmd_error_interval) == 0))
+        {
+            if (verbose)
+            {
+                printf("\nLine error - command %u ignored", packet.command);
+            }
+            continue;
+        }
+
+        if (verbose)
+        {
+            printf("\nCommand %u, address 0x%X, data 0x%X", packet.command, packet.address, packet.data);
+            fflush(stdout);
+        }
+
+        if (latency_us != 0)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(latency_us));
+        }
+
+        execute_command(&packet);
+    }
+
+    return processed;
+}
+
+
+/***
+ * @brief Receive the data that follows the RTECOM_FILL_RTEDBG or RTECOM_WRITE_RTEDBG_BLOCK command.
+ *
+ * @return Number of characters used (0 if all data has not been received yet)
+ */
+
+static size_t process_block_data(const unsigned char* data, size_t length)
+{
+    size_t needed = (block_command == RTECOM_FILL_RTEDBG) ? 4U : (size_t)block_words * 4U;
+
+    if (length < needed)
+    {
+        return 0;
+    }
+
+    unsigned address = sim_target_address() + block_index * 4U;
+
+    if (block_command == RTECOM_FILL_RTEDBG)
+    {
+        uint32_t pattern;
+        memcpy(&pattern, data, 4U);
+        (void)sim_target_fill(address, pattern, block_words);
+    }
+    else
+    {
+        (void)sim_target_write(address, data, block_words * 4U);
+    }
+
+    block_command = RTECOM_LAST_COMMAND;
+    send_ack();
+    return needed;
+}
+
+
+/***
+ * @brief Execute the command and send the reply.
+ */
+
+static void execute_command(const rtecom_send_data_t* packet)
+{
+    std::vector<unsigned char> data;
+
+    switch (packet->command)
+    {
+        case RTECOM_WRITE_RTEDBG:
+            if (!rtedbg_words_ok(packet->address, 1U))
+            {
+                send_nack(packet->command);
+                break;
+            }
+
+            (void)sim_target_write(sim_target_address() + packet->address * 4U,
+                (const unsigned char*)&packet->data, 4U);
+            send_ack();
+            break;
+
+        case RTECOM_READ_RTEDBG:
+            if ((packet->data == 0) || (packet->data > MAX_COM_RECEIVE_MSG_SIZE)
+                || (packet->address > sim_target_size()))
+            {
+                send_nack(packet->command);
+                break;
+            }
+
+            data.resize(packet->data);
+
+            if (!sim_target_read(sim_target_address() + packet->address, data.data(), packet->data))
+            {
+                send_nack(packet->command);
+                break;
+            }
+
+            read_replies++;
+
+            if ((reply_error_interval != 0) && ((read_replies % reply_error_interval) == 0))
+            {
+                send_data(data.data(), packet->data - 1U);      // Last character lost
+            }
+            else
+            {
+                send_data(data.data(), packet->data);
+            }
+            break;
+
+        case RTECOM_READ:
+            if ((packet->data == 0) || (packet->data > MAX_COM_RECEIVE_MSG_SIZE))
+            {
+                break;
+            }
+
+            data.resize(packet->data);
+
+            if (sim_target_read(packet->address, data.data(), packet->data))
+            {
+                send_data(data.data(), packet->data);
+            }
+            break;
+
+        case RTECOM_WRITE32:
+        case RTECOM_WRITE16:
+        case RTECOM_WRITE8:
+        {
+            uint32_t size = (packet->command == RTECOM_WRITE32) ? 4U : ((packet->command == RTECOM_WRITE16) ? 2U : 1U);
+
+            // Little endian - the lower bytes of the data word are written
+            if (!sim_target_write(packet->address, (const unsigned char*)&packet->data, size))
+            {
+                send_nack(packet->command);
+                break;
+            }
+
+            send_ack();
+            break;
+        }
+
+        case RTECOM_FILL_RTEDBG:
+        case RTECOM_WRITE_RTEDBG_BLOCK:
+            if (!block_commands || (packet->data == 0) || !rtedbg_words_ok(packet->address, packet->data)
+                || ((packet->command == RTECOM_WRITE_RTEDBG_BLOCK) && (packet->data > RTECOM_MAX_WRITE_BLOCK_WORDS)))
+            {
+                send_nack(packet->command);
+                break;
+            }
+
+            block_command = packet->command;
+            block_index = packet->address;
+            block_words = packet->data;
+            send_ack();
+            break;
+
+        default:
+            send_nack(packet->command);
+            break;
+    }
+}
+
+
+/***
+ * @brief Check that the 32-bit words (index relative to the g_rtedbg start) are within the structure.
+ */
+
+static bool rtedbg_words_ok(uint32_t index, uint32_t words)
+{
+    return (((unsigned long long)index + words) * 4U) <= sim_target_size();
+}
+
+
+/***
+ * @brief Send the acknowledge (RTECOM_ACK).
+ */
+
+static void send_ack(void)
+{
+    unsigned char ack = RTECOM_ACK;
+    send_data(&ack, 1U);
+}
+
+
+/***
+ * @brief Send the negative acknowledge (the command value).
+ */
+
+static void send_nack(uint8_t command)
+{
+    send_data(&command, 1U);
+}
+
+
+/***
+ * @brief Send the data to the host. If the baud rate is simulated, the data is sent in
+ *        chunks of approx. one millisecond at the time the last character of the chunk
+ *        would have been received.
+ */
+
+static void send_data(const unsigned char* data, size_t length)
+{
+    size_t chunk_size = (baud_rate == 0) ? length : (baud_rate / BITS_PER_CHARACTER / 1000U) + 1U;
+
+    while (length > 0)
+    {
+        size_t size = (length < chunk_size) ? length : chunk_size;
+
+        if (baud_rate != 0)
+        {
+            time_point_t now = std::chrono::steady_clock::now();
+
+            if (line_free < now)
+            {
+                line_free = now;
+            }
+
+            line_free += std::chrono::microseconds(
+                (unsigned long long)size * BITS_PER_CHARACTER * 1000000U / baud_rate);
+            std::this_thread::sleep_until(line_free);
+        }
+
+        ssize_t written = write(master_fd, data, size);
+
+        if (written <= 0)
+        {
+            if ((written < 0) && (errno != EAGAIN) && (errno != EINTR))
+            {
+                return;
+            }
+            continue;
+        }
+
+        data += written;
+        length -= (size_t)written;
+    }
+}
+
+
+/***
+ * @brief Print the command and simulated target statistics when the host stopped sending commands.
+ */
+
+static void print_statistics(void)
+{
+    sim_target_stats_t stats;
+    sim_target_get_stats(&stats);
+    printf("\nIdle - %llu commands received, %llu read replies.", commands_received, read_replies);
+    printf("\nTarget: %llu messages (%llu words) logged, %llu discarded, logging stopped for %llu ms.",
+        stats.messages_logged, stats.words_logged, stats.messages_discarded, stats.blackout_ms);
+    fflush(stdout);
+}
+
+/*==== End of file ====*/
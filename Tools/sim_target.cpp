@@ -0,0 +1,531 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    sim_target.cpp
+ * @brief   Simulated embedded system with the g_rtedbg data logging structure.
+ * @author  B. Premzel
+ *
+ * A producer thread simulates the firmware that logs messages into the circular buffer
+ * with the configured rate (words/s) and bursts. The g_rtedbg header is handled as by
+ * the RTEdbg library:
+ *  - last_index is the index of the next word to be written,
+ *  - a message is logged only if its filter group bit is set in the message filter,
+ *  - in the post-mortem mode the logging wraps around the end of the buffer (masking of
+ *    the index if the buffer size is a power of 2, otherwise the index is compared),
+ *  - in the single shot mode the logging stops when the next message does not fit into
+ *    the buffer - the filter is copied to filter_copy and set to zero.
+ * The host switches between the modes with bit 0 of rte_cfg and restarts the logging by
+ * writing the filter and last_index values.
+ *
+ * Message layout (simplified - the data is not meant to be decoded with RTEdbg):
+ * up to four data words followed by the format word. Bit 0 of the data words is zero.
+ * The format word has bit 0 set, bits 1..4 contain the most significant bits of the data
+ * words, bits 5..22 the timestamp and bits 23..31 the format ID. The upper five bits of
+ * the format ID select the message filter group. The first data word is the message
+ * sequence number, so lost messages can be detected in the transferred data.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "rtedbg.h"
+#include "sim_target.h"
+
+#define DEFAULT_ADDRESS        0x20000000U
+#define DEFAULT_BUFFER_SIZE    4096U        // Circular buffer size [words]
+#define MIN_BUFFER_WORDS       16U
+#define MAX_BUFFER_WORDS       ((2100000U - sizeof(rtedbg_header_t)) / 4U)
+#define DEFAULT_BURST_PERIOD   100U         // [ms]
+#define MAX_DATA_WORDS         4U           // Max. number of data words in a message
+#define FMT_ID_BITS            9U
+#define TIMESTAMP_BITS         18U
+#define TIMESTAMP_FREQUENCY    1000000U     // Timestamp counter frequency [Hz]
+#define TIMESTAMP_SHIFT        1U           // RTE_TIMESTAMP_SHIFT (rte_cfg bits 8..11 = 0)
+#define PRODUCER_PERIOD_US     1000U        // Producer thread wake-up period
+
+#define HEADER_WORDS           (sizeof(rtedbg_header_t) / 4U)
+#define INDEX_WORD             (offsetof(rtedbg_header_t, last_index) / 4U)
+#define FILTER_WORD            (offsetof(rtedbg_header_t, filter) / 4U)
+#define CFG_WORD               (offsetof(rtedbg_header_t, rte_cfg) / 4U)
+#define FILTER_COPY_WORD       (offsetof(rtedbg_header_t, filter_copy) / 4U)
+
+typedef std::chrono::steady_clock::time_point time_point_t;
+
+
+/*---------------- GLOBAL VARIABLES ------------------*/
+static unsigned rtedbg_address = DEFAULT_ADDRESS;
+static unsigned buffer_words = DEFAULT_BUFFER_SIZE;
+static unsigned log_rate;                   // Words logged per second
+static unsigned burst_words;
+static unsigned burst_period = DEFAULT_BURST_PERIOD;
+static bool single_shot;
+static const char* image_file_name;         // Initial g_rtedbg structure is written to this file
+
+static std::vector<uint32_t> memory;        // g_rtedbg structure - header and circular buffer
+static std::mutex memory_mutex;
+static time_point_t start_time;
+static uint32_t random_state = 0x12345678U;
+static uint32_t message_number;
+static sim_target_stats_t stats;
+
+
+/*---------------- Local functions ---------------*/
+static void producer_thread(void);
+static unsigned log_message(void);
+static uint32_t next_random(void);
+static bool range_ok(unsigned address, unsigned length);
+static bool write_image_file(void);
+
+
+/***
+ * @brief Process a command line argument of the simulated target (see SIM_TARGET_USAGE).
+ *
+ * @return true if the argument belongs to the simulated target
+ */
+
+bool sim_target_argument(const char* argument)
+{
+    const char* value = strchr(argument, '=');
+    unsigned number = (value != NULL) ? (unsigned)strtoul(value + 1, NULL, 0) : 0;
+
+    if (strncmp(argument, "-address=", 9) == 0)
+    {
+        rtedbg_address = number;
+    }
+    else if (strncmp(argument, "-size=", 6) == 0)
+    {
+        buffer_words = number;
+    }
+    else if (strncmp(argument, "-rate=", 6) == 0)
+    {
+        log_rate = number;
+    }
+    else if (strncmp(argument, "-burst=", 7) == 0)
+    {
+        burst_words = number;
+    }
+    else if (strncmp(argument, "-burst_period=", 14) == 0)
+    {
+        burst_period = number;
+    }
+    else if (strcmp(argument, "-single_shot") == 0)
+    {
+        single_shot = true;
+    }
+    else if ((strncmp(argument, "-image=", 7) == 0) && (argument[7] != '\0'))
+    {
+        image_file_name = argument + 7;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Prepare the g_rtedbg structure and start the producer thread.
+ *        The buffer is filled with messages once if no logging rate has been defined
+ *        (static buffer contents for data transfer measurements). Otherwise it is
+ *        empty (0xFFFFFFFF) as after rte_init().
+ *
+ * @return true if successful
+ */
+
+bool sim_target_start(void)
+{
+    if ((buffer_words < MIN_BUFFER_WORDS) || (buffer_words > MAX_BUFFER_WORDS))
+    {
+        printf("\nThe buffer size must be between %u and %u words.", MIN_BUFFER_WORDS, (unsigned)MAX_BUFFER_WORDS);
+        return false;
+    }
+
+    if ((burst_words != 0) && (burst_period == 0))
+    {
+        printf("\nThe burst period must not be zero.");
+        return false;
+    }
+
+    rtedbg_header_t rtedbg_header;      // Name used by the rtedbg.h macros
+    memset(&rtedbg_header, 0, sizeof(rtedbg_header));
+    rtedbg_header.filter = 0xFFFFFFFFU;
+    rtedbg_header.filter_copy = 0xFFFFFFFFU;
+    rtedbg_header.timestamp_frequency = TIMESTAMP_FREQUENCY;
+    rtedbg_header.buffer_size = buffer_words;
+    rtedbg_header.rte_cfg = (HEADER_WORDS << 24U)
+        | (1U << 16U)       // Max. one block per message
+        | (1U << 3U)        // Single shot logging enabled
+        | (1U << 2U)        // Filter off enabled (filter_copy used)
+        | (1U << 1U);       // Message filtering enabled
+
+    if ((buffer_words & (buffer_words - 1U)) == 0)
+    {
+        rtedbg_header.rte_cfg |= 1U << 31U;
+    }
+
+    if (single_shot)
+    {
+        RTE_ENABLE_SINGLE_SHOT_MODE;
+    }
+
+    memory.assign(HEADER_WORDS + buffer_words, 0xFFFFFFFFU);
+    memcpy(memory.data(), &rtedbg_header, sizeof(rtedbg_header));
+    start_time = std::chrono::steady_clock::now();
+
+    if ((log_rate == 0) && (burst_words == 0))
+    {
+        unsigned words = 0;
+
+        while (words < buffer_words)
+        {
+            words += log_message();
+        }
+
+        return write_image_file();
+    }
+
+    if (!write_image_file())
+    {
+        return false;
+    }
+
+    try
+    {
+        std::thread(producer_thread).detach();
+    }
+    catch (const std::system_error&)
+    {
+        printf("\nCannot start the producer thread.");
+        return false;
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Write the initial g_rtedbg structure to the -image file (if defined). The automated
+ *        tests compare the data transferred by RTEgetData with it.
+ *
+ * @return false if the file could not be written
+ */
+
+static bool write_image_file(void)
+{
+    if (image_file_name == NULL)
+    {
+        return true;
+    }
+
+    FILE* image_file = fopen(image_file_name, "wb");
+
+    if (image_file == NULL)
+    {
+        printf("\nCannot create the file \"%s\".", image_file_name);
+        return false;
+    }
+
+    size_t written = fwrite(memory.data(), sizeof(uint32_t), memory.size(), image_file);
+
+    if ((fclose(image_file) != 0) || (written != memory.size()))
+    {
+        printf("\nCannot write to the file \"%s\".", image_file_name);
+        return false;
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Address of the g_rtedbg structure in the simulated target.
+ */
+
+unsigned sim_target_address(void)
+{
+    return rtedbg_address;
+}
+
+
+/***
+ * @brief Size of the g_rtedbg structure [bytes].
+ */
+
+unsigned sim_target_size(void)
+{
+    return (unsigned)(memory.size() * 4U);
+}
+
+
+/***
+ * @brief Read a memory block of the g_rtedbg structure.
+ *
+ * @return false if the block is not within the structure
+ */
+
+bool sim_target_read(unsigned address, unsigned char* data, unsigned length)
+{
+    if (!range_ok(address, length))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    memcpy(data, (const unsigned char*)memory.data() + (address - rtedbg_address), length);
+    return true;
+}
+
+
+/***
+ * @brief Write a memory block of the g_rtedbg structure.
+ *
+ * @return false if the block is not within the structure
+ */
+
+bool sim_target_write(unsigned address, const unsigned char* data, unsigned length)
+{
+    if (!range_ok(address, length))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    memcpy((unsigned char*)memory.data() + (address - rtedbg_address), data, length);
+    return true;
+}
+
+
+/***
+ * @brief Fill 32-bit words of the g_rtedbg structure with a pattern.
+ *
+ * @return false if the words are not within the structure or the address is not aligned
+ */
+
+bool sim_target_fill(unsigned address, uint32_t pattern, unsigned words)
+{
+    if (((address & 3U) != 0) || !range_ok(address, words * 4U))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    unsigned first = (address - rtedbg_address) / 4U;
+
+    for (unsigned i = 0; i < words; i++)
+    {
+        memory[first + i] = pattern;
+    }
+
+    return true;
+}
+
+
+/***
+ * @brief Copy the producer statistics.
+ */
+
+void sim_target_get_stats(sim_target_stats_t* target_stats)
+{
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    *target_stats = stats;
+}
+
+
+/***
+ * @brief Print the simulated target configuration.
+ */
+
+void sim_target_print_config(void)
+{
+    printf("\ng_rtedbg at 0x%08X, buffer %u words, %s logging, ", rtedbg_address, buffer_words,
+        single_shot ? "single shot" : "post-mortem");
+
+    if ((log_rate == 0) && (burst_words == 0))
+    {
+        printf("static buffer contents");
+    }
+    else
+    {
+        printf("%u words/s", log_rate);
+
+        if (burst_words != 0)
+        {
+            printf(" + %u words every %u ms", burst_words, burst_period);
+        }
+    }
+}
+
+
+/***
+ * @brief Simulated firmware - log messages at the configured rate and bursts.
+ *        Words of a message that exceed the number of words due are credited to the
+ *        next period, so the average rate is exact.
+ */
+
+static void producer_thread(void)
+{
+    time_point_t last_time = start_time;
+    time_point_t next_burst = start_time + std::chrono::milliseconds(burst_period);
+    unsigned long long words_due = 0;
+    unsigned long long words_done = 0;
+
+    for (;;)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(PRODUCER_PERIOD_US));
+        time_point_t now = std::chrono::steady_clock::now();
+        unsigned long long elapsed_us =
+            (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(now - start_time).count();
+        unsigned long long rate_words = elapsed_us * log_rate / 1000000U;
+
+        if (rate_words > words_due)
+        {
+            words_due = rate_words;
+        }
+
+        while ((burst_words != 0) && (now >= next_burst))
+        {
+            words_due += burst_words;
+            next_burst += std::chrono::milliseconds(burst_period);
+        }
+
+        while (words_done < words_due)
+        {
+            words_done += log_message();
+        }
+
+        std::lock_guard<std::mutex> lock(memory_mutex);
+
+        if (memory[FILTER_WORD] == 0)
+        {
+            stats.blackout_ms +=
+                (unsigned long long)std::chrono::duration_cast<std::chrono::milliseconds>(now - last_time).count();
+        }
+
+        last_time = now;
+    }
+}
+
+
+/***
+ * @brief Log one message with a random number of data words.
+ *
+ * @return Message length [words] - also if the message has been discarded
+ */
+
+static unsigned log_message(void)
+{
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    uint32_t data[MAX_DATA_WORDS + 1U];
+    unsigned data_words = 1U + next_random() % MAX_DATA_WORDS;
+    uint32_t fmt_id = next_random() % ((1U << FMT_ID_BITS) - 1U);  // All ones not used (0xFFFFFFFF = empty)
+    uint32_t timestamp = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start_time).count() >> TIMESTAMP_SHIFT;
+    uint32_t fmt_word = (fmt_id << (32U - FMT_ID_BITS)) | ((timestamp & ((1U << TIMESTAMP_BITS) - 1U)) << 5U) | 1U;
+    data[0] = message_number++;
+
+    for (unsigned i = 1; i < data_words; i++)
+    {
+        data[i] = next_random();
+    }
+
+    for (unsigned i = 0; i < data_words; i++)
+    {
+        fmt_word |= (data[i] >> 31U) << (i + 1U);
+        data[i] <<= 1U;
+    }
+
+    data[data_words] = fmt_word;
+    unsigned length = data_words + 1U;
+    uint32_t filter = memory[FILTER_WORD];
+
+    if ((filter & (1U << (fmt_id >> (FMT_ID_BITS - 5U)))) == 0)
+    {
+        stats.messages_discarded++;
+        return length;
+    }
+
+    uint32_t* buffer = &memory[HEADER_WORDS];
+    uint32_t index = memory[INDEX_WORD];
+    rtedbg_header_t rtedbg_header;      // Name used by the rtedbg.h macros
+    rtedbg_header.rte_cfg = memory[CFG_WORD];
+
+    if (RTE_SINGLE_SHOT_WAS_ACTIVE && RTE_SINGLE_SHOT_LOGGING_ENABLED)
+    {
+        if ((index + length) > buffer_words)
+        {
+            // Buffer full - stop logging
+            memory[FILTER_COPY_WORD] = filter;
+            memory[FILTER_WORD] = 0;
+            stats.messages_discarded++;
+            return length;
+        }
+
+        memcpy(&buffer[index], data, length * 4U);
+        memory[INDEX_WORD] = index + length;
+    }
+    else
+    {
+        if (index >= buffer_words)
+        {
+            index = 0;
+        }
+
+        for (unsigned i = 0; i < length; i++)
+        {
+            buffer[index] = data[i];
+
+            if (RTE_BUFF_SIZE_IS_POWER_OF_2)
+            {
+                index = (index + 1U) & (buffer_words - 1U);
+            }
+            else if (++index >= buffer_words)
+            {
+                index = 0;
+            }
+        }
+
+        memory[INDEX_WORD] = index;
+    }
+
+    stats.messages_logged++;
+    stats.words_logged += length;
+    return length;
+}
+
+
+/***
+ * @brief Pseudo random number generator (xorshift) - the same sequence after each start.
+ */
+
+static uint32_t next_random(void)
+{
+    random_state ^= random_state << 13U;
+    random_state ^= random_state >> 17U;
+    random_state ^= random_state << 5U;
+    return random_state;
+}
+
+
+/***
+ * @brief Check that the memory block lies within the g_rtedbg structure.
+ */
+
+static bool range_ok(unsigned address, unsigned length)
+{
+    return (address >= rtedbg_address)
+        && (((unsigned long long)address + length) <= ((unsigned long long)rtedbg_address + memory.size() * 4U));
+}
+
+/*==== End of file ====*/
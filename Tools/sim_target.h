@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Branko Premzel.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/***
+ * @file    sim_target.h
+ * @brief   Simulated embedded system with the g_rtedbg data logging structure and a
+ *          firmware that logs messages at a configurable rate. Used by the simulators
+ *          in the Tools folder.
+ * @author  B. Premzel
+ */
+
+#ifndef _SIM_TARGET_H
+#define _SIM_TARGET_H
+
+#include <stdint.h>
+
+#define SIM_TARGET_USAGE \
+    "\n  -address=0xN        Address of the g_rtedbg structure (default 0x20000000)" \
+    "\n  -size=N             Circular buffer size in 32-bit words (default 4096)" \
+    "\n  -rate=N             Words logged per second (default 0 - static buffer contents)" \
+    "\n  -burst=N            Additional words logged at once every -burst_period" \
+    "\n  -burst_period=N     Burst period [ms] (default 100)" \
+    "\n  -single_shot        Single shot logging active after start (post-mortem by default)" \
+    "\n  -image=file         Write the initial g_rtedbg structure to a file (reference for tests)"
+
+typedef struct
+{
+    unsigned long long words_logged;        // Words written to the circular buffer
+    unsigned long long messages_logged;
+    unsigned long long messages_discarded;  // Not logged - message filter zero or single shot buffer full
+    unsigned long long blackout_ms;         // Total time the logging was stopped (filter zero)
+} sim_target_stats_t;
+
+
+bool sim_target_argument(const char* argument);
+bool sim_target_start(void);
+unsigned sim_target_address(void);
+unsigned sim_target_size(void);
+bool sim_target_read(unsigned address, unsigned char* data, unsigned length);
+bool sim_target_write(unsigned address, const unsigned char* data, unsigned length);
+bool sim_target_fill(unsigned address, uint32_t pattern, unsigned words);
+void sim_target_get_stats(sim_target_stats_t* stats);
+void sim_target_print_config(void);
+
+#endif  // _SIM_TARGET_H
+
+/*==== End of file ====*/
@@ -0,0 +1,89 @@
+#!/bin/sh
+#
+# Copyright (c) Branko Premzel.
+#
+# SPDX-License-Identifier: MIT
+#
+# Common part of the automated tests with the simulators (sourced by the test scripts).
+#
+# The test scripts are started with: interface simulator RTEgetData work_dir "simulator options"
+# [RTEgetData options]
+#
+# gdb - the mock GDB server is started on a free port,
+# com - the RTEcom simulator is started on a pseudo terminal (link in the work_dir).
+# After start_simulator the $target variable contains the RTEgetData mandatory parameters.
+
+interface="$1"
+simulator="$2"
+rtegetdata="$3"
+work_dir="$4"
+simulator_options="$5"
+shift 5
+
+image_file="$work_dir/image.bin"
+data_file="$work_dir/data.bin"
+simulator_log="$work_dir/simulator.log"
+com_link="$work_dir/tty"
+rtedbg_address=0x20000000
+header_size=24
+simulator_pid=""
+target=""
+
+stop_simulator()
+{
+    if [ -n "$simulator_pid" ]; then
+        kill "$simulator_pid" 2>/dev/null
+        wait "$simulator_pid" 2>/dev/null
+        simulator_pid=""
+    fi
+}
+
+fail()
+{
+    echo "FAILED: $1"
+    echo "--- simulator output:"
+    cat "$simulator_log"
+    stop_simulator
+    exit 1
+}
+
+start_simulator()
+{
+    trap stop_simulator EXIT
+    mkdir -p "$work_dir" || exit 1
+    rm -f "$image_file" "$data_file" "$simulator_log" "$com_link"
+
+    case "$interface" in
+        gdb) port_option="-port=0" ;;
+        com) port_option="-link=$com_link" ;;
+        *)   echo "Unknown interface '$interface'."; exit 1 ;;
+    esac
+
+    # shellcheck disable=SC2086
+    "$simulator" $port_option -address=$rtedbg_address -image="$image_file" $simulator_options \
+        > "$simulator_log" 2>&1 &
+    simulator_pid=$!
+
+    # Wait for the mock GDB server to report the port assigned by the system or for the
+    # RTEcom simulator to create the pseudo terminal link.
+    for i in $(seq 50); do
+        if [ "$interface" = "gdb" ]; then
+            port=$(sed -n 's/.*listening on port \([0-9]*\).*/\1/p' "$simulator_log")
+            [ -n "$port" ] && target="$port $rtedbg_address 0"
+        elif [ -L "$com_link" ] && [ -s "$simulator_log" ]; then
+            target="$(readlink "$com_link")=921600 0 0"
+        fi
+
+        [ -n "$target" ] && break
+        kill -0 "$simulator_pid" 2>/dev/null || fail "the simulator did not start"
+        sleep 0.1
+    done
+
+    [ -n "$target" ] || fail "the simulator is not ready"
+}
+
+# Print the 32-bit words (little endian) of a file from word $2 on, one per line.
+file_words()
+{
+    tail -c +$(($2 * 4 + 1)) "$1" | od -An -v -tu4 | tr -s ' ' '\n' | sed '/^$/d'
+}
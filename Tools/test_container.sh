@@ -0,0 +1,77 @@
+#!/bin/sh
+#
+# Copyright (c) Branko Premzel.
+#
+# SPDX-License-Identifier: MIT
+#
+# Automated container file test with the simulators (started by ctest).
+#
+# Usage: test_container.sh gdb|com simulator RTEgetData work_dir "simulator options" [RTEgetData options]
+# (see test_common.sh)
+#
+# The simulated firmware must log data (-rate), so that the snapshots differ. Snapshots are
+# appended by single transfers (the container is reopened each time) and by a persistent
+# mode session (the container stays open) - more than SNAPSHOT_INDEX_CAPACITY snapshots,
+# so a new index block is written. The extracted snapshots must be identical to the data
+# files written by the transfers. The trailer is then damaged - the index must be rebuilt
+# and a new snapshot appended.
+
+. "$(dirname "$0")/test_common.sh"
+start_simulator
+
+container="$work_dir/snapshots.rte"
+extracted="$work_dir/extracted.bin"
+output="$work_dir/output.txt"
+session_transfers=70
+rm -f "$container" "$extracted" "$work_dir"/snapshot_*.bin "$output"
+
+extract()
+{
+    rm -f "$extracted"
+    # shellcheck disable=SC2086
+    "$rtegetdata" $target -container="$container" -extract="$1" -bin="$extracted" > "$output" 2>&1
+}
+
+check_snapshot()
+{
+    extract "$1" || fail "snapshot $1 could not be extracted"
+    cmp "$2" "$extracted" || fail "snapshot $1 differs from $2"
+}
+
+for i in 1 2 3; do
+    # shellcheck disable=SC2086
+    "$rtegetdata" $target -bin="$data_file" -container="$container" "$@" > "$output" 2>&1 \
+        || fail "RTEgetData returned an error (transfer $i)"
+    cp "$data_file" "$work_dir/snapshot_$i.bin"
+done
+
+# Persistent mode - 'Space' for each transfer, then 'Esc' and 'Y' to exit
+# shellcheck disable=SC2086
+printf "%${session_transfers}s\033Y" "" \
+    | "$rtegetdata" $target -p -bin="$data_file" -container="$container" "$@" > "$output" 2>&1 \
+    || fail "RTEgetData returned an error (persistent mode)"
+last=$((3 + session_transfers))
+cp "$data_file" "$work_dir/snapshot_last.bin"
+
+check_snapshot 1 "$work_dir/snapshot_1.bin"
+check_snapshot 3 "$work_dir/snapshot_3.bin"
+check_snapshot $last "$data_file"
+extract $((last + 1)) && fail "snapshot $((last + 1)) should not exist"
+
+# Damage the trailer - the index must be rebuilt from the records
+size=$(wc -c < "$container")
+head -c $((size - 5)) "$container" > "$container.tmp" && mv "$container.tmp" "$container"
+check_snapshot 2 "$work_dir/snapshot_2.bin"
+grep -q "rebuilding" "$output" || fail "the damaged index has not been detected"
+
+# shellcheck disable=SC2086
+"$rtegetdata" $target -bin="$data_file" -container="$container" "$@" > "$output" 2>&1 \
+    || fail "RTEgetData returned an error (transfer after the index rebuild)"
+check_snapshot $((last + 1)) "$data_file"
+grep -q "rebuilding" "$output" && fail "the index has not been written after the rebuild"
+check_snapshot $last "$work_dir/snapshot_last.bin"
+check_snapshot 1 "$work_dir/snapshot_1.bin"
+
+stop_simulator
+echo "PASSED"
+exit 0
@@ -0,0 +1,51 @@
+#!/bin/sh
+#
+# Copyright (c) Branko Premzel.
+#
+# SPDX-License-Identifier: MIT
+#
+# Automated incremental transfer test with the simulators (started by ctest).
+#
+# Usage: test_incremental.sh gdb|com simulator RTEgetData work_dir "simulator options" [RTEgetData options]
+# (see test_common.sh)
+#
+# The simulated firmware must log data (-rate). Several incremental transfers are done in
+# the persistent mode while the data is logged (the circular buffer wraps around). The
+# message filter is then set to zero ('F' command), so the logging stops, and the last
+# incremental transfer is done. The host copy written to the data file must be identical
+# to the structure read afterwards with a complete transfer.
+
+. "$(dirname "$0")/test_common.sh"
+start_simulator
+
+incremental_file="$work_dir/incremental.bin"
+output="$work_dir/output.txt"
+rm -f "$incremental_file" "$output"
+
+# 'Space' - transfer, 'F' and "0" - stop the logging, 'Esc' and 'Y' - exit
+# shellcheck disable=SC2086
+{
+    for i in $(seq 8); do
+        printf " "
+        sleep 0.3
+    done
+
+    printf "F0\n"
+    sleep 0.3
+    printf " "
+    sleep 0.3
+    printf "\033Y"
+} | "$rtegetdata" $target -p -incremental -bin="$data_file" "$@" > "$output" 2>&1 \
+    || fail "RTEgetData returned an error (persistent mode)"
+
+[ "$(grep -c "Incremental transfer" "$output")" -ge 7 ] || fail "the transfers were not incremental"
+cp "$data_file" "$incremental_file"
+
+# shellcheck disable=SC2086
+"$rtegetdata" $target -bin="$data_file" -filter=0 "$@" > "$output" 2>&1 \
+    || fail "RTEgetData returned an error (complete transfer)"
+cmp "$incremental_file" "$data_file" || fail "the incremental transfer differs from the complete transfer"
+
+stop_simulator
+echo "PASSED"
+exit 0
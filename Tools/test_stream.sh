@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+# Copyright (c) Branko Premzel.
+#
+# SPDX-License-Identifier: MIT
+#
+# Automated streaming test with the simulators (started by ctest).
+#
+# Usage: test_stream.sh gdb|com simulator RTEgetData work_dir "simulator options" [RTEgetData options]
+# (see test_common.sh)
+#
+# The simulated firmware must log data (-rate) and the circular buffer must be large enough
+# that it does not wrap around during the test. The data is streamed for one second. The
+# stream file must not contain gap records and the data records must be identical to the
+# part of the circular buffer from the index at the start of streaming (read afterwards
+# with a complete transfer).
+
+. "$(dirname "$0")/test_common.sh"
+start_simulator
+
+stream_file="$work_dir/stream.bin"
+streamed_words="$work_dir/streamed.txt"
+output="$work_dir/output.txt"
+data_tag=1096040772      # STREAM_DATA_TAG
+rm -f "$stream_file" "$streamed_words" "$output"
+
+# Stream until a key is pressed
+# shellcheck disable=SC2086
+{
+    sleep 1
+    printf " "
+} | "$rtegetdata" $target -stream -bin="$stream_file" "$@" > "$output" 2>&1 \
+    || fail "RTEgetData returned an error (streaming)"
+
+# Data words of the stream records - the records must be data records
+start_index=$(file_words "$stream_file" 0 | head -n 1)
+file_words "$stream_file" 6 | awk -v data_tag=$data_tag '
+    BEGIN             { expect = "tag" }
+    expect == "tag"   { if ($1 != data_tag) exit 1; expect = "count"; next }
+    expect == "count" { count = $1; expect = (count > 0) ? "data" : "tag"; next }
+                      { print; if (--count == 0) expect = "tag" }
+    ' > "$streamed_words" || fail "the stream file contains a gap record or is damaged"
+
+streamed=$(wc -l < "$streamed_words")
+[ "$streamed" -ge 1000 ] || fail "only $streamed words streamed"
+
+# shellcheck disable=SC2086
+"$rtegetdata" $target -bin="$data_file" -filter=0 "$@" > "$output" 2>&1 \
+    || fail "RTEgetData returned an error (complete transfer)"
+file_words "$data_file" $((header_size / 4 + start_index)) | head -n "$streamed" | cmp - "$streamed_words" \
+    || fail "the streamed data differs from the circular buffer contents"
+
+stop_simulator
+echo "PASSED"
+exit 0
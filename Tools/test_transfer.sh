@@ -0,0 +1,44 @@
+#!/bin/sh
+#
+# Copyright (c) Branko Premzel.
+#
+# SPDX-License-Identifier: MIT
+#
+# Automated data transfer test with the simulators (started by ctest).
+#
+# Usage: test_transfer.sh gdb|com simulator RTEgetData work_dir "simulator options" [RTEgetData options]
+# (see test_common.sh)
+#
+# The simulated buffer contents are static. RTEgetData reads the g_rtedbg structure and the
+# data file must be identical to the initial simulated image (-image). With the -clear
+# option a second transfer must find an empty circular buffer.
+
+. "$(dirname "$0")/test_common.sh"
+start_simulator
+
+# Remove -clear from the RTEgetData options - they are used for the second transfer too.
+clear_option=""
+for option in "$@"; do
+    shift
+    if [ "$option" = "-clear" ]; then
+        clear_option="-clear"
+    else
+        set -- "$@" "$option"
+    fi
+done
+
+# shellcheck disable=SC2086
+"$rtegetdata" $target -bin="$data_file" $clear_option "$@" || fail "RTEgetData returned an error"
+cmp "$image_file" "$data_file" || fail "the data file differs from the simulated image"
+
+if [ -n "$clear_option" ]; then
+    rm -f "$data_file"
+    # shellcheck disable=SC2086
+    "$rtegetdata" $target -bin="$data_file" "$@" || fail "RTEgetData returned an error (second transfer)"
+    remaining=$(tail -c +$((header_size + 1)) "$data_file" | LC_ALL=C tr -d '\377' | wc -c)
+    [ "$remaining" -eq 0 ] || fail "the circular buffer has not been cleared"
+fi
+
+stop_simulator
+echo "PASSED"
+exit 0